@@ -0,0 +1,370 @@
+// End-to-end stress and correctness harness for the ingest path.
+//
+// Generates a deterministic multi-market feed with FeedSimulator (Zipfian
+// market popularity, bursts, injected drops/duplicates/reorders), then
+// drives it through the JSON decoder and the BookRegistry three ways:
+//
+//   inline     decode + dispatch on one thread, with per-stage latency
+//   pipelined  decode on this thread, apply on a BookWorker over its ring
+//   sharded    decode + route on this thread into 1..N ShardedRegistry
+//              shards (the core scaling curve)
+//
+// After each run every book is compared level by level against the
+// simulator's std::map reference books; any mismatch fails the run.
+//
+// Usage: feed_stress [messages] [markets] [max_shards] [damage_rate]
+
+#include <algorithm>  // for std::min, std::max
+#include <chrono>     // for std::chrono::steady_clock
+#include <cstdint>    // for uint64_t
+#include <cstdio>     // for std::printf
+#include <cstdlib>    // for std::strtoull, std::strtod
+#include <thread>     // for std::thread::hardware_concurrency, yield
+#include <vector>     // for std::vector
+
+#include "book_registry.h"
+#include "book_worker.h"
+#include "feed_simulator.h"
+#include "latency_stats.h"
+#include "message_arena.h"
+#include "message_decoder.h"
+#include "sharded_registry.h"
+
+namespace {
+
+// =============================================================================
+// Feed
+// =============================================================================
+
+struct Feed
+{
+  std::vector<char> text;
+  std::vector<FeedPayload> payloads;
+};
+
+/**
+ * @brief Producer-side decode state. Slots carry snapshots as compact
+ *        encodings, which live in the arena; it is never advanced here, so
+ *        every encoding outlives the run (snapshots are a small share of
+ *        the feed).
+ */
+struct Decoder
+{
+  SnapshotMessage snapshot;
+  MessageArena arena;
+};
+
+/**
+ * @brief Decodes payload @p i into @p slot (unresolved market).
+ */
+inline bool DecodeInto(const Feed &feed, size_t i, Decoder *decoder,
+                       MessageSlot *slot)
+{
+  const FeedPayload &payload = feed.payloads[i];
+  slot->type = DecodeMessage(feed.text.data() + payload.offset,
+                             payload.length, &decoder->snapshot, &slot->delta,
+                             &slot->trade);
+  slot->market_id = MessageSlot::kUnresolvedMarketId;
+  if (slot->type == MessageType::kSnapshot) {
+    return decoder->arena.EncodeSnapshot(decoder->snapshot, slot);
+  }
+  return slot->type != MessageType::kUnknown;
+}
+
+// =============================================================================
+// Reporting
+// =============================================================================
+
+double Seconds(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+/**
+ * @brief Value at quantile @p q, in ns (upper bound of its bucket).
+ */
+double PercentileNs(const LatencyStats::OpHistogram &histogram, double q,
+                    double ticks_per_ns)
+{
+  const uint64_t rank = static_cast<uint64_t>(
+      q * static_cast<double>(histogram.count()));
+  uint64_t seen = 0U;
+  for (unsigned int b = 0; b < LatencyStats::OpHistogram::kBuckets; ++b) {
+    seen += histogram.bucket(b);
+    if (seen > rank) {
+      return static_cast<double>(
+                 LatencyStats::OpHistogram::BucketUpperBound(b)) /
+             ticks_per_ns;
+    }
+  }
+  return static_cast<double>(histogram.max()) / ticks_per_ns;
+}
+
+void ReportLatency(const char *stage, const LatencyStats::OpHistogram &h,
+                   double ticks_per_ns)
+{
+  if (h.count() == 0U) return;
+  std::printf("  %-18s %10llu %8.1f %8.1f %8.1f %9.1f\n", stage,
+              static_cast<unsigned long long>(h.count()),
+              static_cast<double>(h.sum()) /
+                  static_cast<double>(h.count()) / ticks_per_ns,
+              PercentileNs(h, 0.50, ticks_per_ns),
+              PercentileNs(h, 0.99, ticks_per_ns),
+              PercentileNs(h, 0.999, ticks_per_ns));
+}
+
+// =============================================================================
+// Oracle
+// =============================================================================
+
+/**
+ * @brief Compares every market's book with its reference.
+ *
+ * @param find_book Returns the book for a simulator market, or nullptr.
+ * @return True if every book exists, is in sync and matches exactly.
+ */
+template <typename FindBook>
+bool CheckAgainstReference(const char *run, const FeedSimulator &sim,
+                           FindBook &&find_book)
+{
+  size_t missing = 0U;
+  size_t stale = 0U;
+  size_t bad_levels = 0U;
+  size_t bad_markets = 0U;
+  for (size_t market = 0; market < sim.market_count(); ++market) {
+    const ReferenceBook &reference = sim.reference(market);
+    const OrderBook *book = find_book(market);
+    if (book == nullptr) {
+      // Markets never picked have no payloads and no book.
+      missing += reference.yes.empty() && reference.no.empty() ? 0U : 1U;
+      continue;
+    }
+    stale += book->IsStale() ? 1U : 0U;
+    size_t bad = 0U;
+    for (Side side : {Side::kYes, Side::kNo}) {
+      uint64_t total = 0U;
+      for (unsigned int price = 0; price < OrderBook::kArraySize; ++price) {
+        const uint64_t expected = reference.QtyAt(side, price);
+        bad += book->QtyAt(side, price) == expected ? 0U : 1U;
+        total += expected;
+      }
+      bad += book->TotalQty(side) == total ? 0U : 1U;
+    }
+    const OrderBook::Level best = book->BestBid();
+    const unsigned int expected_best =
+        reference.yes.empty() ? 0U : reference.yes.rbegin()->first;
+    bad += best.first == expected_best ? 0U : 1U;
+    bad_levels += bad;
+    bad_markets += bad != 0U ? 1U : 0U;
+  }
+  const bool ok = missing == 0U && stale == 0U && bad_levels == 0U;
+  std::printf("  oracle[%s]: %s (%zu missing, %zu stale, %zu markets / %zu "
+              "levels differ)\n",
+              run, ok ? "ok" : "MISMATCH", missing, stale, bad_markets,
+              bad_levels);
+  return ok;
+}
+
+// =============================================================================
+// Runs
+// =============================================================================
+
+/**
+ * @brief Decode and dispatch on this thread; times each stage per message.
+ */
+bool RunInline(const Feed &feed, const FeedSimulator &sim)
+{
+  BookRegistry registry(sim.market_count());
+  LatencyStats::OpHistogram decode_latency;
+  LatencyStats::OpHistogram apply_latency[4];
+  Decoder decoder;
+  MessageSlot slot;
+  size_t failed = 0U;
+
+  // Untimed pass for throughput, then a timed pass on a fresh registry.
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < feed.payloads.size(); ++i) {
+    if (!DecodeInto(feed, i, &decoder, &slot)) {
+      ++failed;
+      continue;
+    }
+    BookWorker::Dispatch(&registry, slot);
+  }
+  const double seconds = Seconds(start);
+
+  BookRegistry timed(sim.market_count());
+  for (size_t i = 0; i < feed.payloads.size(); ++i) {
+    const uint64_t t0 = LatencyClock::Now();
+    const bool decoded = DecodeInto(feed, i, &decoder, &slot);
+    const uint64_t t1 = LatencyClock::Now();
+    if (!decoded) continue;
+    BookWorker::Dispatch(&timed, slot);
+    const uint64_t t2 = LatencyClock::Now();
+    decode_latency.Record(t1 - t0);
+    apply_latency[static_cast<unsigned int>(slot.type)].Record(t2 - t1);
+  }
+
+  std::printf("inline:    %10.2f Mmsg/s (%zu undecodable)\n",
+              static_cast<double>(feed.payloads.size()) / seconds / 1e6,
+              failed);
+  std::printf("  %-18s %10s %8s %8s %8s %9s\n", "stage (ns)", "count", "mean",
+              "p50", "p99", "p99.9");
+  const double ticks_per_ns = LatencyStats::TicksPerNanosecond();
+  ReportLatency("decode", decode_latency, ticks_per_ns);
+  ReportLatency("apply snapshot",
+                apply_latency[static_cast<unsigned int>(MessageType::kSnapshot)],
+                ticks_per_ns);
+  ReportLatency("apply delta",
+                apply_latency[static_cast<unsigned int>(MessageType::kDelta)],
+                ticks_per_ns);
+  ReportLatency("apply trade",
+                apply_latency[static_cast<unsigned int>(MessageType::kTrade)],
+                ticks_per_ns);
+
+  auto find = [](const BookRegistry &r, const FeedSimulator &s, size_t m) {
+    const BookRegistry::MarketId id =
+        r.FindByTicker(s.ticker(m), FeedSimulator::kTickerLen);
+    return id == BookRegistry::kInvalidMarketId ? nullptr : &r.book(id);
+  };
+  const bool ok = failed == 0U;
+  return CheckAgainstReference("inline", sim,
+                               [&](size_t m) { return find(registry, sim, m); }) &
+         CheckAgainstReference("inline timed", sim,
+                               [&](size_t m) { return find(timed, sim, m); }) &
+         ok;
+}
+
+/**
+ * @brief Decodes straight into BookWorker ring slots; the worker applies.
+ */
+bool RunPipelined(const Feed &feed, const FeedSimulator &sim)
+{
+  BookRegistry registry(sim.market_count());
+  BookWorker::Options options;
+  options.wait_policy = BookWorker::WaitPolicy::kFutexWait;
+  options.ring_capacity = 4096U;
+  BookWorker worker(&registry, options);
+  worker.Start();
+
+  const auto start = std::chrono::steady_clock::now();
+  uint64_t full_spins = 0U;
+  Decoder decoder;
+  for (size_t i = 0; i < feed.payloads.size(); ++i) {
+    MessageSlot *slot;
+    while ((slot = worker.BeginWrite()) == nullptr) {
+      ++full_spins;
+      std::this_thread::yield();
+    }
+    DecodeInto(feed, i, &decoder, slot);
+    worker.CommitWrite();
+  }
+  worker.Stop();
+  const double seconds = Seconds(start);
+
+  std::printf("pipelined: %10.2f Mmsg/s (%llu ring-full waits, %llu "
+              "unresolved)\n",
+              static_cast<double>(feed.payloads.size()) / seconds / 1e6,
+              static_cast<unsigned long long>(full_spins),
+              static_cast<unsigned long long>(worker.unresolved()));
+  return CheckAgainstReference("pipelined", sim, [&](size_t m) {
+    const BookRegistry::MarketId id =
+        registry.FindByTicker(sim.ticker(m), FeedSimulator::kTickerLen);
+    return id == BookRegistry::kInvalidMarketId ? nullptr
+                                                : &registry.book(id);
+  });
+}
+
+/**
+ * @brief One point of the scaling curve: route into @p shards shards.
+ */
+bool RunSharded(const Feed &feed, const FeedSimulator &sim,
+                unsigned int shards)
+{
+  ShardedRegistry::Options options;
+  options.shard_count = shards;
+  options.markets_per_shard = sim.market_count();
+  options.ring_capacity = 4096U;
+  ShardedRegistry sharded(sim.market_count(), options);
+  sharded.Start();
+
+  const auto start = std::chrono::steady_clock::now();
+  Decoder decoder;
+  MessageSlot slot;
+  for (size_t i = 0; i < feed.payloads.size(); ++i) {
+    DecodeInto(feed, i, &decoder, &slot);
+    slot.market_id = feed.payloads[i].market;
+    while (!sharded.Push(slot)) {
+      std::this_thread::yield();
+    }
+  }
+  sharded.Stop();
+  std::printf("  x%-2u %10.2f Mmsg/s\n", shards,
+              static_cast<double>(feed.payloads.size()) / Seconds(start) / 1e6);
+
+  char run[32];
+  std::snprintf(run, sizeof(run), "sharded x%u", shards);
+  return CheckAgainstReference(run, sim, [&](size_t m) {
+    return sharded.FindBook(static_cast<ShardedRegistry::MarketId>(m));
+  });
+}
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+  const size_t messages =
+      argc > 1 ? static_cast<size_t>(std::strtoull(argv[1], nullptr, 10))
+               : 1000000U;
+  const size_t markets =
+      argc > 2 ? static_cast<size_t>(std::strtoull(argv[2], nullptr, 10))
+               : 2000U;
+  const unsigned int cores = std::max(1U, std::thread::hardware_concurrency());
+  const unsigned int max_shards =
+      argc > 3 ? static_cast<unsigned int>(std::strtoull(argv[3], nullptr, 10))
+               : std::max(1U, std::min(8U, cores - 1U));
+  const double damage = argc > 4 ? std::strtod(argv[4], nullptr) : 0.001;
+
+  FeedSimulator::Options options;
+  options.seed = 42U;
+  options.market_count = markets;
+  options.drop_probability = damage;
+  options.duplicate_probability = damage;
+  options.reorder_probability = damage;
+  FeedSimulator sim(options);
+
+  Feed feed;
+  feed.text.reserve(messages * 128U);
+  feed.payloads.reserve(messages + markets);
+  const auto generate_start = std::chrono::steady_clock::now();
+  sim.Generate(messages, &feed.text, &feed.payloads);
+  sim.Finish(&feed.text, &feed.payloads);
+  const double generate_seconds = Seconds(generate_start);
+
+  const FeedSimulator::Stats &stats = sim.stats();
+  std::printf("feed: %zu payloads (%.1f MB) over %zu markets, generated at "
+              "%.2f Mmsg/s\n",
+              feed.payloads.size(),
+              static_cast<double>(feed.text.size()) / 1e6, sim.market_count(),
+              static_cast<double>(feed.payloads.size()) / generate_seconds /
+                  1e6);
+  std::printf("      %llu snapshots, %llu deltas, %llu trades; injected %llu "
+              "drops, %llu duplicates, %llu reorders (%llu resyncs)\n\n",
+              static_cast<unsigned long long>(stats.snapshots),
+              static_cast<unsigned long long>(stats.deltas),
+              static_cast<unsigned long long>(stats.trades),
+              static_cast<unsigned long long>(stats.dropped),
+              static_cast<unsigned long long>(stats.duplicated),
+              static_cast<unsigned long long>(stats.reordered),
+              static_cast<unsigned long long>(stats.resyncs));
+
+  bool ok = RunInline(feed, sim);
+  ok &= RunPipelined(feed, sim);
+
+  std::printf("sharded (%u cores):\n", cores);
+  for (unsigned int shards = 1; shards <= max_shards; ++shards) {
+    ok &= RunSharded(feed, sim, shards);
+  }
+  return ok ? 0 : 1;
+}
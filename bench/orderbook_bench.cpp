@@ -0,0 +1,503 @@
+// Microbenchmarks for the OrderBook hot paths.
+//
+// Replays deterministic synthetic feeds shaped like prediction-market
+// traffic (deltas clustered near the touch, bursty trades, periodic
+// snapshots) over sparse and dense books, and reports per-operation
+// throughput and p50/p99/p99.9 latency.
+//
+// Usage: orderbook_bench [messages_per_scenario]
+
+#include <algorithm>  // for std::sort, std::min
+#include <chrono>     // for std::chrono::steady_clock
+#include <cstdint>    // for uint64_t
+#include <cstdio>     // for std::printf
+#include <cstdlib>    // for std::strtoull
+#include <vector>     // for std::vector
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>  // for __rdtsc, _mm_lfence
+#endif
+
+#include "orderbook.h"
+
+namespace {
+
+// =============================================================================
+// Timing
+// =============================================================================
+
+/**
+ * @brief Low-overhead timestamp source: serialized rdtsc on x86, the steady
+ *        clock elsewhere. Ticks are converted to ns after calibration.
+ */
+class TickClock
+{
+public:
+  static uint64_t Now()
+  {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_lfence();
+    const uint64_t ticks = __rdtsc();
+    _mm_lfence();
+    return ticks;
+#else
+    return static_cast<uint64_t>(
+        std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+  }
+
+  /// Measures ns per tick and the cost of an empty Now()/Now() pair.
+  void Calibrate()
+  {
+    const auto wall_start = std::chrono::steady_clock::now();
+    const uint64_t tick_start = Now();
+    while (std::chrono::steady_clock::now() - wall_start <
+           std::chrono::milliseconds(50)) {
+    }
+    const uint64_t tick_end = Now();
+    const auto wall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                             std::chrono::steady_clock::now() - wall_start)
+                             .count();
+    ns_per_tick_ = static_cast<double>(wall_ns) /
+                   static_cast<double>(tick_end - tick_start);
+
+    overhead_ticks_ = UINT64_MAX;
+    for (int i = 0; i < 10000; ++i) {
+      const uint64_t a = Now();
+      const uint64_t b = Now();
+      overhead_ticks_ = std::min(overhead_ticks_, b - a);
+    }
+  }
+
+  double ns_per_tick() const { return ns_per_tick_; }
+  uint64_t overhead_ticks() const { return overhead_ticks_; }
+
+private:
+  double ns_per_tick_ = 1.0;
+  uint64_t overhead_ticks_ = 0;
+};
+
+/// Keeps the compiler from discarding a computed value.
+template <typename T>
+inline void DoNotOptimize(const T &value)
+{
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// =============================================================================
+// Statistics
+// =============================================================================
+
+/**
+ * @brief Latency samples (in ticks) for one operation.
+ */
+class LatencyRecorder
+{
+public:
+  explicit LatencyRecorder(const char *name) : name_(name) {}
+
+  void Reserve(size_t n) { samples_.reserve(n); }
+  void Add(uint64_t ticks) { samples_.push_back(ticks); }
+
+  void Report(const char *scenario, const TickClock &clock)
+  {
+    if (samples_.empty()) {
+      return;
+    }
+    std::sort(samples_.begin(), samples_.end());
+    const uint64_t overhead = clock.overhead_ticks();
+    double total_ns = 0.0;
+    for (uint64_t s : samples_) {
+      total_ns += static_cast<double>(s > overhead ? s - overhead : 0U) *
+                  clock.ns_per_tick();
+    }
+    const double mean_ns = total_ns / static_cast<double>(samples_.size());
+    std::printf("%-8s %-22s %10zu %10.2f %8.1f %8.1f %8.1f %9.1f\n", scenario,
+                name_, samples_.size(),
+                mean_ns > 0.0 ? 1e3 / mean_ns : 0.0, mean_ns,
+                Percentile(0.50, clock), Percentile(0.99, clock),
+                Percentile(0.999, clock));
+  }
+
+private:
+  double Percentile(double q, const TickClock &clock) const
+  {
+    const size_t index = std::min(
+        samples_.size() - 1U,
+        static_cast<size_t>(q * static_cast<double>(samples_.size())));
+    const uint64_t s = samples_[index];
+    const uint64_t overhead = clock.overhead_ticks();
+    return static_cast<double>(s > overhead ? s - overhead : 0U) *
+           clock.ns_per_tick();
+  }
+
+  const char *name_;
+  std::vector<uint64_t> samples_;
+};
+
+// =============================================================================
+// Synthetic feed
+// =============================================================================
+
+/**
+ * @brief xorshift64* generator; deterministic across platforms.
+ */
+class Rng
+{
+public:
+  explicit Rng(uint64_t seed) : state_(seed ? seed : 1U) {}
+
+  uint64_t Next()
+  {
+    state_ ^= state_ >> 12U;
+    state_ ^= state_ << 25U;
+    state_ ^= state_ >> 27U;
+    return state_ * 2685821657736338717ULL;
+  }
+
+  /// Uniform in [0, n).
+  unsigned int Uniform(unsigned int n)
+  {
+    return static_cast<unsigned int>(Next() % n);
+  }
+
+  /// True with probability p.
+  bool Chance(double p)
+  {
+    return static_cast<double>(Next() >> 11U) * (1.0 / 9007199254740992.0) < p;
+  }
+
+  /// Geometric distance >= 0 with continuation probability p.
+  unsigned int Geometric(double p, unsigned int cap)
+  {
+    unsigned int k = 0U;
+    while (k < cap && Chance(p)) {
+      ++k;
+    }
+    return k;
+  }
+
+private:
+  uint64_t state_;
+};
+
+struct Scenario
+{
+  const char *name;
+  /// Levels kept populated behind each touch.
+  unsigned int depth;
+  /// Probability that a delta lands one more tick away from the touch.
+  double touch_decay;
+  /// Probability that a message starts a trade burst.
+  double trade_burst_prob;
+  unsigned int max_burst_len;
+  /// A snapshot is emitted after this many messages.
+  unsigned int snapshot_every;
+};
+
+struct Feed
+{
+  std::vector<MessageType> order;
+  std::vector<DeltaMessage> deltas;
+  std::vector<TradeMessage> trades;
+  std::vector<SnapshotMessage> snapshots;
+};
+
+/**
+ * @brief Generates a valid message stream by evolving a shadow book, so
+ *        negative deltas and trades never exceed resting quantity.
+ *
+ * Bids rest at and below bid_touch, asks at and above bid_touch + spread;
+ * the touch drifts slowly. Deltas and trades carry consecutive sequence
+ * numbers; snapshots reuse the last one so the book stays in sync.
+ */
+Feed GenerateFeed(const Scenario &scenario, size_t messages, uint64_t seed)
+{
+  Rng rng(seed);
+  Feed feed;
+  feed.order.reserve(messages);
+  feed.deltas.reserve(messages);
+  feed.trades.reserve(messages / 4U);
+  feed.snapshots.reserve(messages / scenario.snapshot_every + 2U);
+
+  unsigned int bids[OrderBook::kArraySize] = {};
+  unsigned int asks[OrderBook::kArraySize] = {};
+  unsigned int bid_touch = 45U;
+  const unsigned int spread = 2U;
+  uint64_t seq = 1U;
+
+  auto seed_levels = [&] {
+    for (unsigned int i = 0; i < scenario.depth; ++i) {
+      if (bid_touch >= i) bids[bid_touch - i] = 50U + rng.Uniform(500U);
+      const unsigned int ask = bid_touch + spread + i;
+      if (ask < OrderBook::kArraySize) asks[ask] = 50U + rng.Uniform(500U);
+    }
+  };
+
+  auto emit_snapshot = [&] {
+    SnapshotMessage snap{};
+    for (unsigned int p = 0; p < OrderBook::kArraySize; ++p) {
+      if (bids[p] != 0U) {
+        snap.yes_price[snap.yes_count] = p;
+        snap.yes_qty[snap.yes_count++] = bids[p];
+      }
+      if (asks[p] != 0U) {
+        snap.no_price[snap.no_count] = p;
+        snap.no_qty[snap.no_count++] = asks[p];
+      }
+    }
+    snap.seq = seq - 1U;
+    feed.snapshots.push_back(snap);
+    feed.order.push_back(MessageType::kSnapshot);
+  };
+
+  seed_levels();
+  emit_snapshot();
+
+  unsigned int burst_remaining = 0U;
+  while (feed.order.size() < messages) {
+    if (feed.order.size() % scenario.snapshot_every == 0U) {
+      emit_snapshot();
+      continue;
+    }
+
+    if (burst_remaining == 0U && rng.Chance(scenario.trade_burst_prob)) {
+      burst_remaining = 1U + rng.Uniform(scenario.max_burst_len);
+    }
+
+    const bool buy_side = rng.Chance(0.5);
+    if (burst_remaining > 0U) {
+      --burst_remaining;
+      // Take liquidity at the touch of one side.
+      unsigned int *levels = buy_side ? asks : bids;
+      int best = -1;
+      if (buy_side) {
+        for (unsigned int p = 0; p < OrderBook::kArraySize; ++p) {
+          if (levels[p] != 0U) { best = static_cast<int>(p); break; }
+        }
+      } else {
+        for (int p = OrderBook::kArraySize - 1; p >= 0; --p) {
+          if (levels[p] != 0U) { best = p; break; }
+        }
+      }
+      if (best >= 0) {
+        const unsigned int take =
+            std::min(levels[best], 1U + rng.Uniform(100U));
+        levels[best] -= take;
+        TradeMessage trade{};
+        trade.count = static_cast<int>(take);
+        trade.taker_side = buy_side ? Side::kYes : Side::kNo;
+        trade.no_price = static_cast<unsigned int>(best);
+        trade.yes_price = static_cast<unsigned int>(best);
+        feed.trades.push_back(trade);
+        feed.order.push_back(MessageType::kTrade);
+        continue;
+      }
+    }
+
+    // Delta clustered near the touch.
+    const unsigned int distance =
+        rng.Geometric(scenario.touch_decay, scenario.depth + 4U);
+    unsigned int price;
+    if (buy_side) {
+      price = bid_touch >= distance ? bid_touch - distance : 0U;
+    } else {
+      price = std::min(bid_touch + spread + distance,
+                       OrderBook::kArraySize - 1U);
+    }
+    unsigned int *levels = buy_side ? bids : asks;
+    int delta;
+    if (levels[price] != 0U && rng.Chance(0.45)) {
+      delta = -static_cast<int>(
+          std::min(levels[price], 1U + rng.Uniform(levels[price])));
+    } else {
+      delta = static_cast<int>(1U + rng.Uniform(200U));
+    }
+    levels[price] = static_cast<unsigned int>(
+        static_cast<int>(levels[price]) + delta);
+
+    DeltaMessage msg{};
+    msg.price = price;
+    msg.delta = delta;
+    msg.side = buy_side ? Side::kYes : Side::kNo;
+    msg.seq = seq++;
+    feed.deltas.push_back(msg);
+    feed.order.push_back(MessageType::kDelta);
+
+    // Occasional drift of the touch (keeps both sides in range).
+    if (rng.Chance(0.001)) {
+      bid_touch = std::clamp(bid_touch + (rng.Chance(0.5) ? 1U : -1U),
+                             scenario.depth + 1U,
+                             OrderBook::kArraySize - scenario.depth - spread -
+                                 2U);
+    }
+  }
+  return feed;
+}
+
+// =============================================================================
+// Runs
+// =============================================================================
+
+/**
+ * @brief Replays the feed with every message timed, plus the read paths
+ *        timed after each message.
+ */
+void RunLatency(const Scenario &scenario, const Feed &feed,
+                const TickClock &clock)
+{
+  LatencyRecorder apply_delta("ApplyDelta");
+  LatencyRecorder apply_trade("ApplyTrade");
+  LatencyRecorder apply_snapshot("ApplySnapshot");
+  LatencyRecorder best_bid("BestBid");
+  LatencyRecorder best_ask("BestAsk");
+  LatencyRecorder top5("GetTopNBids<5>");
+  LatencyRecorder top10_span("GetTopNAsks(span[10])");
+  LatencyRecorder cost_to_fill("CostToFill(100)");
+  apply_delta.Reserve(feed.deltas.size());
+  apply_trade.Reserve(feed.trades.size());
+  apply_snapshot.Reserve(feed.snapshots.size());
+  for (LatencyRecorder *r :
+       {&best_bid, &best_ask, &top5, &top10_span, &cost_to_fill}) {
+    r->Reserve(feed.order.size());
+  }
+
+  static OrderBook book;
+  book = OrderBook();
+  OrderBook::Level levels[10];
+  size_t d = 0, t = 0, s = 0;
+
+  for (MessageType type : feed.order) {
+    uint64_t start;
+    switch (type) {
+      case MessageType::kDelta:
+        start = TickClock::Now();
+        book.ApplyDelta(&feed.deltas[d++]);
+        apply_delta.Add(TickClock::Now() - start);
+        break;
+      case MessageType::kTrade:
+        start = TickClock::Now();
+        book.ApplyTrade(&feed.trades[t++]);
+        apply_trade.Add(TickClock::Now() - start);
+        break;
+      default:
+        start = TickClock::Now();
+        book.ApplySnapshot(&feed.snapshots[s++]);
+        apply_snapshot.Add(TickClock::Now() - start);
+        break;
+    }
+
+    start = TickClock::Now();
+    DoNotOptimize(book.BestBid());
+    best_bid.Add(TickClock::Now() - start);
+
+    start = TickClock::Now();
+    DoNotOptimize(book.BestAsk());
+    best_ask.Add(TickClock::Now() - start);
+
+    start = TickClock::Now();
+    const auto top = book.GetTopNBids<5>();
+    DoNotOptimize(top);
+    top5.Add(TickClock::Now() - start);
+
+    start = TickClock::Now();
+    DoNotOptimize(book.GetTopNAsks(std::span<OrderBook::Level>(levels)));
+    top10_span.Add(TickClock::Now() - start);
+
+    start = TickClock::Now();
+    DoNotOptimize(book.CostToFill(Side::kNo, 100U));
+    cost_to_fill.Add(TickClock::Now() - start);
+  }
+
+  for (LatencyRecorder *r : {&apply_delta, &apply_trade, &apply_snapshot,
+                             &best_bid, &best_ask, &top5, &top10_span,
+                             &cost_to_fill}) {
+    r->Report(scenario.name, clock);
+  }
+}
+
+/**
+ * @brief Times ApplyDeltas over consecutive runs of @p batch deltas.
+ *        Reported latency is per batch.
+ */
+void RunBatchLatency(const Scenario &scenario, const Feed &feed,
+                     const TickClock &clock, size_t batch, const char *name)
+{
+  LatencyRecorder recorder(name);
+  recorder.Reserve(feed.deltas.size() / batch + 1U);
+
+  static OrderBook book;
+  book = OrderBook();
+  book.ApplySnapshot(&feed.snapshots[0]);
+
+  const std::span<const DeltaMessage> all(feed.deltas);
+  for (size_t i = 0; i + batch <= all.size(); i += batch) {
+    const uint64_t start = TickClock::Now();
+    book.ApplyDeltas(all.subspan(i, batch));
+    recorder.Add(TickClock::Now() - start);
+  }
+  recorder.Report(scenario.name, clock);
+}
+
+/**
+ * @brief Untimed replay of the whole stream for sustained throughput.
+ */
+void RunThroughput(const Scenario &scenario, const Feed &feed)
+{
+  static OrderBook book;
+  book = OrderBook();
+  const auto start = std::chrono::steady_clock::now();
+  size_t d = 0, t = 0, s = 0;
+  for (MessageType type : feed.order) {
+    switch (type) {
+      case MessageType::kDelta:
+        book.ApplyDelta(&feed.deltas[d++]);
+        break;
+      case MessageType::kTrade:
+        book.ApplyTrade(&feed.trades[t++]);
+        break;
+      default:
+        book.ApplySnapshot(&feed.snapshots[s++]);
+        break;
+    }
+    DoNotOptimize(book.BestBid());
+  }
+  const double seconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+  std::printf("%-8s %-22s %10zu %10.2f   (sustained, mixed stream)\n",
+              scenario.name, "feed replay", feed.order.size(),
+              static_cast<double>(feed.order.size()) / seconds / 1e6);
+}
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+  const size_t messages =
+      argc > 1 ? static_cast<size_t>(std::strtoull(argv[1], nullptr, 10))
+               : 500000U;
+
+  TickClock clock;
+  clock.Calibrate();
+  std::printf("clock: %.3f ns/tick, timer overhead %.1f ns (subtracted)\n\n",
+              clock.ns_per_tick(),
+              static_cast<double>(clock.overhead_ticks()) * clock.ns_per_tick());
+
+  const Scenario scenarios[] = {
+      // name, depth, touch_decay, burst_prob, max_burst, snapshot_every
+      {"sparse", 3U, 0.35, 0.02, 4U, 20000U},
+      {"dense", 40U, 0.75, 0.05, 12U, 5000U},
+  };
+
+  std::printf("%-8s %-22s %10s %10s %8s %8s %8s %9s\n", "scenario", "op",
+              "count", "Mops/s", "mean", "p50", "p99", "p99.9");
+  for (const Scenario &scenario : scenarios) {
+    const Feed feed = GenerateFeed(scenario, messages, 42U);
+    RunLatency(scenario, feed, clock);
+    RunBatchLatency(scenario, feed, clock, 16U, "ApplyDeltas(x16)");
+    RunThroughput(scenario, feed);
+    std::printf("\n");
+  }
+  return 0;
+}
@@ -0,0 +1,436 @@
+#ifndef PROJECT_BITSET_H_
+#define PROJECT_BITSET_H_
+
+#include <cstdint>      // for uint64_t
+#include <type_traits>  // for std::conditional_t
+
+// ---------------------------------------------------------------------------
+// Word helpers
+// ---------------------------------------------------------------------------
+
+/**
+ * @brief Index of the most significant set bit of a nonzero word.
+ */
+inline unsigned int HighestBit64(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+  return 63U - static_cast<unsigned int>(__builtin_clzll(word));
+#else
+  unsigned int pos = 63U;
+  while (((word >> pos) & 1ULL) == 0U) {
+    --pos;
+  }
+  return pos;
+#endif
+}
+
+/**
+ * @brief Index of the least significant set bit of a nonzero word.
+ */
+inline unsigned int LowestBit64(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+  return static_cast<unsigned int>(__builtin_ctzll(word));
+#else
+  unsigned int pos = 0U;
+  while (((word >> pos) & 1ULL) == 0U) {
+    ++pos;
+  }
+  return pos;
+#endif
+}
+
+/**
+ * @brief Number of set bits in a word.
+ */
+inline unsigned int PopCount64(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+  return static_cast<unsigned int>(__builtin_popcountll(word));
+#else
+  unsigned int count = 0U;
+  for (; word != 0U; word &= word - 1U) {
+    ++count;
+  }
+  return count;
+#endif
+}
+
+/**
+ * @brief Mask of bits [from, to] within one word (0 <= from <= to <= 63).
+ */
+inline uint64_t RangeMask64(unsigned int from, unsigned int to) {
+  const uint64_t upper =
+      to == 63U ? ~0ULL : ((static_cast<uint64_t>(1) << (to + 1U)) - 1U);
+  return upper & (~0ULL << from);
+}
+
+// ---------------------------------------------------------------------------
+// Price-level bitsets
+// ---------------------------------------------------------------------------
+//
+// All three bitsets share one interface so BasicOrderBook can pick the
+// cheapest one for its level count at compile time (see BitsetFor):
+//
+//   SetBit / ClearBit / TestBit / HighestSetBit / LowestSetBit / Clear
+//   AssignBit(pos, value)         branch-free set-or-clear; pos < kBits
+//   SetBitIf(pos, value)          branch-free set when value; pos < kBits
+//   Count()                       number of set bits
+//   Word(i) / SetWord(i, w)       raw 64-bit words (kWords of them)
+//   ForEachDescending(fn)         fn(pos) -> bool; false stops the walk
+//   ForEachAscending(fn)          likewise, lowest first
+//   ForEachInRange(lo, hi, fn)    fn(pos) for set bits in [lo, hi], ascending
+//
+// Out-of-range positions are ignored by SetBit/ClearBit/TestBit.
+
+/**
+ * @brief Single-word bitset for books of up to 64 levels.
+ */
+struct Bitset64
+{
+  static constexpr unsigned int kBits = 64U;
+  static constexpr unsigned int kWords = 1U;
+
+  uint64_t bits{0};
+
+  void SetBit(unsigned int pos) {
+    if (pos < kBits) bits |= static_cast<uint64_t>(1) << pos;
+  }
+  void ClearBit(unsigned int pos) {
+    if (pos < kBits) bits &= ~(static_cast<uint64_t>(1) << pos);
+  }
+  bool TestBit(unsigned int pos) const {
+    return pos < kBits && ((bits >> pos) & 1U) != 0U;
+  }
+  void AssignBit(unsigned int pos, bool value) {
+    const uint64_t mask = static_cast<uint64_t>(1) << pos;
+    bits = (bits & ~mask) | (-static_cast<uint64_t>(value) & mask);
+  }
+  void SetBitIf(unsigned int pos, bool value) {
+    bits |= static_cast<uint64_t>(value) << pos;
+  }
+  int HighestSetBit() const {
+    return bits != 0U ? static_cast<int>(HighestBit64(bits)) : -1;
+  }
+  int LowestSetBit() const {
+    return bits != 0U ? static_cast<int>(LowestBit64(bits)) : -1;
+  }
+  void Clear() { bits = 0U; }
+  unsigned int Count() const { return PopCount64(bits); }
+
+  uint64_t Word(unsigned int) const { return bits; }
+  void SetWord(unsigned int, uint64_t word) { bits = word; }
+
+  template <typename Fn>
+  void ForEachDescending(Fn &&fn) const {
+    for (uint64_t w = bits; w != 0U;) {
+      const unsigned int pos = HighestBit64(w);
+      w ^= static_cast<uint64_t>(1) << pos;
+      if (!fn(pos)) return;
+    }
+  }
+  template <typename Fn>
+  void ForEachAscending(Fn &&fn) const {
+    for (uint64_t w = bits; w != 0U; w &= w - 1U) {
+      if (!fn(LowestBit64(w))) return;
+    }
+  }
+  template <typename Fn>
+  void ForEachInRange(unsigned int lo, unsigned int hi, Fn &&fn) const {
+    if (lo > hi || lo >= kBits) return;
+    for (uint64_t w = bits & RangeMask64(lo, hi < 63U ? hi : 63U); w != 0U;
+         w &= w - 1U) {
+      fn(LowestBit64(w));
+    }
+  }
+};
+
+/**
+ * @brief 128-bit bitset split into two 64-bit words (words[0] holds bits
+ *        0-63). Used by the default 100-level book.
+ */
+struct Bitset128
+{
+  static constexpr unsigned int kBits = 128U;
+  static constexpr unsigned int kWords = 2U;
+
+  uint64_t words[2]{0, 0};
+
+  void SetBit(unsigned int pos);
+  void ClearBit(unsigned int pos);
+  bool TestBit(unsigned int pos) const;
+  void AssignBit(unsigned int pos, bool value);
+  void SetBitIf(unsigned int pos, bool value) {
+    words[pos >> 6U] |= static_cast<uint64_t>(value) << (pos & 63U);
+  }
+  int HighestSetBit() const;
+  int LowestSetBit() const;
+  void Clear() {
+    words[0] = 0U;
+    words[1] = 0U;
+  }
+  unsigned int Count() const {
+    return PopCount64(words[0]) + PopCount64(words[1]);
+  }
+
+  uint64_t Word(unsigned int i) const { return words[i]; }
+  void SetWord(unsigned int i, uint64_t word) { words[i] = word; }
+
+  /// Walks the high word then the low word, popping the top bit of each.
+  template <typename Fn>
+  void ForEachDescending(Fn &&fn) const {
+    for (uint64_t w = words[1]; w != 0U;) {
+      const unsigned int bit = HighestBit64(w);
+      w ^= static_cast<uint64_t>(1) << bit;
+      if (!fn(64U + bit)) return;
+    }
+    for (uint64_t w = words[0]; w != 0U;) {
+      const unsigned int bit = HighestBit64(w);
+      w ^= static_cast<uint64_t>(1) << bit;
+      if (!fn(bit)) return;
+    }
+  }
+  /// Walks the low word then the high word, popping with w &= w - 1.
+  template <typename Fn>
+  void ForEachAscending(Fn &&fn) const {
+    for (uint64_t w = words[0]; w != 0U; w &= w - 1U) {
+      if (!fn(LowestBit64(w))) return;
+    }
+    for (uint64_t w = words[1]; w != 0U; w &= w - 1U) {
+      if (!fn(64U + LowestBit64(w))) return;
+    }
+  }
+  template <typename Fn>
+  void ForEachInRange(unsigned int lo, unsigned int hi, Fn &&fn) const {
+    for (unsigned int w = 0; w < 2U; ++w) {
+      const unsigned int base = w * 64U;
+      if (hi < base || lo >= base + 64U) continue;
+      const unsigned int from = lo > base ? lo - base : 0U;
+      const unsigned int to = hi - base < 63U ? hi - base : 63U;
+      for (uint64_t bits = words[w] & RangeMask64(from, to); bits != 0U;
+           bits &= bits - 1U) {
+        fn(base + LowestBit64(bits));
+      }
+    }
+  }
+};
+
+/**
+ * @brief Two-level bitset for grids larger than 128 levels.
+ *
+ * A summary word array records which 64-bit leaf words are nonzero, so the
+ * best level is found with one scan of the (tiny) summary plus one BSR/BSF
+ * on a leaf: O(1) for up to 4096 levels. Like a van Emde Boas tree cut off
+ * after one level.
+ */
+template <unsigned int kBitCount>
+struct SummaryBitset
+{
+  static constexpr unsigned int kBits = kBitCount;
+  static constexpr unsigned int kWords = (kBitCount + 63U) / 64U;
+  static constexpr unsigned int kSummaryWords = (kWords + 63U) / 64U;
+
+  uint64_t words[kWords]{};
+  uint64_t summary[kSummaryWords]{};
+
+  void SetBit(unsigned int pos) {
+    if (pos >= kBits) return;
+    const unsigned int w = pos >> 6U;
+    words[w] |= static_cast<uint64_t>(1) << (pos & 63U);
+    summary[w >> 6U] |= static_cast<uint64_t>(1) << (w & 63U);
+  }
+  void ClearBit(unsigned int pos) {
+    if (pos >= kBits) return;
+    const unsigned int w = pos >> 6U;
+    words[w] &= ~(static_cast<uint64_t>(1) << (pos & 63U));
+    if (words[w] == 0U) {
+      summary[w >> 6U] &= ~(static_cast<uint64_t>(1) << (w & 63U));
+    }
+  }
+  bool TestBit(unsigned int pos) const {
+    return pos < kBits && ((words[pos >> 6U] >> (pos & 63U)) & 1U) != 0U;
+  }
+  /// Updates the leaf and then its summary bit, both without branching.
+  void AssignBit(unsigned int pos, bool value) {
+    const unsigned int w = pos >> 6U;
+    const uint64_t mask = static_cast<uint64_t>(1) << (pos & 63U);
+    words[w] = (words[w] & ~mask) | (-static_cast<uint64_t>(value) & mask);
+    uint64_t &sword = summary[w >> 6U];
+    const uint64_t smask = static_cast<uint64_t>(1) << (w & 63U);
+    sword = (sword & ~smask) | (-static_cast<uint64_t>(words[w] != 0U) & smask);
+  }
+  void SetBitIf(unsigned int pos, bool value) {
+    const unsigned int w = pos >> 6U;
+    words[w] |= static_cast<uint64_t>(value) << (pos & 63U);
+    summary[w >> 6U] |= static_cast<uint64_t>(words[w] != 0U) << (w & 63U);
+  }
+  int HighestSetBit() const {
+    for (unsigned int s = kSummaryWords; s-- > 0U;) {
+      if (summary[s] != 0U) {
+        const unsigned int w = s * 64U + HighestBit64(summary[s]);
+        return static_cast<int>(w * 64U + HighestBit64(words[w]));
+      }
+    }
+    return -1;
+  }
+  int LowestSetBit() const {
+    for (unsigned int s = 0; s < kSummaryWords; ++s) {
+      if (summary[s] != 0U) {
+        const unsigned int w = s * 64U + LowestBit64(summary[s]);
+        return static_cast<int>(w * 64U + LowestBit64(words[w]));
+      }
+    }
+    return -1;
+  }
+  void Clear() {
+    for (uint64_t &w : words) w = 0U;
+    for (uint64_t &s : summary) s = 0U;
+  }
+  unsigned int Count() const {
+    unsigned int count = 0U;
+    for (uint64_t w : words) count += PopCount64(w);
+    return count;
+  }
+
+  uint64_t Word(unsigned int i) const { return words[i]; }
+  void SetWord(unsigned int i, uint64_t word) {
+    words[i] = word;
+    const uint64_t bit = static_cast<uint64_t>(1) << (i & 63U);
+    if (word != 0U) {
+      summary[i >> 6U] |= bit;
+    } else {
+      summary[i >> 6U] &= ~bit;
+    }
+  }
+
+  /// Visits nonempty leaves only, highest first.
+  template <typename Fn>
+  void ForEachDescending(Fn &&fn) const {
+    for (unsigned int s = kSummaryWords; s-- > 0U;) {
+      for (uint64_t sw = summary[s]; sw != 0U;) {
+        const unsigned int sbit = HighestBit64(sw);
+        sw ^= static_cast<uint64_t>(1) << sbit;
+        const unsigned int w = s * 64U + sbit;
+        for (uint64_t bits = words[w]; bits != 0U;) {
+          const unsigned int bit = HighestBit64(bits);
+          bits ^= static_cast<uint64_t>(1) << bit;
+          if (!fn(w * 64U + bit)) return;
+        }
+      }
+    }
+  }
+  /// Visits nonempty leaves only, lowest first.
+  template <typename Fn>
+  void ForEachAscending(Fn &&fn) const {
+    for (unsigned int s = 0; s < kSummaryWords; ++s) {
+      for (uint64_t sw = summary[s]; sw != 0U; sw &= sw - 1U) {
+        const unsigned int w = s * 64U + LowestBit64(sw);
+        for (uint64_t bits = words[w]; bits != 0U; bits &= bits - 1U) {
+          if (!fn(w * 64U + LowestBit64(bits))) return;
+        }
+      }
+    }
+  }
+  template <typename Fn>
+  void ForEachInRange(unsigned int lo, unsigned int hi, Fn &&fn) const {
+    if (lo > hi || lo >= kBits) return;
+    if (hi >= kBits) hi = kBits - 1U;
+    for (unsigned int w = lo >> 6U; w <= (hi >> 6U); ++w) {
+      const unsigned int base = w * 64U;
+      const unsigned int from = lo > base ? lo - base : 0U;
+      const unsigned int to = hi - base < 63U ? hi - base : 63U;
+      for (uint64_t bits = words[w] & RangeMask64(from, to); bits != 0U;
+           bits &= bits - 1U) {
+        fn(base + LowestBit64(bits));
+      }
+    }
+  }
+};
+
+/**
+ * @brief Smallest bitset able to index @p kLevels price levels.
+ */
+template <unsigned int kLevels>
+using BitsetFor = std::conditional_t<
+    (kLevels <= 64U), Bitset64,
+    std::conditional_t<(kLevels <= 128U), Bitset128, SummaryBitset<kLevels>>>;
+
+// =============================================================================
+// Bitset128 Method Definitions
+// =============================================================================
+//
+// Positions index words[pos >> 6] directly, so none of these branch on which
+// half the bit lives in; the only branch is the out-of-range guard.
+
+/**
+ * @brief Sets the bit in the 128-bit set at the given position.
+ *
+ * @param pos The bit position to set (0-indexed from the least significant bit).
+ */
+inline void Bitset128::SetBit(unsigned int pos) {
+  // If pos >= 128, ignore (out of range for our fixed bitset).
+  if (pos >= kBits) return;
+  words[pos >> 6U] |= static_cast<uint64_t>(1) << (pos & 63U);
+}
+
+/**
+ * @brief Clears (unsets) the bit in the 128-bit set at the given position.
+ *
+ * @param pos The bit position to clear (0-indexed from the least significant bit).
+ */
+inline void Bitset128::ClearBit(unsigned int pos) {
+  if (pos >= kBits) return;
+  words[pos >> 6U] &= ~(static_cast<uint64_t>(1) << (pos & 63U));
+}
+
+/**
+ * @brief Checks if the bit at the given position is set.
+ *
+ * @param pos The bit position to test.
+ * @return True if the bit is set, false otherwise.
+ */
+inline bool Bitset128::TestBit(unsigned int pos) const {
+  if (pos >= kBits) return false;
+  return ((words[pos >> 6U] >> (pos & 63U)) & 1U) != 0U;
+}
+
+/**
+ * @brief Sets the bit at @p pos to @p value without branching.
+ *
+ * @param pos The bit position; must be < kBits (not checked).
+ * @param value The new bit value.
+ */
+inline void Bitset128::AssignBit(unsigned int pos, bool value) {
+  uint64_t &word = words[pos >> 6U];
+  const uint64_t mask = static_cast<uint64_t>(1) << (pos & 63U);
+  word = (word & ~mask) | (-static_cast<uint64_t>(value) & mask);
+}
+
+/**
+ * @brief Finds the highest set bit (most significant bit) in the 128-bit set.
+ *
+ * @return The index of the highest set bit, or -1 if none is set.
+ */
+inline int Bitset128::HighestSetBit() const {
+  // Check the high 64 bits first.
+  if (words[1] != 0U) {
+    return 64 + static_cast<int>(HighestBit64(words[1]));
+  } else if (words[0] != 0U) {
+    return static_cast<int>(HighestBit64(words[0]));
+  }
+  return -1;  // No bits set.
+}
+
+/**
+ * @brief Finds the lowest set bit (least significant bit) in the 128-bit set.
+ *
+ * @return The index of the lowest set bit, or -1 if none is set.
+ */
+inline int Bitset128::LowestSetBit() const {
+  // Check the low 64 bits first.
+  if (words[0] != 0U) {
+    return static_cast<int>(LowestBit64(words[0]));
+  } else if (words[1] != 0U) {
+    return 64 + static_cast<int>(LowestBit64(words[1]));
+  }
+  return -1;  // No bits set.
+}
+
+#endif  // PROJECT_BITSET_H_
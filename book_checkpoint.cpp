@@ -0,0 +1,316 @@
+#include "book_checkpoint.h"
+
+#include <atomic>       // for std::atomic_ref, std::atomic_thread_fence
+#include <cstring>      // for std::memcpy, std::memcmp
+#include <type_traits>  // for std::is_trivially_copyable_v
+#include <vector>       // for std::vector
+
+#include <fcntl.h>     // for open
+#include <sys/mman.h>  // for mmap, munmap
+#include <sys/stat.h>  // for fstat
+#include <unistd.h>    // for ftruncate, close
+
+namespace {
+
+constexpr char kMagic[8] = {'F', 'O', 'B', 'C', 'K', 'P', 'T', '1'};
+
+static_assert(std::is_trivially_copyable_v<OrderBook>,
+              "books are checkpointed as raw images");
+
+/**
+ * @brief Byte offsets of each section for a region of @p capacity markets.
+ */
+struct RegionLayout {
+  size_t markets;
+  size_t aliases;
+  size_t books;
+  size_t keys;
+  size_t size;
+};
+
+RegionLayout LayoutFor(size_t capacity, size_t key_bytes) {
+  RegionLayout layout;
+  layout.markets = sizeof(BookCheckpointHeader);
+  layout.aliases = layout.markets + capacity * sizeof(BookCheckpointMarket);
+  const size_t aliases_end =
+      layout.aliases + capacity * sizeof(BookCheckpointAlias);
+  layout.books = (aliases_end + alignof(OrderBook) - 1U) &
+                 ~(alignof(OrderBook) - 1U);
+  layout.keys = layout.books + capacity * sizeof(OrderBook);
+  layout.size = layout.keys + key_bytes;
+  return layout;
+}
+
+}  // namespace
+
+// =============================================================================
+// BookCheckpointWriter Method Definitions
+// =============================================================================
+
+/**
+ * @brief Unmaps the region if it is still open.
+ */
+BookCheckpointWriter::~BookCheckpointWriter() {
+  Close();
+}
+
+/**
+ * @brief Creates the region file at its final size and maps it shared.
+ *
+ * @param path Region path; a /dev/shm path keeps it in shared memory.
+ * @param capacity Markets (and aliases) the region can hold.
+ * @param key_bytes Room for all ticker and alias bytes.
+ * @return False if the file could not be created or mapped.
+ */
+bool BookCheckpointWriter::Open(const char* path, size_t capacity,
+                                size_t key_bytes) {
+  if (base_ != nullptr || capacity > UINT32_MAX) return false;
+  const RegionLayout layout = LayoutFor(capacity, key_bytes);
+  const int fd = ::open(path, O_CREAT | O_TRUNC | O_RDWR, 0644);
+  if (fd < 0) return false;
+  if (::ftruncate(fd, static_cast<off_t>(layout.size)) != 0) {
+    ::close(fd);
+    return false;
+  }
+  void* mapping = ::mmap(nullptr, layout.size, PROT_READ | PROT_WRITE,
+                         MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (mapping == MAP_FAILED) return false;
+
+  base_ = static_cast<uint8_t*>(mapping);
+  size_ = layout.size;
+  header_ = reinterpret_cast<BookCheckpointHeader*>(base_);
+  // The file starts zeroed, so generation 0 marks "nothing written yet".
+  std::memcpy(header_->magic, kMagic, sizeof(kMagic));
+  header_->version = kBookCheckpointVersion;
+  header_->book_size = static_cast<uint32_t>(sizeof(OrderBook));
+  header_->capacity = static_cast<uint32_t>(capacity);
+  header_->levels = OrderBook::kArraySize;
+  header_->key_capacity = key_bytes;
+  return true;
+}
+
+/**
+ * @brief Unmaps the region; its contents stay readable by other processes.
+ */
+void BookCheckpointWriter::Close() {
+  if (base_ != nullptr) {
+    ::munmap(base_, size_);
+  }
+  base_ = nullptr;
+  size_ = 0U;
+  header_ = nullptr;
+}
+
+/**
+ * @brief Copies every interned market into the region under the seqlock.
+ *
+ * Cost is one memcpy of sizeof(OrderBook) per market plus the key bytes;
+ * nothing is allocated.
+ */
+bool BookCheckpointWriter::Write(const BookRegistry& registry) {
+  if (base_ == nullptr) return false;
+  std::atomic_ref<uint64_t> generation(header_->generation);
+  const uint64_t start = generation.load(std::memory_order_relaxed) | 1U;
+  generation.store(start, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  const size_t capacity = header_->capacity;
+  const size_t count = registry.size();
+  if (count > capacity) return false;
+  const RegionLayout layout = LayoutFor(capacity, header_->key_capacity);
+  auto* markets = reinterpret_cast<BookCheckpointMarket*>(base_ +
+                                                          layout.markets);
+  auto* aliases = reinterpret_cast<BookCheckpointAlias*>(base_ +
+                                                         layout.aliases);
+  auto* books = reinterpret_cast<OrderBook*>(base_ + layout.books);
+  uint8_t* const keys = base_ + layout.keys;
+
+  bool fits = true;
+  uint64_t key_used = 0U;
+  auto copy_key = [&](const char* key, size_t key_len) {
+    const uint64_t offset = key_used;
+    if (key_used + key_len > header_->key_capacity) {
+      fits = false;
+      return offset;
+    }
+    std::memcpy(keys + key_used, key, key_len);
+    key_used += key_len;
+    return offset;
+  };
+
+  registry.ForEachTicker(
+      [&](BookRegistry::MarketId id, const char* key, size_t key_len) {
+        markets[id].ticker_offset = copy_key(key, key_len);
+        markets[id].ticker_len = static_cast<uint32_t>(key_len);
+      });
+  uint64_t alias_count = 0U;
+  registry.ForEachMarketIdAlias(
+      [&](BookRegistry::MarketId id, const char* key, size_t key_len) {
+        if (alias_count == capacity) {
+          fits = false;
+          return;
+        }
+        BookCheckpointAlias& alias = aliases[alias_count++];
+        alias.key_offset = copy_key(key, key_len);
+        alias.key_len = static_cast<uint32_t>(key_len);
+        alias.market_id = id;
+      });
+  if (!fits) return false;
+
+  for (size_t id = 0; id < count; ++id) {
+    const OrderBook& book =
+        registry.book(static_cast<BookRegistry::MarketId>(id));
+    markets[id].watermark = book.last_applied_seq();
+    markets[id].expected_seq = book.expected_seq();
+    std::memcpy(static_cast<void*>(&books[id]), &book, sizeof(OrderBook));
+    // The publication target is a pointer into this process.
+    books[id].SetPublishedTopOfBook(nullptr);
+  }
+  header_->market_count = count;
+  header_->alias_count = alias_count;
+  header_->key_used = key_used;
+
+  generation.store(start + 1U, std::memory_order_release);
+  return true;
+}
+
+/**
+ * @brief Raw generation counter of the region.
+ */
+uint64_t BookCheckpointWriter::generation() const {
+  if (header_ == nullptr) return 0U;
+  return std::atomic_ref<uint64_t>(header_->generation)
+      .load(std::memory_order_relaxed);
+}
+
+// =============================================================================
+// BookCheckpointReader Method Definitions
+// =============================================================================
+
+/**
+ * @brief Unmaps the region.
+ */
+BookCheckpointReader::~BookCheckpointReader() {
+  Close();
+}
+
+/**
+ * @brief Maps a region read-only and checks that this build can read it.
+ *
+ * @param path Region written by BookCheckpointWriter.
+ * @return False if the file is missing, truncated or from another layout.
+ */
+bool BookCheckpointReader::Open(const char* path) {
+  Close();
+  const int fd = ::open(path, O_RDONLY);
+  if (fd < 0) return false;
+  struct stat st;
+  if (::fstat(fd, &st) != 0 ||
+      static_cast<size_t>(st.st_size) < sizeof(BookCheckpointHeader)) {
+    ::close(fd);
+    return false;
+  }
+  void* mapping = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ,
+                         MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (mapping == MAP_FAILED) return false;
+
+  base_ = static_cast<const uint8_t*>(mapping);
+  size_ = static_cast<size_t>(st.st_size);
+  header_ = reinterpret_cast<const BookCheckpointHeader*>(base_);
+  if (std::memcmp(header_->magic, kMagic, sizeof(kMagic)) != 0 ||
+      header_->version != kBookCheckpointVersion ||
+      header_->book_size != sizeof(OrderBook) ||
+      header_->levels != OrderBook::kArraySize ||
+      LayoutFor(header_->capacity, header_->key_capacity).size != size_) {
+    Close();
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Releases the mapping.
+ */
+void BookCheckpointReader::Close() {
+  if (base_ != nullptr) {
+    ::munmap(const_cast<uint8_t*>(base_), size_);
+  }
+  base_ = nullptr;
+  size_ = 0U;
+  header_ = nullptr;
+}
+
+/**
+ * @brief Seqlock read of the region into a registry.
+ *
+ * Books are copied straight into the registry; the market and alias tables
+ * and key bytes are copied out first, and only interned once the generation
+ * check has confirmed the copy, so a torn read leaves the registry's IDs
+ * untouched and the caller can simply retry.
+ */
+bool BookCheckpointReader::Restore(BookRegistry* registry) const {
+  if (base_ == nullptr) return false;
+  std::atomic_ref<uint64_t> generation(
+      const_cast<uint64_t&>(header_->generation));
+  const uint64_t start = generation.load(std::memory_order_acquire);
+  if (start == 0U || (start & 1U) != 0U) return false;
+
+  const size_t count = header_->market_count;
+  const size_t alias_count = header_->alias_count;
+  const size_t key_used = header_->key_used;
+  if (count > header_->capacity || alias_count > header_->capacity ||
+      key_used > header_->key_capacity || count > registry->capacity()) {
+    return false;
+  }
+  const RegionLayout layout =
+      LayoutFor(header_->capacity, header_->key_capacity);
+  const auto* books = reinterpret_cast<const OrderBook*>(base_ + layout.books);
+  const std::vector<BookCheckpointMarket> markets(
+      reinterpret_cast<const BookCheckpointMarket*>(base_ + layout.markets),
+      reinterpret_cast<const BookCheckpointMarket*>(base_ + layout.markets) +
+          count);
+  const std::vector<BookCheckpointAlias> aliases(
+      reinterpret_cast<const BookCheckpointAlias*>(base_ + layout.aliases),
+      reinterpret_cast<const BookCheckpointAlias*>(base_ + layout.aliases) +
+          alias_count);
+  const std::vector<char> keys(
+      reinterpret_cast<const char*>(base_ + layout.keys),
+      reinterpret_cast<const char*>(base_ + layout.keys) + key_used);
+  for (size_t id = 0; id < count; ++id) {
+    OrderBook& book = registry->book(static_cast<BookRegistry::MarketId>(id));
+    std::memcpy(static_cast<void*>(&book), &books[id], sizeof(OrderBook));
+    book.SetPublishedTopOfBook(nullptr);
+  }
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (generation.load(std::memory_order_relaxed) != start) return false;
+
+  for (size_t id = 0; id < count; ++id) {
+    const BookCheckpointMarket& market = markets[id];
+    if (market.ticker_offset + market.ticker_len > key_used ||
+        registry->Intern(keys.data() + market.ticker_offset,
+                         market.ticker_len) != id) {
+      return false;
+    }
+  }
+  for (const BookCheckpointAlias& alias : aliases) {
+    if (alias.key_offset + alias.key_len > key_used ||
+        alias.market_id >= count) {
+      return false;
+    }
+    // Already-present aliases (a retried restore) are fine.
+    registry->AddMarketIdAlias(alias.market_id, keys.data() + alias.key_offset,
+                               alias.key_len);
+  }
+  return true;
+}
+
+/**
+ * @brief Raw generation counter of the region.
+ */
+uint64_t BookCheckpointReader::generation() const {
+  if (header_ == nullptr) return 0U;
+  return std::atomic_ref<uint64_t>(const_cast<uint64_t&>(header_->generation))
+      .load(std::memory_order_acquire);
+}
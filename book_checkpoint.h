@@ -0,0 +1,158 @@
+#ifndef PROJECT_BOOK_CHECKPOINT_H_
+#define PROJECT_BOOK_CHECKPOINT_H_
+
+#include <cstddef> // for size_t
+#include <cstdint> // for uint32_t, uint64_t
+#include "book_registry.h"
+#include "orderbook.h"
+
+// ---------------------------------------------------------------------------
+// Checkpoint region format
+// ---------------------------------------------------------------------------
+/**
+ * @brief Layout of a checkpoint region (host byte order, one mapping):
+ *
+ *   BookCheckpointHeader                    64 bytes
+ *   BookCheckpointMarket[capacity]          32 bytes each, by MarketId
+ *   BookCheckpointAlias[capacity]           16 bytes each
+ *   OrderBook[capacity]                     raw book images, 64-aligned
+ *   key bytes                               tickers and aliases
+ *
+ * Books are stored as their in-memory image, so a region is only readable
+ * by a build with the same OrderBook layout: version, book_size and levels
+ * must all match. Bump kBookCheckpointVersion whenever a BasicOrderBook
+ * member changes without changing its size.
+ *
+ * generation is a seqlock over the whole region: odd while the writer is
+ * copying, increased by 2 per completed checkpoint, 0 before the first.
+ */
+struct BookCheckpointHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t book_size;   // sizeof(OrderBook).
+  uint64_t generation;  // Accessed atomically.
+  uint32_t capacity;    // Markets the region can hold.
+  uint32_t levels;      // OrderBook::kArraySize.
+  uint64_t market_count;
+  uint64_t alias_count;
+  uint64_t key_capacity;
+  uint64_t key_used;
+};
+
+struct BookCheckpointMarket {
+  /// OrderBook::last_applied_seq() at checkpoint time (0 if stale).
+  uint64_t watermark;
+  uint64_t ticker_offset;  // Offset into the key bytes.
+  uint32_t ticker_len;
+  uint32_t reserved;
+  uint64_t expected_seq;
+};
+
+struct BookCheckpointAlias {
+  uint64_t key_offset;
+  uint32_t key_len;
+  uint32_t market_id;
+};
+
+static_assert(sizeof(BookCheckpointHeader) == 64, "checkpoint format");
+static_assert(sizeof(BookCheckpointMarket) == 32, "checkpoint format");
+static_assert(sizeof(BookCheckpointAlias) == 16, "checkpoint format");
+
+constexpr uint32_t kBookCheckpointVersion = 1U;
+
+/**
+ * @class BookCheckpointWriter
+ *
+ * @brief Periodically copies a BookRegistry into a shared mapping that a
+ *        hot-standby process can restore from.
+ *
+ * Open a path under /dev/shm for a shared-memory region, or any file for a
+ * checkpoint that also survives a reboot. Each Write copies every interned
+ * market's ticker, aliases, watermark and raw book image; a standby then
+ * only needs the deltas after each book's watermark.
+ *
+ * Write reads the books, so call it from the thread applying messages (or
+ * while that thread is paused). Not thread-safe.
+ */
+class BookCheckpointWriter
+{
+public:
+  BookCheckpointWriter() = default;
+  ~BookCheckpointWriter();
+
+  BookCheckpointWriter(const BookCheckpointWriter &) = delete;
+  BookCheckpointWriter &operator=(const BookCheckpointWriter &) = delete;
+
+  /**
+   * @brief Creates (truncates) and maps a region for up to @p capacity
+   *        markets and @p key_bytes of ticker/alias bytes.
+   *
+   * @return False on I/O error.
+   */
+  bool Open(const char *path, size_t capacity, size_t key_bytes);
+  void Close();
+
+  /**
+   * @brief Replaces the region's contents with the registry's current
+   *        state.
+   *
+   * @return False (leaving the previous checkpoint's generation odd, i.e.
+   *         unreadable) if the registry does not fit the region.
+   */
+  bool Write(const BookRegistry &registry);
+
+  /// Generation counter of the region (2 per completed Write).
+  uint64_t generation() const;
+
+private:
+  uint8_t *base_ = nullptr;
+  size_t size_ = 0U;
+  BookCheckpointHeader *header_ = nullptr;
+};
+
+/**
+ * @class BookCheckpointReader
+ *
+ * @brief Attaches to a checkpoint region read-only and restores it into a
+ *        BookRegistry.
+ */
+class BookCheckpointReader
+{
+public:
+  BookCheckpointReader() = default;
+  ~BookCheckpointReader();
+
+  BookCheckpointReader(const BookCheckpointReader &) = delete;
+  BookCheckpointReader &operator=(const BookCheckpointReader &) = delete;
+
+  /// Maps and validates @p path. Returns false if missing, truncated or
+  /// written by an incompatible build.
+  bool Open(const char *path);
+  void Close();
+
+  /**
+   * @brief Copies the latest complete checkpoint into @p registry.
+   *
+   * Markets are interned in MarketId order, so @p registry must be empty
+   * or hold a prefix of the checkpoint's markets (e.g. a failed earlier
+   * attempt); books are overwritten. Restored books do not publish a
+   * touch; re-attach SetPublishedTopOfBook if needed. Afterwards each book
+   * resumes at its watermark: deltas at or below it are ignored as
+   * duplicates and the next one is applied.
+   *
+   * @return False if no checkpoint has completed yet, the writer was
+   *         mid-write (retry; the registry's markets are unchanged), or
+   *         @p registry is too small or does not match.
+   */
+  bool Restore(BookRegistry *registry) const;
+
+  /// Generation of the latest checkpoint (odd while one is being written).
+  uint64_t generation() const;
+
+private:
+  const uint8_t *base_ = nullptr;
+  size_t size_ = 0U;
+  const BookCheckpointHeader *header_ = nullptr;
+};
+
+#endif // PROJECT_BOOK_CHECKPOINT_H_
@@ -0,0 +1,415 @@
+#include "book_kernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>  // for AVX2/AVX-512 intrinsics
+#define FAST_ORDERBOOK_X86_KERNELS 1
+#endif
+
+namespace {
+
+// =============================================================================
+// Scalar kernels
+// =============================================================================
+
+void NonZeroWordsScalar(const uint32_t* qty, unsigned int count,
+                        uint64_t* words) {
+  for (unsigned int w = 0; w < (count + 63U) / 64U; ++w) {
+    words[w] = 0U;
+  }
+  for (unsigned int i = 0; i < count; ++i) {
+    words[i >> 6U] |= static_cast<uint64_t>(qty[i] != 0U) << (i & 63U);
+  }
+}
+
+LevelSums SumLevelsScalar(const uint32_t* qty, unsigned int count) {
+  LevelSums sums;
+  for (unsigned int i = 0; i < count; ++i) {
+    sums.qty += qty[i];
+    sums.notional += static_cast<uint64_t>(qty[i]) * i;
+  }
+  return sums;
+}
+
+double WeightedSumScalar(const uint32_t* qty, const double* weights,
+                         unsigned int count) {
+  double sum = 0.0;
+  for (unsigned int i = 0; i < count; ++i) {
+    sum += weights[i] * static_cast<double>(qty[i]);
+  }
+  return sum;
+}
+
+void BandSumsScalar(const uint32_t* qty, unsigned int count,
+                    unsigned int band_width, uint64_t* out) {
+  for (unsigned int start = 0, band = 0; start < count;
+       start += band_width, ++band) {
+    const unsigned int end =
+        count - start < band_width ? count : start + band_width;
+    uint64_t sum = 0U;
+    for (unsigned int i = start; i < end; ++i) {
+      sum += qty[i];
+    }
+    out[band] = sum;
+  }
+}
+
+#if defined(FAST_ORDERBOOK_X86_KERNELS)
+
+// =============================================================================
+// AVX2 kernels
+// =============================================================================
+
+/**
+ * @brief Lanes [0, n) all-ones, the rest zero (n <= 8), for maskload.
+ */
+__attribute__((target("avx2"))) inline __m256i LaneMask8(unsigned int n) {
+  static const int32_t kTable[16] = {-1, -1, -1, -1, -1, -1, -1, -1,
+                                     0,  0,  0,  0,  0,  0,  0,  0};
+  return _mm256_loadu_si256(
+      reinterpret_cast<const __m256i*>(kTable + 8U - n));
+}
+
+/**
+ * @brief Sum of the four 64-bit lanes.
+ */
+__attribute__((target("avx2"))) inline uint64_t ReduceAdd64(__m256i v) {
+  const __m128i pair = _mm_add_epi64(_mm256_castsi256_si128(v),
+                                     _mm256_extracti128_si256(v, 1));
+  return static_cast<uint64_t>(_mm_cvtsi128_si64(pair)) +
+         static_cast<uint64_t>(_mm_extract_epi64(pair, 1));
+}
+
+__attribute__((target("avx2"))) void NonZeroWordsAvx2(const uint32_t* qty,
+                                                      unsigned int count,
+                                                      uint64_t* words) {
+  for (unsigned int w = 0; w < (count + 63U) / 64U; ++w) {
+    words[w] = 0U;
+  }
+  const __m256i zero = _mm256_setzero_si256();
+  for (unsigned int i = 0; i < count; i += 8U) {
+    const unsigned int lanes = count - i < 8U ? count - i : 8U;
+    const __m256i v = _mm256_maskload_epi32(
+        reinterpret_cast<const int*>(qty + i), LaneMask8(lanes));
+    const __m256 is_zero = _mm256_castsi256_ps(_mm256_cmpeq_epi32(v, zero));
+    // Masked-off lanes load as zero, so they never set a bit.
+    const uint64_t bits =
+        static_cast<uint64_t>(~_mm256_movemask_ps(is_zero) & 0xFF);
+    words[i >> 6U] |= bits << (i & 63U);
+  }
+}
+
+__attribute__((target("avx2"))) LevelSums SumLevelsAvx2(const uint32_t* qty,
+                                                        unsigned int count) {
+  __m256i qty_acc = _mm256_setzero_si256();
+  __m256i notional_acc = _mm256_setzero_si256();
+  __m256i price_lo = _mm256_setr_epi64x(0, 1, 2, 3);
+  __m256i price_hi = _mm256_setr_epi64x(4, 5, 6, 7);
+  const __m256i step = _mm256_set1_epi64x(8);
+  for (unsigned int i = 0; i < count; i += 8U) {
+    const unsigned int lanes = count - i < 8U ? count - i : 8U;
+    const __m256i v = _mm256_maskload_epi32(
+        reinterpret_cast<const int*>(qty + i), LaneMask8(lanes));
+    const __m256i lo = _mm256_cvtepu32_epi64(_mm256_castsi256_si128(v));
+    const __m256i hi = _mm256_cvtepu32_epi64(_mm256_extracti128_si256(v, 1));
+    qty_acc = _mm256_add_epi64(qty_acc, _mm256_add_epi64(lo, hi));
+    notional_acc = _mm256_add_epi64(
+        notional_acc, _mm256_add_epi64(_mm256_mul_epu32(lo, price_lo),
+                                       _mm256_mul_epu32(hi, price_hi)));
+    price_lo = _mm256_add_epi64(price_lo, step);
+    price_hi = _mm256_add_epi64(price_hi, step);
+  }
+  LevelSums sums;
+  sums.qty = ReduceAdd64(qty_acc);
+  sums.notional = ReduceAdd64(notional_acc);
+  return sums;
+}
+
+__attribute__((target("avx2,fma"))) double WeightedSumAvx2(
+    const uint32_t* qty, const double* weights, unsigned int count) {
+  // cvtepi32 is signed: lanes with the top bit set come out 2^32 too low.
+  const __m256d two_32 = _mm256_set1_pd(4294967296.0);
+  const __m128i zero = _mm_setzero_si128();
+  __m256d acc = _mm256_setzero_pd();
+  unsigned int i = 0;
+  for (; i + 4U <= count; i += 4U) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(qty + i));
+    const __m256d negative =
+        _mm256_castsi256_pd(_mm256_cvtepi32_epi64(_mm_cmplt_epi32(v, zero)));
+    const __m256d value = _mm256_add_pd(_mm256_cvtepi32_pd(v),
+                                        _mm256_and_pd(negative, two_32));
+    acc = _mm256_fmadd_pd(_mm256_loadu_pd(weights + i), value, acc);
+  }
+  const __m128d pair = _mm_add_pd(_mm256_castpd256_pd128(acc),
+                                  _mm256_extractf128_pd(acc, 1));
+  double sum = _mm_cvtsd_f64(_mm_add_sd(pair, _mm_unpackhi_pd(pair, pair)));
+  for (; i < count; ++i) {
+    sum += weights[i] * static_cast<double>(qty[i]);
+  }
+  return sum;
+}
+
+__attribute__((target("avx2"))) void BandSumsAvx2(const uint32_t* qty,
+                                                  unsigned int count,
+                                                  unsigned int band_width,
+                                                  uint64_t* out) {
+  for (unsigned int start = 0, band = 0; start < count;
+       start += band_width, ++band) {
+    const unsigned int end =
+        count - start < band_width ? count : start + band_width;
+    __m256i acc = _mm256_setzero_si256();
+    for (unsigned int i = start; i < end; i += 8U) {
+      const unsigned int lanes = end - i < 8U ? end - i : 8U;
+      const __m256i v = _mm256_maskload_epi32(
+          reinterpret_cast<const int*>(qty + i), LaneMask8(lanes));
+      acc = _mm256_add_epi64(
+          acc,
+          _mm256_add_epi64(_mm256_cvtepu32_epi64(_mm256_castsi256_si128(v)),
+                           _mm256_cvtepu32_epi64(
+                               _mm256_extracti128_si256(v, 1))));
+    }
+    out[band] = ReduceAdd64(acc);
+  }
+}
+
+// =============================================================================
+// AVX-512 kernels
+// =============================================================================
+
+/**
+ * @brief Mask of lanes [0, n) for n <= 16.
+ */
+inline __mmask16 LaneMask16(unsigned int n) {
+  return static_cast<__mmask16>((1U << n) - 1U);
+}
+
+// GCC 12's unmasked AVX-512 widen/extract/multiply wrappers pass an
+// undefined operand and trip -Wmaybe-uninitialized; the all-lanes
+// zero-masked forms below compile to the same instructions.
+
+/**
+ * @brief Zero-extends eight 32-bit lanes to 64 bits.
+ */
+__attribute__((target("avx512f"))) inline __m512i Widen8(__m256i v) {
+  return _mm512_maskz_cvtepu32_epi64(0xFF, v);
+}
+
+/**
+ * @brief Lower and upper 256 bits of @p v. (Without -mavx512f GCC lowers
+ *        _mm512_castsi512_si256 to an extract with the same problem.)
+ */
+__attribute__((target("avx512f"))) inline __m256i Low256(__m512i v) {
+  return _mm512_maskz_extracti64x4_epi64(0xFF, v, 0);
+}
+
+__attribute__((target("avx512f"))) inline __m256i High256(__m512i v) {
+  return _mm512_maskz_extracti64x4_epi64(0xFF, v, 1);
+}
+
+/**
+ * @brief Sixteen 32-bit lanes, zero-extended and added pairwise into eight
+ *        64-bit lanes.
+ */
+__attribute__((target("avx512f"))) inline __m512i Widen16(__m512i v) {
+  return _mm512_add_epi64(Widen8(Low256(v)), Widen8(High256(v)));
+}
+
+/**
+ * @brief Sum of the eight 64-bit lanes.
+ */
+__attribute__((target("avx512f"))) inline uint64_t ReduceAdd64x8(__m512i v) {
+  return ReduceAdd64(_mm256_add_epi64(Low256(v), High256(v)));
+}
+
+/**
+ * @brief Sum of the eight double lanes.
+ */
+__attribute__((target("avx512f"))) inline double ReduceAddPd(__m512d v) {
+  const __m256d quad = _mm256_add_pd(_mm512_maskz_extractf64x4_pd(0xFF, v, 0),
+                                     _mm512_maskz_extractf64x4_pd(0xFF, v, 1));
+  const __m128d pair = _mm_add_pd(_mm256_castpd256_pd128(quad),
+                                  _mm256_extractf128_pd(quad, 1));
+  return _mm_cvtsd_f64(_mm_add_sd(pair, _mm_unpackhi_pd(pair, pair)));
+}
+
+__attribute__((target("avx512f"))) void NonZeroWordsAvx512(
+    const uint32_t* qty, unsigned int count, uint64_t* words) {
+  for (unsigned int w = 0; w < (count + 63U) / 64U; ++w) {
+    words[w] = 0U;
+  }
+  for (unsigned int i = 0; i < count; i += 16U) {
+    const __mmask16 lanes = LaneMask16(count - i < 16U ? count - i : 16U);
+    const __m512i v = _mm512_maskz_loadu_epi32(lanes, qty + i);
+    // i is a multiple of 16, so the 16 bits never straddle two words.
+    words[i >> 6U] |= static_cast<uint64_t>(_mm512_test_epi32_mask(v, v))
+                      << (i & 63U);
+  }
+}
+
+__attribute__((target("avx512f"))) LevelSums SumLevelsAvx512(
+    const uint32_t* qty, unsigned int count) {
+  __m512i qty_acc = _mm512_setzero_si512();
+  __m512i notional_acc = _mm512_setzero_si512();
+  __m512i price_lo = _mm512_setr_epi64(0, 1, 2, 3, 4, 5, 6, 7);
+  __m512i price_hi = _mm512_setr_epi64(8, 9, 10, 11, 12, 13, 14, 15);
+  const __m512i step = _mm512_set1_epi64(16);
+  for (unsigned int i = 0; i < count; i += 16U) {
+    const __mmask16 lanes = LaneMask16(count - i < 16U ? count - i : 16U);
+    const __m512i v = _mm512_maskz_loadu_epi32(lanes, qty + i);
+    const __m512i lo = Widen8(Low256(v));
+    const __m512i hi = Widen8(High256(v));
+    qty_acc = _mm512_add_epi64(qty_acc, _mm512_add_epi64(lo, hi));
+    notional_acc = _mm512_add_epi64(
+        notional_acc,
+        _mm512_add_epi64(_mm512_maskz_mul_epu32(0xFF, lo, price_lo),
+                         _mm512_maskz_mul_epu32(0xFF, hi, price_hi)));
+    price_lo = _mm512_add_epi64(price_lo, step);
+    price_hi = _mm512_add_epi64(price_hi, step);
+  }
+  LevelSums sums;
+  sums.qty = ReduceAdd64x8(qty_acc);
+  sums.notional = ReduceAdd64x8(notional_acc);
+  return sums;
+}
+
+__attribute__((target("avx512f"))) double WeightedSumAvx512(
+    const uint32_t* qty, const double* weights, unsigned int count) {
+  __m512d acc = _mm512_setzero_pd();
+  for (unsigned int i = 0; i < count; i += 8U) {
+    const unsigned int n = count - i < 8U ? count - i : 8U;
+    const __mmask8 lanes = static_cast<__mmask8>((1U << n) - 1U);
+    const __m256i v =
+        Low256(_mm512_maskz_loadu_epi32(static_cast<__mmask16>(lanes), qty + i));
+    acc = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(lanes, weights + i),
+                          _mm512_maskz_cvtepu32_pd(lanes, v), acc);
+  }
+  return ReduceAddPd(acc);
+}
+
+__attribute__((target("avx512f"))) void BandSumsAvx512(
+    const uint32_t* qty, unsigned int count, unsigned int band_width,
+    uint64_t* out) {
+  for (unsigned int start = 0, band = 0; start < count;
+       start += band_width, ++band) {
+    const unsigned int end =
+        count - start < band_width ? count : start + band_width;
+    __m512i acc = _mm512_setzero_si512();
+    for (unsigned int i = start; i < end; i += 16U) {
+      const __mmask16 lanes = LaneMask16(end - i < 16U ? end - i : 16U);
+      acc = _mm512_add_epi64(acc,
+                             Widen16(_mm512_maskz_loadu_epi32(lanes, qty + i)));
+    }
+    out[band] = ReduceAdd64x8(acc);
+  }
+}
+
+#endif  // FAST_ORDERBOOK_X86_KERNELS
+
+// =============================================================================
+// Dispatch
+// =============================================================================
+
+struct KernelTable {
+  KernelIsa isa;
+  void (*non_zero_words)(const uint32_t*, unsigned int, uint64_t*);
+  LevelSums (*sum_levels)(const uint32_t*, unsigned int);
+  double (*weighted_sum)(const uint32_t*, const double*, unsigned int);
+  void (*band_sums)(const uint32_t*, unsigned int, unsigned int, uint64_t*);
+};
+
+/**
+ * @brief Widest implementation this CPU can run.
+ */
+KernelIsa DetectIsa() {
+#if defined(FAST_ORDERBOOK_X86_KERNELS)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    return KernelIsa::kAvx512;
+  }
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    return KernelIsa::kAvx2;
+  }
+#endif
+  return KernelIsa::kScalar;
+}
+
+KernelTable MakeTable(KernelIsa isa) {
+#if defined(FAST_ORDERBOOK_X86_KERNELS)
+  if (isa == KernelIsa::kAvx512) {
+    return KernelTable{isa, NonZeroWordsAvx512, SumLevelsAvx512,
+                       WeightedSumAvx512, BandSumsAvx512};
+  }
+  if (isa == KernelIsa::kAvx2) {
+    return KernelTable{isa, NonZeroWordsAvx2, SumLevelsAvx2, WeightedSumAvx2,
+                       BandSumsAvx2};
+  }
+#endif
+  return KernelTable{KernelIsa::kScalar, NonZeroWordsScalar, SumLevelsScalar,
+                     WeightedSumScalar, BandSumsScalar};
+}
+
+/**
+ * @brief The dispatch table, resolved from CPUID on first use.
+ */
+KernelTable& Table() {
+  static KernelTable table = MakeTable(DetectIsa());
+  return table;
+}
+
+}  // namespace
+
+// =============================================================================
+// book_kernels Function Definitions
+// =============================================================================
+
+namespace book_kernels {
+
+/**
+ * @brief Bitset words of the nonzero levels.
+ */
+void NonZeroWords(const uint32_t* qty, unsigned int count, uint64_t* words) {
+  Table().non_zero_words(qty, count, words);
+}
+
+/**
+ * @brief Total and price-weighted quantity.
+ */
+LevelSums SumLevels(const uint32_t* qty, unsigned int count) {
+  return Table().sum_levels(qty, count);
+}
+
+/**
+ * @brief Dot product of quantities and per-price weights.
+ */
+double WeightedSum(const uint32_t* qty, const double* weights,
+                   unsigned int count) {
+  return Table().weighted_sum(qty, weights, count);
+}
+
+/**
+ * @brief Quantity per fixed-width price band.
+ */
+void BandSums(const uint32_t* qty, unsigned int count, unsigned int band_width,
+              uint64_t* out) {
+  Table().band_sums(qty, count, band_width, out);
+}
+
+/**
+ * @brief Implementation currently selected.
+ */
+KernelIsa ActiveIsa() {
+  return Table().isa;
+}
+
+/**
+ * @brief Re-resolves the table with @p max as the widest allowed ISA.
+ */
+KernelIsa SetIsa(KernelIsa max) {
+  const KernelIsa supported = DetectIsa();
+  const KernelIsa isa =
+      static_cast<uint8_t>(max) < static_cast<uint8_t>(supported) ? max
+                                                                  : supported;
+  Table() = MakeTable(isa);
+  return isa;
+}
+
+}  // namespace book_kernels
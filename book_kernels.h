@@ -0,0 +1,66 @@
+#ifndef PROJECT_BOOK_KERNELS_H_
+#define PROJECT_BOOK_KERNELS_H_
+
+#include <cstdint> // for uint8_t, uint32_t, uint64_t
+
+/**
+ * @brief Instruction set a kernel implementation targets.
+ */
+enum class KernelIsa : uint8_t {
+  kScalar = 0,
+  kAvx2,    // AVX2 + FMA.
+  kAvx512,  // AVX-512F.
+};
+
+/**
+ * @brief Quantity and price-weighted quantity (notional) of one side.
+ */
+struct LevelSums
+{
+  uint64_t qty{0};
+  uint64_t notional{0};
+};
+
+/**
+ * Bulk kernels over one side's quantity row: qty[p] is the quantity at
+ * price p, for p in [0, count). Each kernel exists in AVX-512, AVX2 and
+ * scalar form; the widest one the CPU supports is picked from CPUID on
+ * first use, so a portable build (FAST_ORDERBOOK_NATIVE=OFF) still runs
+ * the vector code. A 100-level row is 7 AVX-512 or 13 AVX2 steps (tails
+ * use masked loads), with no branches on the data.
+ *
+ * BasicOrderBook uses them for 32-bit quantities.
+ */
+namespace book_kernels {
+
+/// words[w] bit b = (qty[64w + b] != 0); writes (count + 63) / 64 words.
+void NonZeroWords(const uint32_t *qty, unsigned int count, uint64_t *words);
+
+/// Sum of qty[p] and of p * qty[p].
+LevelSums SumLevels(const uint32_t *qty, unsigned int count);
+
+/// Sum of weights[p] * qty[p]. Vector forms add in a different order, so
+/// results may differ from the scalar form in the last bits.
+double WeightedSum(const uint32_t *qty, const double *weights,
+                   unsigned int count);
+
+/// out[k] = sum of qty[p] over p in [k * band_width, (k + 1) * band_width);
+/// writes (count + band_width - 1) / band_width bands. band_width > 0.
+void BandSums(const uint32_t *qty, unsigned int count,
+              unsigned int band_width, uint64_t *out);
+
+/// Implementation the dispatched kernels currently use.
+KernelIsa ActiveIsa();
+
+/**
+ * @brief Restricts dispatch to @p max or narrower (for benchmarks and for
+ *        cross-checking against the scalar kernels). Not thread-safe: call
+ *        before other threads use the kernels.
+ *
+ * @return The implementation selected (@p max clamped to the CPU).
+ */
+KernelIsa SetIsa(KernelIsa max);
+
+}  // namespace book_kernels
+
+#endif // PROJECT_BOOK_KERNELS_H_
@@ -0,0 +1,500 @@
+#include "book_registry.h"
+
+#include <cstring>  // for std::memcmp
+#include <new>      // for placement new, std::align_val_t
+#include <thread>   // for std::thread
+#include <vector>   // for std::vector
+
+#include "latency_stats.h"
+
+namespace {
+
+/**
+ * @brief Alignment of the OrderBook slab (one cache line).
+ */
+constexpr size_t kSlabAlignment = 64U;
+
+static_assert(alignof(OrderBook) >= kSlabAlignment &&
+                  sizeof(OrderBook) % kSlabAlignment == 0,
+              "OrderBook must tile the slab on cache-line boundaries");
+
+/**
+ * @brief Brackets one book update with its seqlock, if seqlocks are on.
+ */
+class SeqlockWriteScope
+{
+public:
+  SeqlockWriteScope(BookSeqlock* seqlocks, uint32_t id)
+      : lock_(seqlocks != nullptr ? &seqlocks[id] : nullptr) {
+    if (lock_ != nullptr) lock_->BeginWrite();
+  }
+  ~SeqlockWriteScope() {
+    if (lock_ != nullptr) lock_->EndWrite();
+  }
+
+  SeqlockWriteScope(const SeqlockWriteScope&) = delete;
+  SeqlockWriteScope& operator=(const SeqlockWriteScope&) = delete;
+
+private:
+  BookSeqlock* const lock_;
+};
+
+/**
+ * @brief True if @p book will apply @p msg directly rather than buffer it
+ *        or drop it as a duplicate.
+ */
+bool AppliesInOrder(const OrderBook& book, const DeltaMessage& msg) {
+  return msg.seq == 0U || (!book.IsStale() && msg.seq == book.expected_seq());
+}
+
+/**
+ * @brief Rounds up to the next power of two (minimum 1).
+ */
+size_t NextPowerOfTwo(size_t value) {
+  size_t result = 1U;
+  while (result < value) {
+    result <<= 1U;
+  }
+  return result;
+}
+
+}  // namespace
+
+// =============================================================================
+// InternTable Method Definitions
+// =============================================================================
+
+/**
+ * @brief Creates a table able to hold @p capacity keys at <= 50% load.
+ */
+BookRegistry::InternTable::InternTable(size_t capacity)
+    : slots_(NextPowerOfTwo(capacity * 2U + 1U),
+             Slot{0U, 0U, 0U, kInvalidMarketId}),
+      mask_(slots_.size() - 1U),
+      capacity_(capacity),
+      size_(0U) {}
+
+/**
+ * @brief Looks up a key with linear probing (at most one pass over the
+ *        slots).
+ *
+ * @return The mapped ID, or kInvalidMarketId if absent.
+ */
+BookRegistry::MarketId BookRegistry::InternTable::Find(const char* key,
+                                                        size_t key_len,
+                                                        uint64_t hash) const {
+  size_t i = static_cast<size_t>(hash) & mask_;
+  for (size_t probes = 0; probes <= mask_; ++probes, i = (i + 1U) & mask_) {
+    const Slot& slot = slots_[i];
+    if (slot.id == kInvalidMarketId) {
+      return kInvalidMarketId;
+    }
+    if (slot.hash == hash && slot.key_len == key_len &&
+        std::memcmp(&key_bytes_[slot.key_offset], key, key_len) == 0) {
+      return slot.id;
+    }
+  }
+  return kInvalidMarketId;
+}
+
+/**
+ * @brief Inserts a key, copying its bytes into the table's own storage.
+ *
+ * @return False if the key was already present or the table is full.
+ */
+bool BookRegistry::InternTable::Insert(const char* key, size_t key_len,
+                                       uint64_t hash, MarketId id) {
+  size_t i = static_cast<size_t>(hash) & mask_;
+  bool found_empty = false;
+  for (size_t probes = 0; probes <= mask_; ++probes, i = (i + 1U) & mask_) {
+    const Slot& slot = slots_[i];
+    if (slot.id == kInvalidMarketId) {
+      found_empty = true;
+      break;
+    }
+    if (slot.hash == hash && slot.key_len == key_len &&
+        std::memcmp(&key_bytes_[slot.key_offset], key, key_len) == 0) {
+      return false;
+    }
+  }
+  if (!found_empty || size_ >= capacity_) {
+    return false;
+  }
+
+  const uint32_t offset = static_cast<uint32_t>(key_bytes_.size());
+  key_bytes_.insert(key_bytes_.end(), key, key + key_len);
+  slots_[i] = Slot{hash, offset, static_cast<uint32_t>(key_len), id};
+  ++size_;
+  return true;
+}
+
+// =============================================================================
+// BookRegistry Method Definitions
+// =============================================================================
+
+/**
+ * @brief Allocates a 64-byte-aligned slab of @p capacity empty books.
+ */
+BookRegistry::BookRegistry(size_t capacity)
+    : BookRegistry(capacity, nullptr) {}
+
+/**
+ * @brief Constructs @p capacity empty books in @p slab, or in a slab of its
+ *        own when @p slab is nullptr.
+ */
+BookRegistry::BookRegistry(size_t capacity, void* slab)
+    : books_(nullptr),
+      owns_slab_(slab == nullptr),
+      capacity_(capacity),
+      size_(0U),
+      tickers_(capacity),
+      market_ids_(capacity),
+      ready_(false),
+      seqlocks_(nullptr) {
+  void* raw = owns_slab_ ? ::operator new(SlabBytes(capacity_),
+                                          std::align_val_t(kSlabAlignment))
+                         : slab;
+  books_ = static_cast<OrderBook*>(raw);
+  for (size_t i = 0; i < capacity_; ++i) {
+    new (&books_[i]) OrderBook();
+  }
+}
+
+/**
+ * @brief Destroys all books and releases the slab if the registry owns it.
+ */
+BookRegistry::~BookRegistry() {
+  for (size_t i = 0; i < capacity_; ++i) {
+    books_[i].~OrderBook();
+  }
+  if (owns_slab_) {
+    ::operator delete(books_, std::align_val_t(kSlabAlignment));
+  }
+}
+
+/**
+ * @brief 64-bit FNV-1a hash of a byte string.
+ */
+uint64_t BookRegistry::Hash(const char* key, size_t key_len) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (size_t i = 0; i < key_len; ++i) {
+    hash ^= static_cast<unsigned char>(key[i]);
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+/**
+ * @brief Returns the ID for a ticker, assigning the next dense ID if new.
+ *
+ * @param ticker Pointer to the ticker bytes (need not outlive the call).
+ * @param ticker_len Length of the ticker.
+ * @return The market ID, or kInvalidMarketId if the registry is full.
+ */
+BookRegistry::MarketId BookRegistry::Intern(const char* ticker,
+                                            size_t ticker_len) {
+  const uint64_t hash = Hash(ticker, ticker_len);
+  const MarketId existing = tickers_.Find(ticker, ticker_len, hash);
+  if (existing != kInvalidMarketId) {
+    return existing;
+  }
+  if (size_ >= capacity_) {
+    return kInvalidMarketId;
+  }
+  const MarketId id = static_cast<MarketId>(size_++);
+  tickers_.Insert(ticker, ticker_len, hash, id);
+  return id;
+}
+
+/**
+ * @brief Looks up a ticker without interning it.
+ */
+BookRegistry::MarketId BookRegistry::FindByTicker(const char* ticker,
+                                                  size_t ticker_len) const {
+  return tickers_.Find(ticker, ticker_len, Hash(ticker, ticker_len));
+}
+
+/**
+ * @brief Looks up a venue market_id (alias registered from snapshots).
+ */
+BookRegistry::MarketId BookRegistry::FindByMarketId(
+    const char* market_id, size_t market_id_len) const {
+  return market_ids_.Find(market_id, market_id_len,
+                          Hash(market_id, market_id_len));
+}
+
+/**
+ * @brief Adds a venue market_id alias for an interned market.
+ *
+ * @return False if the alias was already registered (to any market), or
+ *         if the alias table already holds capacity() aliases.
+ */
+bool BookRegistry::AddMarketIdAlias(MarketId id, const char* market_id,
+                                    size_t market_id_len) {
+  return market_ids_.Insert(market_id, market_id_len,
+                            Hash(market_id, market_id_len), id);
+}
+
+/**
+ * @brief Interns a snapshot's ticker and registers its market_id alias.
+ *
+ * @return The market ID, or kInvalidMarketId if the registry is full.
+ */
+BookRegistry::MarketId BookRegistry::InternSnapshot(const char* ticker,
+                                                    size_t ticker_len,
+                                                    const char* market_id,
+                                                    size_t market_id_len) {
+  const MarketId id = Intern(ticker, ticker_len);
+  if (id != kInvalidMarketId && market_id_len > 0U) {
+    // Duplicate inserts (same alias on a later snapshot) are ignored.
+    AddMarketIdAlias(id, market_id, market_id_len);
+  }
+  return id;
+}
+
+/**
+ * @brief Interns the snapshot's market and applies the snapshot to its book.
+ *
+ * @param snap Pointer to a SnapshotMessage.
+ * @return The market ID, or kInvalidMarketId if the registry is full.
+ */
+BookRegistry::MarketId BookRegistry::ApplySnapshot(
+    const SnapshotMessage* snap) {
+  const MarketId id =
+      InternSnapshot(snap->market_ticker_ptr, snap->market_ticker_len,
+                     snap->market_id_ptr, snap->market_id_len);
+  if (id == kInvalidMarketId) {
+    return id;
+  }
+  ORDERBOOK_LATENCY_SCOPE(LatencyOp::kSnapshot, id);
+  const SeqlockWriteScope write(seqlocks_, id);
+  books_[id].ApplySnapshot(snap);
+  QueueTracker* const tracker = queue_tracker(id);
+  if (tracker != nullptr) {
+    tracker->OnSnapshot(books_[id]);
+  }
+  return id;
+}
+
+/**
+ * @brief Interns a compact snapshot's market and applies it to its book.
+ *
+ * @param snap Slot form of a snapshot (identity plus encoding).
+ * @return The market ID, or kInvalidMarketId if the registry is full or
+ *         the encoding is invalid.
+ */
+BookRegistry::MarketId BookRegistry::ApplySnapshot(
+    const CompactSnapshotRef& snap) {
+  CompactSnapshotView view;
+  if (!view.Parse(snap.data, snap.size)) {
+    return kInvalidMarketId;
+  }
+  const MarketId id =
+      InternSnapshot(snap.market_ticker_ptr, snap.market_ticker_len,
+                     snap.market_id_ptr, snap.market_id_len);
+  if (id != kInvalidMarketId) {
+    ApplySnapshot(id, view);
+  }
+  return id;
+}
+
+/**
+ * @brief Applies a snapshot to an already-resolved market.
+ */
+void BookRegistry::ApplySnapshot(MarketId id, const SnapshotMessage* snap) {
+  ORDERBOOK_LATENCY_SCOPE(LatencyOp::kSnapshot, id);
+  const SeqlockWriteScope write(seqlocks_, id);
+  books_[id].ApplySnapshot(snap);
+  QueueTracker* const tracker = queue_tracker(id);
+  if (tracker != nullptr) {
+    tracker->OnSnapshot(books_[id]);
+  }
+}
+
+/**
+ * @brief Applies a compact snapshot to an already-resolved market.
+ */
+void BookRegistry::ApplySnapshot(MarketId id, const CompactSnapshotView& snap) {
+  ORDERBOOK_LATENCY_SCOPE(LatencyOp::kSnapshot, id);
+  const SeqlockWriteScope write(seqlocks_, id);
+  books_[id].ApplySnapshot(snap);
+  QueueTracker* const tracker = queue_tracker(id);
+  if (tracker != nullptr) {
+    tracker->OnSnapshot(books_[id]);
+  }
+}
+
+/**
+ * @brief Applies a delta to an already-resolved market.
+ */
+void BookRegistry::ApplyDelta(MarketId id, const DeltaMessage* msg) {
+  ORDERBOOK_LATENCY_SCOPE(LatencyOp::kDelta, id);
+  const SeqlockWriteScope write(seqlocks_, id);
+  QueueTracker* const tracker = queue_tracker(id);
+  if (tracker != nullptr && AppliesInOrder(books_[id], *msg)) {
+    tracker->OnDelta(*msg);
+  }
+  books_[id].ApplyDelta(msg);
+}
+
+/**
+ * @brief Applies a trade to an already-resolved market.
+ */
+void BookRegistry::ApplyTrade(MarketId id, const TradeMessage* trade) {
+  ORDERBOOK_LATENCY_SCOPE(LatencyOp::kTrade, id);
+  const SeqlockWriteScope write(seqlocks_, id);
+  books_[id].ApplyTrade(trade);
+  if (trade_flow_ != nullptr) {
+    trade_flow_[id].OnTrade(*trade);
+  }
+  QueueTracker* const tracker = queue_tracker(id);
+  if (tracker != nullptr) {
+    tracker->OnTrade(*trade);
+  }
+}
+
+/**
+ * @brief Applies a run of deltas to an already-resolved market.
+ */
+void BookRegistry::ApplyDeltas(MarketId id,
+                               std::span<const DeltaMessage> msgs) {
+  ORDERBOOK_LATENCY_SCOPE(LatencyOp::kDeltaBatch, id);
+  const SeqlockWriteScope write(seqlocks_, id);
+  QueueTracker* const tracker = queue_tracker(id);
+  if (tracker != nullptr) {
+    // Forward what the book will apply in order: unsequenced deltas, and
+    // sequenced ones up to the first break.
+    uint64_t expected = books_[id].IsStale() ? 0U : books_[id].expected_seq();
+    for (const DeltaMessage& msg : msgs) {
+      if (msg.seq == 0U) {
+        tracker->OnDelta(msg);
+      } else if (expected != 0U && msg.seq == expected) {
+        tracker->OnDelta(msg);
+        ++expected;
+      } else if (msg.seq > expected) {
+        expected = 0U;
+      }
+    }
+  }
+  books_[id].ApplyDeltas(msgs);
+}
+
+/**
+ * @brief Resolves a delta's market by ticker and applies it.
+ *
+ * @return The market ID, or kInvalidMarketId if the ticker is unknown.
+ */
+BookRegistry::MarketId BookRegistry::ApplyDelta(const DeltaMessage* msg) {
+  const MarketId id = FindByTicker(msg->market_ticker_ptr,
+                                   msg->market_ticker_len);
+  if (id != kInvalidMarketId) {
+    ApplyDelta(id, msg);
+  }
+  return id;
+}
+
+/**
+ * @brief Resolves a trade's market by ticker and applies it.
+ *
+ * @return The market ID, or kInvalidMarketId if the ticker is unknown.
+ */
+BookRegistry::MarketId BookRegistry::ApplyTrade(const TradeMessage* trade) {
+  const MarketId id = FindByTicker(trade->market_ticker_ptr,
+                                   trade->market_ticker_len);
+  if (id != kInvalidMarketId) {
+    ApplyTrade(id, trade);
+  }
+  return id;
+}
+
+/**
+ * @brief Attaches or detaches a market's queue tracker; the pointer table
+ *        is allocated on first use.
+ */
+void BookRegistry::SetQueueTracker(MarketId id, QueueTracker* tracker) {
+  if (queue_trackers_ == nullptr) {
+    if (tracker == nullptr) return;
+    queue_trackers_ = std::make_unique<QueueTracker*[]>(capacity_);
+  }
+  queue_trackers_[id] = tracker;
+}
+
+/**
+ * @brief Allocates (or resets) one TradeFlow per slot.
+ *
+ * Cold path. Must not race with ApplyTrade.
+ */
+void BookRegistry::EnableTradeFlow(const TradeFlow::Options& options) {
+  trade_flow_ = std::make_unique<TradeFlow[]>(capacity_);
+  for (size_t i = 0; i < capacity_; ++i) {
+    trade_flow_[i] = TradeFlow(options);
+  }
+}
+
+/**
+ * @brief Loads a batch of snapshots in parallel and then marks the registry
+ *        ready.
+ *
+ * Interning mutates the lookup tables, so it runs first on the calling
+ * thread. Worker t then applies every snapshot whose market ID is
+ * congruent to t modulo the thread count; books never share a thread, so
+ * no locking is needed, and joining the workers orders their writes before
+ * the release store of ready_.
+ *
+ * @param snaps Snapshots in feed order (several per market are allowed).
+ * @param thread_count Threads to use including the caller; 0 means
+ *        std::thread::hardware_concurrency().
+ * @return Number of snapshots applied.
+ */
+size_t BookRegistry::ApplySnapshots(std::span<const SnapshotMessage> snaps,
+                                    unsigned int thread_count) {
+  ready_.store(false, std::memory_order_relaxed);
+
+  std::vector<MarketId> ids(snaps.size());
+  size_t applied = 0U;
+  for (size_t i = 0; i < snaps.size(); ++i) {
+    ids[i] = InternSnapshot(snaps[i].market_ticker_ptr,
+                            snaps[i].market_ticker_len,
+                            snaps[i].market_id_ptr, snaps[i].market_id_len);
+    applied += static_cast<size_t>(ids[i] != kInvalidMarketId);
+  }
+
+  if (thread_count == 0U) {
+    thread_count = std::thread::hardware_concurrency();
+  }
+  if (thread_count == 0U) {
+    thread_count = 1U;
+  }
+  if (thread_count > snaps.size()) {
+    thread_count = snaps.size() > 0U ? static_cast<unsigned int>(snaps.size())
+                                     : 1U;
+  }
+
+  auto load_partition = [this, snaps, &ids, thread_count](unsigned int part) {
+    for (size_t i = 0; i < snaps.size(); ++i) {
+      const MarketId id = ids[i];
+      if (id != kInvalidMarketId && id % thread_count == part) {
+        ORDERBOOK_LATENCY_SCOPE(LatencyOp::kSnapshot, id);
+        const SeqlockWriteScope write(seqlocks_, id);
+        books_[id].ApplySnapshot(&snaps[i]);
+        QueueTracker* const tracker = queue_tracker(id);
+        if (tracker != nullptr) {
+          tracker->OnSnapshot(books_[id]);
+        }
+      }
+    }
+  };
+
+  std::vector<std::thread> workers;
+  workers.reserve(thread_count - 1U);
+  for (unsigned int part = 1; part < thread_count; ++part) {
+    workers.emplace_back(load_partition, part);
+  }
+  load_partition(0U);
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+
+  ready_.store(true, std::memory_order_release);
+  return applied;
+}
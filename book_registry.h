@@ -0,0 +1,241 @@
+#ifndef PROJECT_BOOK_REGISTRY_H_
+#define PROJECT_BOOK_REGISTRY_H_
+
+#include <atomic>   // for std::atomic
+#include <cstddef>  // for size_t
+#include <memory>   // for std::unique_ptr
+#include <cstdint>  // for uint32_t, uint64_t
+#include <span>     // for std::span
+#include <vector>   // for std::vector
+#include "compact_snapshot.h"
+#include "message_types.h"
+#include "orderbook.h"
+#include "queue_tracker.h"
+#include "top_of_book.h"
+#include "trade_flow.h"
+
+/**
+ * @class BookRegistry
+ *
+ * @brief Owns one OrderBook per market and maps venue identifiers to dense
+ *        integer market IDs.
+ *
+ * Tickers (and market IDs, when present) are interned once, normally on the
+ * first snapshot for a market, and exchanged for a MarketId in
+ * [0, capacity). Books live in a single contiguous slab aligned to 64
+ * bytes, so MarketId -> OrderBook is a plain index and the per-message
+ * dispatch path (ApplyDelta(id, msg) etc.) never hashes a string.
+ *
+ * Capacity is fixed at construction; books are never moved, so references
+ * returned by book() stay valid for the registry's lifetime.
+ *
+ * Warm start: ApplySnapshots loads a whole batch (session start, reconnect)
+ * across several threads and then flips ready() to true with release
+ * semantics. Other threads should not read books until they observe
+ * ready() (acquire).
+ */
+class BookRegistry
+{
+public:
+  using MarketId = uint32_t;
+  static constexpr MarketId kInvalidMarketId = UINT32_MAX;
+
+  explicit BookRegistry(size_t capacity);
+  /**
+   * @brief Builds the books in caller-owned storage (e.g. a shared memory
+   *        segment): @p slab must be 64-byte aligned, SlabBytes(capacity)
+   *        long, and outlive the registry.
+   */
+  BookRegistry(size_t capacity, void* slab);
+  ~BookRegistry();
+
+  /// Bytes of book storage a registry of @p capacity needs.
+  static size_t SlabBytes(size_t capacity)
+  {
+    return sizeof(OrderBook) * capacity;
+  }
+
+  BookRegistry(const BookRegistry&) = delete;
+  BookRegistry& operator=(const BookRegistry&) = delete;
+
+  /// Returns the ID for @p ticker, assigning a new one on first sighting.
+  /// Returns kInvalidMarketId once the registry is full.
+  MarketId Intern(const char* ticker, size_t ticker_len);
+
+  /// Lookup without interning. Returns kInvalidMarketId if unknown.
+  MarketId FindByTicker(const char* ticker, size_t ticker_len) const;
+  MarketId FindByMarketId(const char* market_id, size_t market_id_len) const;
+
+  /// Registers @p market_id as another name for @p id (FindByMarketId).
+  /// Returns false if the alias is already registered, or if capacity()
+  /// aliases already are.
+  bool AddMarketIdAlias(MarketId id, const char* market_id,
+                        size_t market_id_len);
+
+  /**
+   * @brief Calls fn(MarketId, const char* key, size_t key_len) for every
+   *        interned ticker / market_id alias, in table order.
+   */
+  template <typename Fn>
+  void ForEachTicker(Fn&& fn) const
+  {
+    tickers_.ForEach(fn);
+  }
+  template <typename Fn>
+  void ForEachMarketIdAlias(Fn&& fn) const
+  {
+    market_ids_.ForEach(fn);
+  }
+
+  /// Interns the snapshot's ticker (and market_id alias) and applies it.
+  MarketId ApplySnapshot(const SnapshotMessage* snap);
+  /// Same for a ring slot's compact snapshot; kInvalidMarketId if the
+  /// registry is full or the encoding does not parse.
+  MarketId ApplySnapshot(const CompactSnapshotRef& snap);
+
+  /// O(1) dispatch paths for callers that have already resolved the ID.
+  void ApplySnapshot(MarketId id, const SnapshotMessage* snap);
+  void ApplySnapshot(MarketId id, const CompactSnapshotView& snap);
+  void ApplyDelta(MarketId id, const DeltaMessage* msg);
+  void ApplyTrade(MarketId id, const TradeMessage* trade);
+  void ApplyDeltas(MarketId id, std::span<const DeltaMessage> msgs);
+
+  /**
+   * @brief Bulk warm start: interns every snapshot's market on the calling
+   *        thread, then applies the batch on up to @p thread_count threads
+   *        (the caller is one of them; 0 = hardware concurrency).
+   *
+   * Markets are partitioned by ID, so each book is built by exactly one
+   * thread and a market's snapshots apply in batch order. ready() reads
+   * false for the duration and true once every book is loaded. Blocks
+   * until done; no other registry call may run concurrently.
+   *
+   * @return Snapshots applied (those whose market fit in the registry).
+   */
+  size_t ApplySnapshots(std::span<const SnapshotMessage> snaps,
+                        unsigned int thread_count = 0U);
+
+  /**
+   * @brief Opts in to per-market trade aggregation: from now on every
+   *        ApplyTrade also feeds the market's TradeFlow. Allocates one
+   *        TradeFlow per slot (about 7 KB each); calling it again resets
+   *        them with the new options.
+   */
+  void EnableTradeFlow(const TradeFlow::Options& options);
+  /// The market's aggregator, or nullptr unless EnableTradeFlow was called.
+  const TradeFlow* trade_flow(MarketId id) const
+  {
+    return trade_flow_ != nullptr ? &trade_flow_[id] : nullptr;
+  }
+
+  /**
+   * @brief Feeds market @p id's messages to @p tracker (caller-owned; pass
+   *        nullptr to detach) right after its book applies them. Deltas the
+   *        book buffers or drops as duplicates are not forwarded; the next
+   *        snapshot re-anchors the tracker instead.
+   */
+  void SetQueueTracker(MarketId id, QueueTracker* tracker);
+  QueueTracker* queue_tracker(MarketId id) const
+  {
+    return queue_trackers_ != nullptr ? queue_trackers_[id] : nullptr;
+  }
+
+  /**
+   * @brief Opts in to per-book seqlocks: every Apply* call below brackets
+   *        its book update with seqlocks[id].BeginWrite/EndWrite, so other
+   *        threads or processes can read books in place (OrderBookView).
+   *
+   * @p seqlocks must have capacity() entries and outlive the registry;
+   * nullptr turns it off. Code that mutates book(id) directly bypasses it.
+   */
+  void SetSeqlocks(BookSeqlock* seqlocks) { seqlocks_ = seqlocks; }
+
+  /// True once a bulk load has completed (or after MarkReady).
+  bool ready() const { return ready_.load(std::memory_order_acquire); }
+  /// Publishes the registry as ready without a bulk load, e.g. after
+  /// building it snapshot by snapshot.
+  void MarkReady() { ready_.store(true, std::memory_order_release); }
+
+  /// Resolves the ID from the message's ticker, then dispatches.
+  /// Returns the ID used, or kInvalidMarketId if the market is unknown.
+  MarketId ApplyDelta(const DeltaMessage* msg);
+  MarketId ApplyTrade(const TradeMessage* trade);
+
+  OrderBook& book(MarketId id) { return books_[id]; }
+  const OrderBook& book(MarketId id) const { return books_[id]; }
+
+  /// Number of interned markets.
+  size_t size() const { return size_; }
+  size_t capacity() const { return capacity_; }
+
+private:
+  /**
+   * @brief Open-addressed string -> MarketId table with its own key storage.
+   *        Sized at construction and never rehashed.
+   */
+  class InternTable
+  {
+  public:
+    explicit InternTable(size_t capacity);
+
+    MarketId Find(const char* key, size_t key_len, uint64_t hash) const;
+    /// Inserts key -> id. Returns false if the key already exists or the
+    /// table already holds its capacity.
+    bool Insert(const char* key, size_t key_len, uint64_t hash, MarketId id);
+
+    /// Calls fn(id, key, key_len) for every occupied slot.
+    template <typename Fn>
+    void ForEach(Fn&& fn) const
+    {
+      for (const Slot& slot : slots_) {
+        if (slot.id != kInvalidMarketId) {
+          fn(slot.id, key_bytes_.data() + slot.key_offset,
+             static_cast<size_t>(slot.key_len));
+        }
+      }
+    }
+
+  private:
+    struct Slot {
+      uint64_t hash;
+      uint32_t key_offset;
+      uint32_t key_len;
+      MarketId id;  // kInvalidMarketId when the slot is empty.
+    };
+
+    std::vector<Slot> slots_;
+    std::vector<char> key_bytes_;
+    size_t mask_;
+    /// Keys accepted before Insert refuses (keeps load <= 50%).
+    size_t capacity_;
+    size_t size_;
+  };
+
+  static uint64_t Hash(const char* key, size_t key_len);
+
+  /// Interns a snapshot's ticker and market_id alias (not thread-safe).
+  MarketId InternSnapshot(const char* ticker, size_t ticker_len,
+                          const char* market_id, size_t market_id_len);
+
+  OrderBook* books_;
+  /// False when the slab was passed in by the caller.
+  bool owns_slab_;
+  size_t capacity_;
+  size_t size_;
+
+  InternTable tickers_;
+  InternTable market_ids_;
+
+  std::atomic<bool> ready_;
+
+  /// Per-slot trade aggregators; null until EnableTradeFlow.
+  std::unique_ptr<TradeFlow[]> trade_flow_;
+
+  /// Per-slot queue trackers (not owned); null until SetQueueTracker.
+  std::unique_ptr<QueueTracker*[]> queue_trackers_;
+
+  /// Per-slot write versions; null unless SetSeqlocks was called.
+  BookSeqlock* seqlocks_;
+};
+
+#endif  // PROJECT_BOOK_REGISTRY_H_
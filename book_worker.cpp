@@ -0,0 +1,186 @@
+#include "book_worker.h"
+
+#include "thread_util.h"
+
+// =============================================================================
+// BookWorker Method Definitions
+// =============================================================================
+
+/**
+ * @brief Creates a stopped worker for @p registry; allocates the ring.
+ *
+ * @param registry Registry this worker will own while running.
+ * @param options Pinning, wait policy and batching configuration.
+ */
+BookWorker::BookWorker(BookRegistry* registry, const Options& options)
+    : registry_(registry),
+      options_(options),
+      ring_(options.ring_capacity) {}
+
+/**
+ * @brief Stops the worker if it is still running.
+ */
+BookWorker::~BookWorker() {
+  Stop();
+}
+
+/**
+ * @brief Launches the (optionally pinned) worker thread.
+ */
+void BookWorker::Start() {
+  if (running_.exchange(true)) return;
+  thread_ = std::thread([this] {
+    PinCurrentThread(options_.core);
+    Run();
+  });
+}
+
+/**
+ * @brief Requests shutdown, wakes the worker, and joins it. Messages already
+ *        committed to the ring are applied before the thread exits.
+ */
+void BookWorker::Stop() {
+  if (!running_.exchange(false)) return;
+  sleeping_.store(0U, std::memory_order_seq_cst);
+  sleeping_.notify_one();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+/**
+ * @brief Publishes the slot obtained from BeginWrite.
+ */
+void BookWorker::CommitWrite() {
+  ring_.CommitWrite();
+  if (options_.wait_policy == WaitPolicy::kFutexWait) {
+    WakeIfSleeping();
+  }
+}
+
+/**
+ * @brief Copies a whole slot into the ring.
+ *
+ * @return False if the ring is full.
+ */
+bool BookWorker::TryPush(const MessageSlot& slot) {
+  MessageSlot* dest = ring_.BeginWrite();
+  if (dest == nullptr) return false;
+  *dest = slot;
+  CommitWrite();
+  return true;
+}
+
+/**
+ * @brief Applies one slot to the registry.
+ *
+ * Unresolved snapshots intern their ticker; unresolved deltas and trades are
+ * looked up by ticker and dropped if the market has never been seen.
+ *
+ * @param registry Target registry.
+ * @param slot Message to apply.
+ * @return False if the market could not be resolved (or a snapshot's
+ *         encoding is invalid).
+ */
+bool BookWorker::Dispatch(BookRegistry* registry, const MessageSlot& slot) {
+  const BookRegistry::MarketId id = slot.market_id;
+  const bool resolved = id != MessageSlot::kUnresolvedMarketId;
+
+  switch (slot.type) {
+    case MessageType::kDelta:
+      if (resolved) {
+        registry->ApplyDelta(id, &slot.delta);
+        return true;
+      }
+      return registry->ApplyDelta(&slot.delta) !=
+             BookRegistry::kInvalidMarketId;
+    case MessageType::kTrade:
+      if (resolved) {
+        registry->ApplyTrade(id, &slot.trade);
+        return true;
+      }
+      return registry->ApplyTrade(&slot.trade) !=
+             BookRegistry::kInvalidMarketId;
+    case MessageType::kSnapshot:
+      if (resolved) {
+        CompactSnapshotView view;
+        if (!view.Parse(slot.snapshot.data, slot.snapshot.size)) {
+          return false;
+        }
+        registry->ApplySnapshot(id, view);
+        return true;
+      }
+      return registry->ApplySnapshot(slot.snapshot) !=
+             BookRegistry::kInvalidMarketId;
+    default:
+      return true;  // Nothing to apply.
+  }
+}
+
+/**
+ * @brief Worker loop: drain in batches, then poll or sleep when idle.
+ */
+void BookWorker::Run() {
+  unsigned int idle_polls = 0U;
+  for (;;) {
+    uint64_t misses = 0U;
+    const size_t applied =
+        ring_.Drain(options_.batch_size, [&](const MessageSlot& slot) {
+          misses += Dispatch(registry_, slot) ? 0U : 1U;
+        });
+
+    if (applied != 0U) {
+      // Single writer: plain load/store avoids a locked RMW per batch.
+      processed_.store(processed_.load(std::memory_order_relaxed) + applied,
+                       std::memory_order_relaxed);
+      if (misses != 0U) {
+        unresolved_.store(unresolved_.load(std::memory_order_relaxed) + misses,
+                          std::memory_order_relaxed);
+      }
+      idle_polls = 0U;
+      continue;
+    }
+
+    if (!running_.load(std::memory_order_acquire)) {
+      if (ring_.Empty()) return;
+      continue;
+    }
+
+    if (options_.wait_policy == WaitPolicy::kFutexWait &&
+        ++idle_polls >= options_.spin_iterations) {
+      WaitForWork();
+      idle_polls = 0U;
+    } else {
+      CpuRelax();
+    }
+  }
+}
+
+/**
+ * @brief Sleeps until the producer commits a slot or Stop is called.
+ *
+ * Dekker-style handshake with WakeIfSleeping: we announce sleeping_ = 1 and
+ * then re-check the ring; the producer publishes its tail and then checks
+ * sleeping_. The seq_cst fences ensure at least one side sees the other.
+ */
+void BookWorker::WaitForWork() {
+  sleeping_.store(1U, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (!ring_.Empty() || !running_.load(std::memory_order_acquire)) {
+    sleeping_.store(0U, std::memory_order_relaxed);
+    return;
+  }
+  sleeping_.wait(1U, std::memory_order_acquire);
+}
+
+/**
+ * @brief Producer half of the wakeup handshake; only makes a syscall when
+ *        the worker has announced it is sleeping.
+ */
+void BookWorker::WakeIfSleeping() {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (sleeping_.load(std::memory_order_relaxed) != 0U) {
+    sleeping_.store(0U, std::memory_order_release);
+    sleeping_.notify_one();
+  }
+}
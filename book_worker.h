@@ -0,0 +1,115 @@
+#ifndef PROJECT_BOOK_WORKER_H_
+#define PROJECT_BOOK_WORKER_H_
+
+#include <atomic>  // for std::atomic
+#include <cstddef> // for size_t
+#include <cstdint> // for uint32_t, uint64_t
+#include <thread>  // for std::thread
+#include "book_registry.h"
+#include "message_types.h"
+#include "spsc_ring.h"
+
+/**
+ * @class BookWorker
+ *
+ * @brief Ingestion pipeline stage that owns a BookRegistry and applies
+ *        messages handed to it over a lock-free SPSC ring.
+ *
+ * One producer thread (typically the receive/parse thread) decodes straight
+ * into ring slots via BeginWrite/CommitWrite. A dedicated worker thread,
+ * optionally pinned to a core, drains the ring in batches and dispatches to
+ * the registry. While running, the registry must only be touched from the
+ * worker thread.
+ *
+ * Slots whose market_id is MessageSlot::kUnresolvedMarketId are resolved by
+ * ticker on the worker, so any ticker pointers in a slot, and a snapshot
+ * slot's compact encoding, must stay valid until the worker has consumed it
+ * (MessageArena::EncodeSnapshot and Retain keep them in an arena instead of
+ * the receive buffer).
+ *
+ * Nothing allocates or locks after construction. With WaitPolicy::kFutexWait
+ * the worker sleeps on a futex (C++20 atomic wait) once the ring has been
+ * empty for spin_iterations polls, and the producer only issues a wake
+ * syscall when the worker is actually asleep.
+ */
+class BookWorker
+{
+public:
+  enum class WaitPolicy {
+    kBusyPoll = 0,
+    kFutexWait,
+  };
+
+  struct Options
+  {
+    /// Core to pin the worker thread to; -1 leaves it unpinned.
+    int core = -1;
+    WaitPolicy wait_policy = WaitPolicy::kBusyPoll;
+    /// Ring slots (rounded up to a power of two).
+    size_t ring_capacity = 1024;
+    /// Maximum slots applied per drain.
+    size_t batch_size = 64;
+    /// Empty polls before sleeping under kFutexWait.
+    unsigned int spin_iterations = 4096;
+  };
+
+  BookWorker(BookRegistry *registry, const Options &options);
+  ~BookWorker();
+
+  BookWorker(const BookWorker &) = delete;
+  BookWorker &operator=(const BookWorker &) = delete;
+
+  /// Launches the worker thread.
+  void Start();
+  /// Drains whatever is already in the ring, then joins the worker thread.
+  void Stop();
+
+  // Producer side (single thread).
+
+  /// Next free slot to decode into, or nullptr if the ring is full.
+  MessageSlot *BeginWrite() { return ring_.BeginWrite(); }
+  /// Publishes the slot from BeginWrite and wakes the worker if asleep.
+  void CommitWrite();
+  /// Copies @p slot into the ring. Returns false if full.
+  bool TryPush(const MessageSlot &slot);
+
+  /// Messages applied so far (relaxed; for monitoring).
+  uint64_t processed() const
+  {
+    return processed_.load(std::memory_order_relaxed);
+  }
+
+  /// Messages dropped because their market could not be resolved.
+  uint64_t unresolved() const
+  {
+    return unresolved_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Applies one slot to @p registry. Exposed so other drivers (e.g.
+   *        replay) share exactly the worker's dispatch logic.
+   *
+   * @return False if the slot's market could not be resolved or its
+   *         snapshot encoding is invalid.
+   */
+  static bool Dispatch(BookRegistry *registry, const MessageSlot &slot);
+
+private:
+  void Run();
+  /// Blocks until the ring is non-empty or Stop has been requested.
+  void WaitForWork();
+  void WakeIfSleeping();
+
+  BookRegistry *const registry_;
+  const Options options_;
+  SpscRing<MessageSlot> ring_;
+  std::thread thread_;
+
+  std::atomic<bool> running_{false};
+  /// 1 while the worker is (about to be) blocked in WaitForWork.
+  alignas(64) std::atomic<uint32_t> sleeping_{0};
+  alignas(64) std::atomic<uint64_t> processed_{0};
+  std::atomic<uint64_t> unresolved_{0};
+};
+
+#endif // PROJECT_BOOK_WORKER_H_
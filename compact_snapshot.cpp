@@ -0,0 +1,93 @@
+#include "compact_snapshot.h"
+
+#include <cstring>  // for std::memcpy, std::memset
+
+namespace {
+
+/**
+ * @brief Required alignment of encoded buffers.
+ */
+constexpr uintptr_t kAlignment = 4U;
+
+inline bool IsAligned(const void* ptr) {
+  return (reinterpret_cast<uintptr_t>(ptr) & (kAlignment - 1U)) == 0U;
+}
+
+}  // namespace
+
+/**
+ * @brief Encodes a snapshot into the compact variable-length layout.
+ *
+ * @param snap Source snapshot.
+ * @param out 4-byte-aligned destination buffer.
+ * @param capacity Size of @p out in bytes.
+ * @return Bytes written, or 0 on failure.
+ */
+size_t EncodeCompactSnapshot(const SnapshotMessage& snap, uint8_t* out,
+                             size_t capacity) {
+  if (snap.yes_count < 0 || snap.yes_count > kMaxBookLevels ||
+      snap.no_count < 0 || snap.no_count > kMaxBookLevels || !IsAligned(out)) {
+    return 0U;
+  }
+  const size_t yes_count = static_cast<size_t>(snap.yes_count);
+  const size_t no_count = static_cast<size_t>(snap.no_count);
+  const size_t size = CompactSnapshotSize(yes_count, no_count);
+  if (size > capacity) {
+    return 0U;
+  }
+
+  CompactSnapshotHeader header;
+  header.size_bytes = static_cast<uint32_t>(size);
+  header.yes_count = static_cast<uint16_t>(yes_count);
+  header.no_count = static_cast<uint16_t>(no_count);
+  header.seq = snap.seq;
+  std::memcpy(out, &header, sizeof(header));
+
+  uint8_t* cursor = out + sizeof(header);
+  std::memcpy(cursor, snap.yes_qty, yes_count * sizeof(uint32_t));
+  cursor += yes_count * sizeof(uint32_t);
+  std::memcpy(cursor, snap.no_qty, no_count * sizeof(uint32_t));
+  cursor += no_count * sizeof(uint32_t);
+
+  for (size_t i = 0; i < yes_count; ++i) {
+    if (snap.yes_price[i] > 0xFFU) return 0U;
+    *cursor++ = static_cast<uint8_t>(snap.yes_price[i]);
+  }
+  for (size_t i = 0; i < no_count; ++i) {
+    if (snap.no_price[i] > 0xFFU) return 0U;
+    *cursor++ = static_cast<uint8_t>(snap.no_price[i]);
+  }
+
+  std::memset(cursor, 0, static_cast<size_t>(out + size - cursor));
+  return size;
+}
+
+/**
+ * @brief Binds the view to an encoded snapshot after validating it.
+ *
+ * @param data 4-byte-aligned encoding.
+ * @param len Bytes available at @p data (may exceed the encoding).
+ * @return True if the encoding is well formed.
+ */
+bool CompactSnapshotView::Parse(const uint8_t* data, size_t len) {
+  if (!IsAligned(data) || len < sizeof(CompactSnapshotHeader)) {
+    return false;
+  }
+  // The header holds a uint64_t (8-byte alignment) but encodings are only
+  // 4-byte aligned, so it is copied out rather than dereferenced in place.
+  CompactSnapshotHeader header;
+  std::memcpy(&header, data, sizeof(header));
+  if (header.yes_count > kMaxBookLevels || header.no_count > kMaxBookLevels ||
+      header.size_bytes !=
+          CompactSnapshotSize(header.yes_count, header.no_count) ||
+      header.size_bytes > len) {
+    return false;
+  }
+
+  header_ = header;
+  yes_qty_ = reinterpret_cast<const uint32_t*>(data + sizeof(header));
+  no_qty_ = yes_qty_ + header.yes_count;
+  yes_price_ = reinterpret_cast<const uint8_t*>(no_qty_ + header.no_count);
+  no_price_ = yes_price_ + header.yes_count;
+  return true;
+}
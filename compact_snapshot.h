@@ -0,0 +1,98 @@
+#ifndef PROJECT_COMPACT_SNAPSHOT_H_
+#define PROJECT_COMPACT_SNAPSHOT_H_
+
+#include <cstddef>  // for size_t
+#include <cstdint>  // for uint8_t, uint16_t, uint32_t, uint64_t
+#include "message_types.h"
+
+// ---------------------------------------------------------------------------
+// Compact snapshot encoding
+// ---------------------------------------------------------------------------
+/**
+ * @brief Variable-length alternative to SnapshotMessage's fixed arrays.
+ *
+ * Layout (host byte order, 4-byte aligned, total size a multiple of 4):
+ *
+ *   CompactSnapshotHeader                 16 bytes
+ *   uint32_t yes_qty[yes_count]
+ *   uint32_t no_qty[no_count]
+ *   uint8_t  yes_price[yes_count]
+ *   uint8_t  no_price[no_count]
+ *   padding to a multiple of 4
+ *
+ * Quantities come first so they stay naturally aligned. A three-level
+ * market encodes in 48 bytes instead of ~1.6 KB. Market identity is not
+ * part of the encoding; carry it alongside (ticker, MarketId, ...).
+ */
+struct CompactSnapshotHeader {
+  uint32_t size_bytes;  // Whole encoding, header and padding included.
+  uint16_t yes_count;
+  uint16_t no_count;
+  uint64_t seq;
+};
+
+static_assert(sizeof(CompactSnapshotHeader) == 16,
+              "CompactSnapshotHeader layout is part of the format");
+static_assert(kMaxBookLevels <= 256,
+              "Compact snapshot prices are stored as uint8_t");
+
+/**
+ * @brief Encoded size for the given level counts.
+ */
+constexpr size_t CompactSnapshotSize(size_t yes_count, size_t no_count) {
+  return (sizeof(CompactSnapshotHeader) + (yes_count + no_count) * 5U + 3U) &
+         ~static_cast<size_t>(3U);
+}
+
+/// Largest possible encoding (both sides full).
+static constexpr size_t kMaxCompactSnapshotSize =
+    CompactSnapshotSize(kMaxBookLevels, kMaxBookLevels);
+
+/**
+ * @brief Encodes @p snap into @p out.
+ *
+ * @param out Destination; must be 4-byte aligned.
+ * @param capacity Bytes available at @p out.
+ * @return Bytes written, or 0 if @p capacity is too small or the snapshot's
+ *         counts/prices are out of range.
+ */
+size_t EncodeCompactSnapshot(const SnapshotMessage& snap, uint8_t* out,
+                             size_t capacity);
+
+/**
+ * @class CompactSnapshotView
+ *
+ * @brief Zero-copy reader over an encoded compact snapshot.
+ */
+class CompactSnapshotView
+{
+public:
+  /**
+   * @brief Validates and binds to an encoding. The buffer must outlive the
+   *        view.
+   *
+   * @return False if @p data is misaligned, truncated or inconsistent.
+   */
+  bool Parse(const uint8_t* data, size_t len);
+
+  uint64_t seq() const { return header_.seq; }
+  size_t size_bytes() const { return header_.size_bytes; }
+
+  unsigned int yes_count() const { return header_.yes_count; }
+  const uint32_t* yes_qty() const { return yes_qty_; }
+  const uint8_t* yes_price() const { return yes_price_; }
+
+  unsigned int no_count() const { return header_.no_count; }
+  const uint32_t* no_qty() const { return no_qty_; }
+  const uint8_t* no_price() const { return no_price_; }
+
+private:
+  /// Copied out of the encoding, which is only 4-byte aligned.
+  CompactSnapshotHeader header_{};
+  const uint32_t* yes_qty_ = nullptr;
+  const uint32_t* no_qty_ = nullptr;
+  const uint8_t* yes_price_ = nullptr;
+  const uint8_t* no_price_ = nullptr;
+};
+
+#endif  // PROJECT_COMPACT_SNAPSHOT_H_
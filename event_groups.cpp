@@ -0,0 +1,168 @@
+#include "event_groups.h"
+
+namespace {
+
+/**
+ * @brief Moves one leg of a group from @p old_price to @p new_price (0 =
+ *        unquoted) in the running sum, count and extremes.
+ *
+ * @return True if the old price held the min or max, so the extremes must
+ *         be rescanned; otherwise they are already up to date.
+ */
+bool UpdateLeg(unsigned int old_price, unsigned int new_price, uint64_t* sum,
+               uint32_t* count, unsigned int* min, unsigned int* max) {
+  if (old_price == new_price) return false;
+  *sum += static_cast<uint64_t>(new_price) - static_cast<uint64_t>(old_price);
+  *count += static_cast<uint32_t>(new_price != 0U);
+  *count -= static_cast<uint32_t>(old_price != 0U);
+  if (old_price != 0U && (old_price == *min || old_price == *max)) {
+    return true;
+  }
+  if (new_price != 0U) {
+    if (*count == 1U) {
+      *min = new_price;
+      *max = new_price;
+    } else {
+      if (new_price < *min) *min = new_price;
+      if (new_price > *max) *max = new_price;
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+// =============================================================================
+// EventGroups Method Definitions
+// =============================================================================
+
+/**
+ * @brief Creates an empty grouping over @p registry's slots.
+ */
+EventGroups::EventGroups(const BookRegistry* registry)
+    : registry_(registry),
+      group_of_(registry->capacity(), kInvalidGroupId),
+      legs_(registry->capacity()) {}
+
+/**
+ * @brief Adds a group of mutually exclusive markets.
+ *
+ * Cold path: grows the member and group arrays.
+ *
+ * @param members Market IDs of the group's outcomes.
+ * @return The group's ID, or kInvalidGroupId if rejected.
+ */
+EventGroups::GroupId EventGroups::AddGroup(
+    std::span<const BookRegistry::MarketId> members) {
+  if (members.empty()) {
+    return kInvalidGroupId;
+  }
+  for (size_t i = 0; i < members.size(); ++i) {
+    const BookRegistry::MarketId id = members[i];
+    if (id >= group_of_.size() || group_of_[id] != kInvalidGroupId) {
+      return kInvalidGroupId;
+    }
+    for (size_t j = 0; j < i; ++j) {
+      if (members[j] == id) return kInvalidGroupId;
+    }
+  }
+
+  const GroupId group_id = static_cast<GroupId>(groups_.size());
+  Group group;
+  group.first_member = static_cast<uint32_t>(members_.size());
+  group.aggregate.legs = static_cast<uint32_t>(members.size());
+  for (const BookRegistry::MarketId id : members) {
+    members_.push_back(id);
+    group_of_[id] = group_id;
+    const Legs legs = ReadLegs(id);
+    legs_[id] = legs;
+    GroupAggregate& a = group.aggregate;
+    a.sum_best_bid += legs.bid;
+    a.sum_best_yes_ask += legs.yes_ask;
+    a.bid_legs += static_cast<uint32_t>(legs.bid != 0U);
+    a.ask_legs += static_cast<uint32_t>(legs.yes_ask != 0U);
+  }
+  groups_.push_back(group);
+  RescanExtremes(&groups_.back());
+  return group_id;
+}
+
+/**
+ * @brief Picks up a change in one market's top of book.
+ *
+ * Two bit scans and two compares when nothing moved; O(1) group update
+ * otherwise, plus a rescan of the group's cached legs when an extreme leg
+ * moved away.
+ *
+ * @param id A market in the registry.
+ * @return The updated group, or kInvalidGroupId if nothing changed.
+ */
+EventGroups::GroupId EventGroups::Refresh(BookRegistry::MarketId id) {
+  const GroupId group_id = group_of_[id];
+  if (group_id == kInvalidGroupId) {
+    return kInvalidGroupId;
+  }
+  const Legs now = ReadLegs(id);
+  Legs& was = legs_[id];
+  if (now.bid == was.bid && now.yes_ask == was.yes_ask) {
+    return kInvalidGroupId;
+  }
+
+  Group& group = groups_[group_id];
+  GroupAggregate& a = group.aggregate;
+  const bool rescan_bids = UpdateLeg(was.bid, now.bid, &a.sum_best_bid,
+                                     &a.bid_legs, &a.min_bid, &a.max_bid);
+  const bool rescan_asks =
+      UpdateLeg(was.yes_ask, now.yes_ask, &a.sum_best_yes_ask, &a.ask_legs,
+                &a.min_yes_ask, &a.max_yes_ask);
+  was = now;
+  if (rescan_bids | rescan_asks) {
+    RescanExtremes(&group);
+  }
+  ++a.version;
+  return group_id;
+}
+
+/**
+ * @brief Refreshes every market that belongs to a group.
+ */
+void EventGroups::RefreshAll() {
+  for (const BookRegistry::MarketId id : members_) {
+    Refresh(id);
+  }
+}
+
+/**
+ * @brief Best YES bid and best implied YES ask (payout minus the best NO
+ *        bid) of one market; a missing side reads as 0.
+ */
+EventGroups::Legs EventGroups::ReadLegs(BookRegistry::MarketId id) const {
+  const OrderBook& book = registry_->book(id);
+  return Legs{book.BestBid().first, book.BestYesAsk().first};
+}
+
+/**
+ * @brief Recomputes a group's min/max bid and ask from the cached legs.
+ */
+void EventGroups::RescanExtremes(Group* group) const {
+  GroupAggregate& a = group->aggregate;
+  unsigned int min_bid = UINT32_MAX;
+  unsigned int max_bid = 0U;
+  unsigned int min_ask = UINT32_MAX;
+  unsigned int max_ask = 0U;
+  for (uint32_t i = 0; i < a.legs; ++i) {
+    const Legs& legs = legs_[members_[group->first_member + i]];
+    if (legs.bid != 0U) {
+      if (legs.bid < min_bid) min_bid = legs.bid;
+      if (legs.bid > max_bid) max_bid = legs.bid;
+    }
+    if (legs.yes_ask != 0U) {
+      if (legs.yes_ask < min_ask) min_ask = legs.yes_ask;
+      if (legs.yes_ask > max_ask) max_ask = legs.yes_ask;
+    }
+  }
+  a.min_bid = a.bid_legs != 0U ? min_bid : 0U;
+  a.max_bid = max_bid;
+  a.min_yes_ask = a.ask_legs != 0U ? min_ask : 0U;
+  a.max_yes_ask = max_ask;
+}
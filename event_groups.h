@@ -0,0 +1,136 @@
+#ifndef PROJECT_EVENT_GROUPS_H_
+#define PROJECT_EVENT_GROUPS_H_
+
+#include <cstddef>  // for size_t
+#include <cstdint>  // for uint32_t, uint64_t
+#include <span>     // for std::span
+#include <vector>   // for std::vector
+#include "book_registry.h"
+
+/**
+ * @brief Combined best prices of one event group, kept current by
+ *        EventGroups::Refresh.
+ *
+ * Only quoted legs contribute: a member with no YES bid is left out of the
+ * bid sum and min/max, and bid_legs counts the members that are in. The
+ * min/max fields are meaningful only while the matching leg count is
+ * nonzero (0 otherwise).
+ */
+struct GroupAggregate
+{
+  /// Members in the group.
+  uint32_t legs{0};
+  /// Members with a YES bid / with an implied YES ask.
+  uint32_t bid_legs{0};
+  uint32_t ask_legs{0};
+
+  /// Sum over members of the best YES bid and of the best YES ask.
+  uint64_t sum_best_bid{0};
+  uint64_t sum_best_yes_ask{0};
+
+  unsigned int min_bid{0};
+  unsigned int max_bid{0};
+  unsigned int min_yes_ask{0};
+  unsigned int max_yes_ask{0};
+
+  /// Increments whenever any field above changes.
+  uint64_t version{0};
+
+  /// True if every member has a YES bid (the bid sum covers the event).
+  bool all_bids_quoted() const { return bid_legs == legs; }
+  /// True if every member has a YES ask (the ask sum covers the event).
+  bool all_asks_quoted() const { return ask_legs == legs; }
+};
+
+/**
+ * @class EventGroups
+ *
+ * @brief Incremental aggregates over groups of mutually exclusive markets
+ *        in a BookRegistry.
+ *
+ * Each member's legs (best YES bid, best implied YES ask) are cached.
+ * Refresh(id) re-reads them from the book in O(1) and returns straight
+ * away when neither moved, so the group is only touched when a member's
+ * top of book changes. Sums and leg counts are then adjusted in O(1); the
+ * group's min/max are also O(1) unless the leg that held an extreme moves
+ * away from it, in which case the group's cached legs are rescanned.
+ *
+ * Call Refresh for the market after each message applied to it (or
+ * RefreshAll after a bulk load). A market belongs to at most one group.
+ * Sizing is fixed when groups are added; Refresh never allocates. Must run
+ * on the thread that owns the registry.
+ */
+class EventGroups
+{
+public:
+  using GroupId = uint32_t;
+  static constexpr GroupId kInvalidGroupId = UINT32_MAX;
+
+  explicit EventGroups(const BookRegistry *registry);
+
+  /**
+   * @brief Registers a group and seeds its aggregate from the members'
+   *        current books.
+   *
+   * @return The new group's ID, or kInvalidGroupId if @p members is empty,
+   *         names an ID outside the registry, or a market that already
+   *         belongs to a group.
+   */
+  GroupId AddGroup(std::span<const BookRegistry::MarketId> members);
+
+  /**
+   * @brief Re-reads one market's legs and updates its group if they moved.
+   *
+   * @return The market's group if its aggregate changed, otherwise
+   *         kInvalidGroupId (also for markets outside every group).
+   */
+  GroupId Refresh(BookRegistry::MarketId id);
+
+  /// Refreshes every grouped market.
+  void RefreshAll();
+
+  const GroupAggregate &aggregate(GroupId group) const
+  {
+    return groups_[group].aggregate;
+  }
+  std::span<const BookRegistry::MarketId> members(GroupId group) const
+  {
+    const Group &g = groups_[group];
+    return {members_.data() + g.first_member, g.aggregate.legs};
+  }
+  /// Group of @p id, or kInvalidGroupId.
+  GroupId group_of(BookRegistry::MarketId id) const { return group_of_[id]; }
+
+  size_t group_count() const { return groups_.size(); }
+
+private:
+  /// Cached best YES bid and implied YES ask; 0 when the side is empty
+  /// (a bid resting at price 0 is treated as no bid).
+  struct Legs
+  {
+    unsigned int bid{0};
+    unsigned int yes_ask{0};
+  };
+
+  struct Group
+  {
+    uint32_t first_member;
+    GroupAggregate aggregate;
+  };
+
+  /// Reads a market's legs from its book.
+  Legs ReadLegs(BookRegistry::MarketId id) const;
+  /// Recomputes min/max from the cached legs of @p group's members.
+  void RescanExtremes(Group *group) const;
+
+  const BookRegistry *const registry_;
+
+  std::vector<Group> groups_;
+  /// Members of every group, back to back (Group::first_member, legs).
+  std::vector<BookRegistry::MarketId> members_;
+  /// Per registry slot.
+  std::vector<GroupId> group_of_;
+  std::vector<Legs> legs_;
+};
+
+#endif  // PROJECT_EVENT_GROUPS_H_
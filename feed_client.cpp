@@ -0,0 +1,564 @@
+#include "feed_client.h"
+
+#include <cerrno>     // for errno, EAGAIN, EINPROGRESS
+#include <cstdio>     // for std::snprintf
+#include <cstring>    // for std::memcpy, std::memmove, std::strlen
+#include <exception>  // for std::terminate
+#include <random>     // for std::random_device
+#include <utility>    // for std::exchange
+
+#include <arpa/inet.h>    // for inet_pton, htons
+#include <netinet/in.h>   // for sockaddr_in, IPPROTO_TCP
+#include <netinet/tcp.h>  // for TCP_NODELAY
+#include <sys/epoll.h>    // for epoll_create1, epoll_ctl, epoll_wait
+#include <sys/eventfd.h>  // for eventfd
+#include <sys/socket.h>   // for socket, connect, recv, send
+#include <unistd.h>       // for close, read, write
+
+#include "message_decoder.h"
+
+// =============================================================================
+// Coroutine plumbing
+// =============================================================================
+
+/**
+ * @brief Lazily started coroutine returning a bool. Awaiting a Task starts
+ *        it and resumes the awaiter when it finishes (symmetric transfer,
+ *        so nested awaits do not grow the stack). Destroying a Task
+ *        destroys its frame, and with it any Task the frame is awaiting.
+ */
+class FeedClient::Task
+{
+public:
+  struct promise_type
+  {
+    bool result = false;
+    std::coroutine_handle<> continuation;
+
+    Task get_return_object()
+    {
+      return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+    std::suspend_always initial_suspend() noexcept { return {}; }
+
+    struct FinalAwaiter
+    {
+      bool await_ready() noexcept { return false; }
+      std::coroutine_handle<> await_suspend(
+          std::coroutine_handle<promise_type> self) noexcept
+      {
+        const std::coroutine_handle<> next = self.promise().continuation;
+        return next ? next : std::noop_coroutine();
+      }
+      void await_resume() noexcept {}
+    };
+    FinalAwaiter final_suspend() noexcept { return {}; }
+
+    void return_value(bool value) { result = value; }
+    void unhandled_exception() { std::terminate(); }
+  };
+
+  explicit Task(std::coroutine_handle<promise_type> handle) : handle_(handle)
+  {
+  }
+  Task(Task &&other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+  Task(const Task &) = delete;
+  Task &operator=(const Task &) = delete;
+  ~Task()
+  {
+    if (handle_) handle_.destroy();
+  }
+
+  bool await_ready() const { return false; }
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter)
+  {
+    handle_.promise().continuation = awaiter;
+    return handle_;
+  }
+  bool await_resume() const { return handle_.promise().result; }
+
+  /// Runs a top-level Task up to its first suspension.
+  void Start() { handle_.resume(); }
+  bool done() const { return handle_.done(); }
+  bool result() const { return handle_.promise().result; }
+
+private:
+  std::coroutine_handle<promise_type> handle_;
+};
+
+namespace {
+
+constexpr uint64_t kSocketTag = 1U;
+constexpr uint64_t kStopTag = 2U;
+/// Largest upgrade response accepted.
+constexpr size_t kMaxResponseHeader = 16384U;
+
+/**
+ * @brief Suspends until @p ready is latched by the event loop.
+ */
+struct ReadyAwaiter
+{
+  bool *ready;
+  std::coroutine_handle<> *waiter;
+
+  bool await_ready() const { return *ready; }
+  void await_suspend(std::coroutine_handle<> handle) { *waiter = handle; }
+  void await_resume() const {}
+};
+
+/**
+ * @brief Case-insensitive search for header @p name (lowercase, with the
+ *        colon) in [begin, end); returns the trimmed value or nullptr.
+ */
+const char* FindHeader(const char* begin, const char* end, const char* name,
+                       size_t* value_len) {
+  const size_t name_len = std::strlen(name);
+  for (const char* line = begin; line < end;) {
+    const char* eol = line;
+    while (eol < end && *eol != '\r') ++eol;
+    bool match = static_cast<size_t>(eol - line) >= name_len;
+    for (size_t i = 0; match && i < name_len; ++i) {
+      char c = line[i];
+      if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+      match = c == name[i];
+    }
+    if (match) {
+      const char* value = line + name_len;
+      while (value < eol && (*value == ' ' || *value == '\t')) ++value;
+      const char* value_end = eol;
+      while (value_end > value &&
+             (value_end[-1] == ' ' || value_end[-1] == '\t')) {
+        --value_end;
+      }
+      *value_len = static_cast<size_t>(value_end - value);
+      return value;
+    }
+    line = eol + 2;  // Skip "\r\n".
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+// =============================================================================
+// FeedClient Method Definitions
+// =============================================================================
+
+/**
+ * @brief Allocates the receive buffer and the stop eventfd; connects only
+ *        in Run().
+ */
+FeedClient::FeedClient(BookRegistry* registry, const Options& options)
+    : registry_(registry),
+      options_(options),
+      buffer_(new char[options.buffer_bytes]) {
+  stop_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  std::random_device random;
+  mask_state_ = (static_cast<uint64_t>(random()) << 32U) | random() | 1U;
+}
+
+/**
+ * @brief Closes the descriptors.
+ */
+FeedClient::~FeedClient() {
+  if (socket_fd_ >= 0) ::close(socket_fd_);
+  if (epoll_fd_ >= 0) ::close(epoll_fd_);
+  if (stop_fd_ >= 0) ::close(stop_fd_);
+}
+
+/**
+ * @brief Runs one session to completion on the calling thread.
+ */
+bool FeedClient::Run() {
+  stats_ = Stats();
+  used_ = 0U;
+  scan_ = 0U;
+  in_message_ = false;
+  close_received_ = false;
+  close_len_ = 0U;
+  pong_pending_ = false;
+  io_ = IoState();
+  epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+  if (epoll_fd_ < 0 || stop_fd_ < 0) return false;
+  epoll_event event{};
+  event.events = EPOLLIN;
+  event.data.u64 = kStopTag;
+  ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, stop_fd_, &event);
+
+  bool ok = false;
+  {
+    Task session = Session();
+    session.Start();
+    while (!session.done() &&
+           !stop_requested_.load(std::memory_order_acquire)) {
+      Poll();
+    }
+    // Stop() mid-session counts as a clean end; the frame is destroyed
+    // with the Task.
+    ok = session.done() ? session.result() : true;
+  }
+
+  ::close(epoll_fd_);
+  epoll_fd_ = -1;
+  if (socket_fd_ >= 0) ::close(socket_fd_);
+  socket_fd_ = -1;
+  // Drain the eventfd so the next Run() does not wake on a stale Stop().
+  uint64_t drained;
+  [[maybe_unused]] const ssize_t read_len =
+      ::read(stop_fd_, &drained, sizeof(drained));
+  stop_requested_.store(false, std::memory_order_relaxed);
+  return ok;
+}
+
+/**
+ * @brief Flags the stop and wakes the loop through the eventfd.
+ */
+void FeedClient::Stop() {
+  stop_requested_.store(true, std::memory_order_release);
+  const uint64_t one = 1U;
+  [[maybe_unused]] const ssize_t written =
+      ::write(stop_fd_, &one, sizeof(one));
+}
+
+/**
+ * @brief Waits for up to kMaxEvents events and resumes their waiters.
+ */
+void FeedClient::Poll() {
+  epoll_event events[kMaxEvents];
+  const int ready = ::epoll_wait(epoll_fd_, events, kMaxEvents, -1);
+  bool socket_event = false;
+  for (int i = 0; i < ready; ++i) {
+    if (events[i].data.u64 == kStopTag) continue;  // Loop checks the flag.
+    socket_event = true;
+    const uint32_t flags = events[i].events;
+    if ((flags & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) != 0U) {
+      io_.readable = true;
+    }
+    if ((flags & (EPOLLOUT | EPOLLHUP | EPOLLERR)) != 0U) {
+      io_.writable = true;
+    }
+  }
+  stats_.wakeups += socket_event ? 1U : 0U;
+  // Resume after latching everything: a resumed coroutine may await the
+  // other direction straight away.
+  if (io_.readable && io_.reader) std::exchange(io_.reader, {}).resume();
+  if (io_.writable && io_.writer) std::exchange(io_.writer, {}).resume();
+}
+
+/**
+ * @brief The whole session: connect, upgrade, subscribe, read.
+ */
+FeedClient::Task FeedClient::Session() {
+  if (!co_await Connect()) co_return false;
+  if (!co_await Handshake()) co_return false;
+  for (const std::string& command : options_.subscribe) {
+    if (!co_await SendFrame(WsOpcode::kText, command.data(), command.size())) {
+      co_return false;
+    }
+  }
+  co_return co_await ReadLoop();
+}
+
+/**
+ * @brief Non-blocking connect, completed on the first writable edge.
+ */
+FeedClient::Task FeedClient::Connect() {
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(options_.port);
+  if (::inet_pton(AF_INET, options_.address, &addr.sin_addr) != 1) {
+    co_return false;
+  }
+  socket_fd_ = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (socket_fd_ < 0) co_return false;
+  const int one = 1;
+  ::setsockopt(socket_fd_, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  if (options_.socket_receive_buffer > 0) {
+    ::setsockopt(socket_fd_, SOL_SOCKET, SO_RCVBUF,
+                 &options_.socket_receive_buffer,
+                 sizeof(options_.socket_receive_buffer));
+  }
+  if (::connect(socket_fd_, reinterpret_cast<const sockaddr*>(&addr),
+                sizeof(addr)) != 0 &&
+      errno != EINPROGRESS) {
+    co_return false;
+  }
+  // Registered after connect: an unconnected socket reports EPOLLHUP.
+  epoll_event event{};
+  event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+  event.data.u64 = kSocketTag;
+  if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, socket_fd_, &event) != 0) {
+    co_return false;
+  }
+  co_await ReadyAwaiter{&io_.writable, &io_.writer};
+  int error = 0;
+  socklen_t error_len = sizeof(error);
+  ::getsockopt(socket_fd_, SOL_SOCKET, SO_ERROR, &error, &error_len);
+  co_return error == 0;
+}
+
+/**
+ * @brief Sends the upgrade request and validates the 101 response,
+ *        including Sec-WebSocket-Accept. Bytes after the response header
+ *        stay in the buffer as the first frames.
+ */
+FeedClient::Task FeedClient::Handshake() {
+  uint8_t nonce[16];
+  for (unsigned int i = 0; i < sizeof(nonce); i += 4U) {
+    const uint32_t word = NextMaskKey();
+    std::memcpy(nonce + i, &word, sizeof(word));
+  }
+  char key[kWsKeyLen];
+  WsEncodeKey(nonce, key);
+  char expected_accept[kWsAcceptLen];
+  WsAcceptKey(key, sizeof(key), expected_accept);
+
+  send_buffer_.resize(1024U + std::strlen(options_.path) +
+                      std::strlen(options_.host) +
+                      std::strlen(options_.extra_headers));
+  const int request_len = std::snprintf(
+      send_buffer_.data(), send_buffer_.size(),
+      "GET %s HTTP/1.1\r\n"
+      "Host: %s\r\n"
+      "Upgrade: websocket\r\n"
+      "Connection: Upgrade\r\n"
+      "Sec-WebSocket-Key: %.*s\r\n"
+      "Sec-WebSocket-Version: 13\r\n"
+      "%s\r\n",
+      options_.path, options_.host, static_cast<int>(kWsKeyLen), key,
+      options_.extra_headers);
+  if (request_len <= 0 ||
+      static_cast<size_t>(request_len) >= send_buffer_.size()) {
+    co_return false;
+  }
+  if (!co_await SendAll(send_buffer_.data(),
+                        static_cast<size_t>(request_len))) {
+    co_return false;
+  }
+
+  const char* header_end = nullptr;
+  while (header_end == nullptr) {
+    const int filled = Fill();
+    if (filled < 0) co_return false;
+    if (filled == 0) {
+      co_await ReadyAwaiter{&io_.readable, &io_.reader};
+      continue;
+    }
+    for (size_t i = 3U; i < used_; ++i) {
+      if (std::memcmp(buffer_.get() + i - 3U, "\r\n\r\n", 4U) == 0) {
+        header_end = buffer_.get() + i + 1U;
+        break;
+      }
+    }
+    if (header_end == nullptr && used_ >= kMaxResponseHeader) co_return false;
+  }
+
+  const char* response = buffer_.get();
+  if (header_end - response < 12 ||
+      (std::memcmp(response, "HTTP/1.1 101", 12U) != 0 &&
+       std::memcmp(response, "HTTP/1.0 101", 12U) != 0)) {
+    co_return false;
+  }
+  size_t accept_len = 0U;
+  const char* accept = FindHeader(response, header_end,
+                                  "sec-websocket-accept:", &accept_len);
+  if (accept == nullptr || accept_len != kWsAcceptLen ||
+      std::memcmp(accept, expected_accept, kWsAcceptLen) != 0) {
+    co_return false;
+  }
+  const size_t consumed = static_cast<size_t>(header_end - response);
+  std::memmove(buffer_.get(), header_end, used_ - consumed);
+  used_ -= consumed;
+  co_return true;
+}
+
+/**
+ * @brief Sends one masked frame.
+ */
+FeedClient::Task FeedClient::SendFrame(WsOpcode opcode, const char* payload,
+                                       size_t len) {
+  send_buffer_.resize(len + kMaxWsHeaderBytes);
+  const size_t frame_len = EncodeWsFrame(opcode, payload, len, NextMaskKey(),
+                                         send_buffer_.data(),
+                                         send_buffer_.size());
+  co_return co_await SendAll(send_buffer_.data(), frame_len);
+}
+
+/**
+ * @brief Writes all of @p data, suspending whenever the socket is full.
+ */
+FeedClient::Task FeedClient::SendAll(const char* data, size_t len) {
+  while (len != 0U) {
+    const ssize_t sent = ::send(socket_fd_, data, len, MSG_NOSIGNAL);
+    if (sent > 0) {
+      data += sent;
+      len -= static_cast<size_t>(sent);
+      continue;
+    }
+    if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      io_.writable = false;
+      co_await ReadyAwaiter{&io_.writable, &io_.writer};
+      continue;
+    }
+    if (sent < 0 && errno == EINTR) continue;
+    co_return false;
+  }
+  co_return true;
+}
+
+/**
+ * @brief Drains the socket into the free tail of the buffer.
+ */
+int FeedClient::Fill() {
+  bool got_data = false;
+  const size_t capacity = options_.buffer_bytes;
+  while (used_ < capacity) {
+    const ssize_t received =
+        ::recv(socket_fd_, buffer_.get() + used_, capacity - used_, 0);
+    ++stats_.recv_calls;
+    if (received > 0) {
+      used_ += static_cast<size_t>(received);
+      stats_.bytes += static_cast<uint64_t>(received);
+      got_data = true;
+      continue;
+    }
+    if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      io_.readable = false;
+      return got_data ? 1 : 0;
+    }
+    if (received < 0 && errno == EINTR) continue;
+    // EOF or error: hand over what we have first.
+    return got_data ? 1 : -1;
+  }
+  return 1;
+}
+
+/**
+ * @brief Reads batches and applies them until the websocket closes.
+ */
+FeedClient::Task FeedClient::ReadLoop() {
+  for (;;) {
+    if (!ProcessFrames()) co_return false;
+    if (pong_pending_) {
+      pong_pending_ = false;
+      if (!co_await SendFrame(WsOpcode::kPong, pong_payload_, pong_len_)) {
+        co_return false;
+      }
+    }
+    if (close_received_) {
+      // Echo the status code (if any) and end the session.
+      co_await SendFrame(WsOpcode::kClose, close_code_, close_len_);
+      co_return true;
+    }
+
+    const int filled = Fill();
+    if (filled < 0) co_return false;  // TCP closed without a close frame.
+    if (filled == 0) {
+      co_await ReadyAwaiter{&io_.readable, &io_.reader};
+    }
+  }
+}
+
+/**
+ * @brief Parses every complete frame from scan_, applies data messages,
+ *        then compacts the buffer down to what is still needed.
+ */
+bool FeedClient::ProcessFrames() {
+  char* const buffer = buffer_.get();
+  const size_t max_payload = options_.buffer_bytes - kMaxWsHeaderBytes;
+  while (!close_received_) {
+    WsFrame frame;
+    const WsParseResult parsed =
+        ParseWsFrame(buffer + scan_, used_ - scan_, max_payload, &frame);
+    if (parsed == WsParseResult::kIncomplete) break;
+    if (parsed == WsParseResult::kError) return false;
+    ++stats_.frames;
+
+    switch (frame.opcode) {
+      case WsOpcode::kText:
+      case WsOpcode::kBinary:
+        if (in_message_) return false;
+        if (frame.fin) {
+          Deliver(frame.payload, frame.payload_len);
+        } else {
+          in_message_ = true;
+          message_offset_ = static_cast<size_t>(frame.payload - buffer);
+          message_len_ = frame.payload_len;
+        }
+        break;
+      case WsOpcode::kContinuation:
+        if (!in_message_) return false;
+        // The destination is below the payload: at least this frame's
+        // header lies in between.
+        std::memmove(buffer + message_offset_ + message_len_, frame.payload,
+                     frame.payload_len);
+        message_len_ += frame.payload_len;
+        if (frame.fin) {
+          in_message_ = false;
+          Deliver(buffer + message_offset_, message_len_);
+        }
+        break;
+      case WsOpcode::kPing:
+        ++stats_.pings;
+        pong_pending_ = true;
+        pong_len_ = frame.payload_len;
+        std::memcpy(pong_payload_, frame.payload, frame.payload_len);
+        break;
+      case WsOpcode::kClose:
+        close_received_ = true;
+        // Only the 2-byte status code is echoed.
+        close_len_ = frame.payload_len < 2U ? 0U : 2U;
+        std::memcpy(close_code_, frame.payload, close_len_);
+        break;
+      default:
+        break;  // Pong.
+    }
+    scan_ += frame.frame_len;
+  }
+
+  const size_t keep_from = in_message_ ? message_offset_ : scan_;
+  std::memmove(buffer, buffer + keep_from, used_ - keep_from);
+  used_ -= keep_from;
+  scan_ -= keep_from;
+  if (in_message_) message_offset_ = 0U;
+  // A message that cannot fit even in an otherwise empty buffer.
+  return used_ < options_.buffer_bytes;
+}
+
+/**
+ * @brief Decodes one payload in place and applies it. There is no ring in
+ *        between, so snapshots take the fixed-array path and skip the
+ *        compact encoding a MessageSlot would need.
+ */
+void FeedClient::Deliver(const char* data, size_t len) {
+  SnapshotMessage snapshot;
+  DeltaMessage delta;
+  TradeMessage trade;
+  BookRegistry::MarketId id;
+  switch (DecodeMessage(data, len, &snapshot, &delta, &trade)) {
+    case MessageType::kSnapshot:
+      id = registry_->ApplySnapshot(&snapshot);
+      break;
+    case MessageType::kDelta:
+      id = registry_->ApplyDelta(&delta);
+      break;
+    case MessageType::kTrade:
+      id = registry_->ApplyTrade(&trade);
+      break;
+    default:
+      ++stats_.ignored;
+      return;
+  }
+  ++stats_.messages;
+  stats_.unresolved += id == BookRegistry::kInvalidMarketId ? 1U : 0U;
+}
+
+/**
+ * @brief xorshift64* for frame masks and the handshake nonce.
+ */
+uint32_t FeedClient::NextMaskKey() {
+  mask_state_ ^= mask_state_ >> 12U;
+  mask_state_ ^= mask_state_ << 25U;
+  mask_state_ ^= mask_state_ >> 27U;
+  return static_cast<uint32_t>((mask_state_ * 2685821657736338717ULL) >> 32U);
+}
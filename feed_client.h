@@ -0,0 +1,156 @@
+#ifndef PROJECT_FEED_CLIENT_H_
+#define PROJECT_FEED_CLIENT_H_
+
+#include <atomic>     // for std::atomic
+#include <coroutine>  // for std::coroutine_handle
+#include <cstddef>    // for size_t
+#include <cstdint>    // for uint16_t, uint64_t
+#include <memory>     // for std::unique_ptr
+#include <string>     // for std::string
+#include <vector>     // for std::vector
+#include "book_registry.h"
+#include "websocket.h"
+
+/**
+ * @class FeedClient
+ *
+ * @brief Single-threaded websocket ingest loop: receives the venue feed,
+ *        decodes each message in place in the receive buffer and applies it
+ *        to a BookRegistry, with no copy of the payload in between.
+ *
+ * The session (connect, HTTP upgrade, subscribe, read loop) is a C++20
+ * coroutine that suspends on socket readiness; Run() drives it from an
+ * edge-triggered epoll loop handling up to kMaxEvents completions per
+ * wakeup. Each readable edge drains the socket with back-to-back recv
+ * calls until EAGAIN (or the buffer is full), then parses every complete
+ * frame in the batch, so a busy socket costs one epoll_wait per batch
+ * rather than per message.
+ *
+ * Frames are parsed in place; fragmented messages are reassembled in place
+ * by moving continuation payloads down over the intervening headers.
+ * Tickers in decoded messages point into the buffer, so messages are
+ * applied before the buffer moves (BookRegistry copies tickers it
+ * interns). Pings are answered; a close frame is echoed and ends the
+ * session.
+ *
+ * Plain ws:// over IPv4 only: terminate TLS in a local proxy. io_uring
+ * is not used, to keep the build dependency-free.
+ */
+class FeedClient
+{
+public:
+  static constexpr unsigned int kMaxEvents = 64;
+
+  struct Options
+  {
+    /// IPv4 address literal and port of the websocket endpoint.
+    const char *address = "127.0.0.1";
+    uint16_t port = 80;
+    /// Host header and request path of the upgrade request.
+    const char *host = "localhost";
+    const char *path = "/";
+    /// Extra request header lines (e.g. auth), each ending in "\r\n".
+    const char *extra_headers = "";
+    /// Text frames sent once the upgrade succeeds (subscribe commands).
+    std::vector<std::string> subscribe;
+    /// Receive buffer; also the largest message accepted.
+    size_t buffer_bytes = 1U << 20U;
+    /// SO_RCVBUF, or 0 for the system default.
+    int socket_receive_buffer = 0;
+  };
+
+  struct Stats
+  {
+    /// epoll_wait calls that returned at least one socket event.
+    uint64_t wakeups{0};
+    uint64_t recv_calls{0};
+    uint64_t bytes{0};
+    uint64_t frames{0};
+    /// Payloads applied to the registry.
+    uint64_t messages{0};
+    /// Payloads that were not book messages (acks, errors, heartbeats).
+    uint64_t ignored{0};
+    /// Book messages for a market the registry does not know.
+    uint64_t unresolved{0};
+    uint64_t pings{0};
+  };
+
+  FeedClient(BookRegistry *registry, const Options &options);
+  ~FeedClient();
+
+  FeedClient(const FeedClient &) = delete;
+  FeedClient &operator=(const FeedClient &) = delete;
+
+  /**
+   * @brief Connects and processes the feed on the calling thread until the
+   *        server closes the websocket or Stop() is called.
+   *
+   * @return True for a clean end (close handshake or Stop), false if the
+   *         connection, the upgrade or the protocol failed.
+   */
+  bool Run();
+
+  /// Makes Run() return at its next wakeup. Safe from any thread.
+  void Stop();
+
+  /// Counters of the current/last Run (read after Run returns).
+  const Stats &stats() const { return stats_; }
+
+private:
+  class Task;
+
+  /// Readiness latched from epoll plus the coroutine waiting for it.
+  struct IoState
+  {
+    bool readable = false;
+    bool writable = false;
+    std::coroutine_handle<> reader;
+    std::coroutine_handle<> writer;
+  };
+
+  Task Session();
+  Task Connect();
+  Task Handshake();
+  Task SendFrame(WsOpcode opcode, const char *payload, size_t len);
+  Task SendAll(const char *data, size_t len);
+  Task ReadLoop();
+
+  /// One epoll_wait; resumes whichever coroutine the events unblock.
+  void Poll();
+  /// recv until EAGAIN or full. 1 = data, 0 = would block, -1 = EOF/error.
+  int Fill();
+  /// Parses and applies every complete frame; false on a protocol error.
+  bool ProcessFrames();
+  void Deliver(const char *data, size_t len);
+  uint32_t NextMaskKey();
+
+  BookRegistry *const registry_;
+  const Options options_;
+  int socket_fd_ = -1;
+  int epoll_fd_ = -1;
+  int stop_fd_ = -1;
+  std::atomic<bool> stop_requested_{false};
+  IoState io_;
+
+  std::unique_ptr<char[]> buffer_;
+  size_t used_ = 0;
+  /// Offset of the first frame not yet parsed.
+  size_t scan_ = 0;
+  /// Fragmented message being reassembled at buffer_ + message_offset_.
+  bool in_message_ = false;
+  size_t message_offset_ = 0;
+  size_t message_len_ = 0;
+
+  bool close_received_ = false;
+  /// Status code echoed in our close frame (0 or 2 bytes).
+  size_t close_len_ = 0;
+  char close_code_[2];
+  bool pong_pending_ = false;
+  size_t pong_len_ = 0;
+  char pong_payload_[125];
+  std::vector<char> send_buffer_;
+  uint64_t mask_state_;
+  Stats stats_;
+};
+
+#endif // PROJECT_FEED_CLIENT_H_
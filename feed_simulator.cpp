@@ -0,0 +1,444 @@
+#include "feed_simulator.h"
+
+#include <algorithm>  // for std::lower_bound, std::min
+#include <charconv>   // for std::to_chars
+#include <cmath>      // for std::pow
+#include <cstring>    // for std::strlen
+
+namespace {
+
+/// Price grid of the simulated markets (OrderBook's kPayout).
+constexpr unsigned int kLevels = 100U;
+constexpr size_t kMaxMarkets = 1000000U;  // Six ticker digits.
+constexpr uint64_t kFirstTimestamp = 1700000000U;
+/// Deepest seeding that keeps both touches (mid = depth + 2 and
+/// kLevels - mid - 1) and their levels on the grid.
+constexpr unsigned int kMaxDepth = (kLevels - 4U) / 2U;
+
+void Append(std::vector<char>* text, const char* s, size_t len) {
+  text->insert(text->end(), s, s + len);
+}
+
+void Append(std::vector<char>* text, const char* s) {
+  Append(text, s, std::strlen(s));
+}
+
+template <typename T>
+void AppendNumber(std::vector<char>* text, T value) {
+  char digits[24];
+  const std::to_chars_result result =
+      std::to_chars(digits, digits + sizeof(digits), value);
+  Append(text, digits, static_cast<size_t>(result.ptr - digits));
+}
+
+/**
+ * @brief Writes {"type":"<type>","sid":<sid>,"seq":<seq>,"msg":{ and the
+ *        market ticker field.
+ */
+void AppendEnvelope(std::vector<char>* text, const char* type, unsigned int sid,
+                    uint64_t seq, const char* ticker, size_t ticker_len) {
+  Append(text, "{\"type\":\"");
+  Append(text, type);
+  Append(text, "\",\"sid\":");
+  AppendNumber(text, sid);
+  Append(text, ",\"seq\":");
+  AppendNumber(text, seq);
+  Append(text, ",\"msg\":{\"market_ticker\":\"");
+  Append(text, ticker, ticker_len);
+  Append(text, "\"");
+}
+
+void AppendLevels(std::vector<char>* text,
+                  const std::map<unsigned int, uint64_t>& levels) {
+  Append(text, "[");
+  bool first = true;
+  for (const auto& [price, qty] : levels) {
+    Append(text, first ? "[" : ",[");
+    AppendNumber(text, price);
+    Append(text, ",");
+    AppendNumber(text, qty);
+    Append(text, "]");
+    first = false;
+  }
+  Append(text, "]");
+}
+
+const char* SideName(Side side) {
+  return side == Side::kNo ? "no" : "yes";
+}
+
+}  // namespace
+
+// =============================================================================
+// ReferenceBook Method Definitions
+// =============================================================================
+
+/**
+ * @brief Adds a signed quantity to one level, erasing it at zero.
+ */
+void ReferenceBook::ApplyDelta(Side side, unsigned int price, int64_t delta) {
+  std::map<unsigned int, uint64_t>& levels = row(side);
+  const uint64_t qty = levels[price] + static_cast<uint64_t>(delta);
+  if (qty == 0U) {
+    levels.erase(price);
+  } else {
+    levels[price] = qty;
+  }
+}
+
+/**
+ * @brief Removes up to @p count from the level the taker hit.
+ */
+void ReferenceBook::ApplyTrade(Side taker_side, unsigned int yes_price,
+                               unsigned int no_price, uint64_t count) {
+  if (taker_side != Side::kYes && taker_side != Side::kNo) return;
+  const bool hits_no = taker_side == Side::kYes;
+  std::map<unsigned int, uint64_t>& levels = hits_no ? no : yes;
+  const auto it = levels.find(hits_no ? no_price : yes_price);
+  if (it == levels.end()) return;
+  if (count >= it->second) {
+    levels.erase(it);
+  } else {
+    it->second -= count;
+  }
+}
+
+/**
+ * @brief Resting quantity at one level; 0 if absent.
+ */
+uint64_t ReferenceBook::QtyAt(Side side, unsigned int price) const {
+  const std::map<unsigned int, uint64_t>& levels = row(side);
+  const auto it = levels.find(price);
+  return it == levels.end() ? 0U : it->second;
+}
+
+// =============================================================================
+// FeedSimulator Method Definitions
+// =============================================================================
+
+/**
+ * @brief @p options with depth limited to kMaxDepth.
+ */
+FeedSimulator::Options FeedSimulator::Clamped(Options options) {
+  options.depth = std::min(options.depth, kMaxDepth);
+  return options;
+}
+
+/**
+ * @brief Builds the popularity table and tickers; nothing is generated yet.
+ */
+FeedSimulator::FeedSimulator(const Options& options)
+    : options_(Clamped(options)),
+      rng_state_(options.seed ? options.seed : 1U) {
+  const size_t count = std::min(std::max<size_t>(options.market_count, 1U),
+                                kMaxMarkets);
+  markets_.resize(count);
+  cdf_.resize(count);
+  double total = 0.0;
+  for (size_t i = 0; i < count; ++i) {
+    total += 1.0 / std::pow(static_cast<double>(i + 1U), options.zipf_exponent);
+    cdf_[i] = total;
+  }
+  for (double& weight : cdf_) {
+    weight /= total;
+  }
+
+  tickers_.resize(count * kTickerLen);
+  const unsigned int lowest_mid = options_.depth + 2U;
+  const unsigned int mid_range =
+      kLevels > 2U * lowest_mid ? kLevels - 2U * lowest_mid : 1U;
+  for (size_t i = 0; i < count; ++i) {
+    char* ticker = tickers_.data() + i * kTickerLen;
+    std::memcpy(ticker, "SIM-", 4U);
+    size_t n = i;
+    for (size_t d = kTickerLen; d > 4U; --d) {
+      ticker[d - 1U] = static_cast<char>('0' + n % 10U);
+      n /= 10U;
+    }
+    markets_[i].mid = lowest_mid + Uniform(mid_range);
+  }
+}
+
+/**
+ * @brief xorshift64*; deterministic across platforms.
+ */
+uint64_t FeedSimulator::NextRandom() {
+  rng_state_ ^= rng_state_ >> 12U;
+  rng_state_ ^= rng_state_ << 25U;
+  rng_state_ ^= rng_state_ >> 27U;
+  return rng_state_ * 2685821657736338717ULL;
+}
+
+/**
+ * @brief Uniform in [0, n).
+ */
+unsigned int FeedSimulator::Uniform(unsigned int n) {
+  return static_cast<unsigned int>(NextRandom() % n);
+}
+
+/**
+ * @brief True with probability @p p.
+ */
+bool FeedSimulator::Chance(double p) {
+  return static_cast<double>(NextRandom() >> 11U) *
+             (1.0 / 9007199254740992.0) <
+         p;
+}
+
+/**
+ * @brief Inverts the popularity CDF at a uniform draw.
+ */
+uint32_t FeedSimulator::PickMarket() {
+  const double u =
+      static_cast<double>(NextRandom() >> 11U) * (1.0 / 9007199254740992.0);
+  const auto it = std::lower_bound(cdf_.begin(), cdf_.end(), u);
+  const size_t index = static_cast<size_t>(it - cdf_.begin());
+  return static_cast<uint32_t>(std::min(index, cdf_.size() - 1U));
+}
+
+/**
+ * @brief Delivers the market's full reference state at its current seq.
+ */
+void FeedSimulator::EmitSnapshot(uint32_t market,
+                                 std::vector<char>* text,
+                                 std::vector<FeedPayload>* payloads) {
+  Market& state = markets_[market];
+  const size_t offset = text->size();
+  AppendEnvelope(text, "orderbook_snapshot", 1U, state.seq, ticker(market),
+                 kTickerLen);
+  Append(text, ",\"yes\":");
+  AppendLevels(text, state.reference.yes);
+  Append(text, ",\"no\":");
+  AppendLevels(text, state.reference.no);
+  Append(text, "}}");
+  payloads->push_back(FeedPayload{market, MessageType::kSnapshot,
+                                  static_cast<uint32_t>(offset),
+                                  static_cast<uint32_t>(text->size() - offset)});
+  ++emitted_;
+  ++stats_.snapshots;
+}
+
+/**
+ * @brief Delivers one delta as generated earlier (seq included).
+ */
+void FeedSimulator::EmitDelta(uint32_t market, const Delta& delta,
+                              std::vector<char>* text,
+                              std::vector<FeedPayload>* payloads) {
+  const size_t offset = text->size();
+  AppendEnvelope(text, "orderbook_delta", 1U, delta.seq, ticker(market),
+                 kTickerLen);
+  Append(text, ",\"price\":");
+  AppendNumber(text, delta.price);
+  Append(text, ",\"delta\":");
+  AppendNumber(text, delta.delta);
+  Append(text, ",\"side\":\"");
+  Append(text, SideName(delta.side));
+  Append(text, "\"}}");
+  payloads->push_back(FeedPayload{market, MessageType::kDelta,
+                                  static_cast<uint32_t>(offset),
+                                  static_cast<uint32_t>(text->size() - offset)});
+  ++emitted_;
+  ++stats_.deltas;
+}
+
+/**
+ * @brief Delivers one trade on the trade channel (its own seq space).
+ */
+void FeedSimulator::EmitTrade(uint32_t market, Side taker_side,
+                              unsigned int yes_price, unsigned int no_price,
+                              unsigned int count, std::vector<char>* text,
+                              std::vector<FeedPayload>* payloads) {
+  const size_t offset = text->size();
+  ++trade_seq_;
+  Append(text, "{\"type\":\"trade\",\"sid\":2,\"seq\":");
+  AppendNumber(text, trade_seq_);
+  Append(text, ",\"msg\":{\"trade_id\":\"T");
+  AppendNumber(text, trade_seq_);
+  Append(text, "\",\"market_ticker\":\"");
+  Append(text, ticker(market), kTickerLen);
+  Append(text, "\",\"yes_price\":");
+  AppendNumber(text, yes_price);
+  Append(text, ",\"no_price\":");
+  AppendNumber(text, no_price);
+  Append(text, ",\"count\":");
+  AppendNumber(text, count);
+  Append(text, ",\"taker_side\":\"");
+  Append(text, SideName(taker_side));
+  Append(text, "\",\"ts\":");
+  AppendNumber(text, kFirstTimestamp + emitted_ / 1000U);
+  Append(text, "}}");
+  payloads->push_back(FeedPayload{market, MessageType::kTrade,
+                                  static_cast<uint32_t>(offset),
+                                  static_cast<uint32_t>(text->size() - offset)});
+  ++emitted_;
+  ++stats_.trades;
+}
+
+/**
+ * @brief Generates the market's next true event, applies it to the
+ *        reference and delivers it (or damages its delivery).
+ */
+void FeedSimulator::Step(uint32_t market, bool in_burst,
+                         std::vector<char>* text,
+                         std::vector<FeedPayload>* payloads) {
+  Market& state = markets_[market];
+  const unsigned int no_mid = kLevels - state.mid - 1U;
+
+  if (!state.started || Chance(options_.snapshot_probability)) {
+    if (!state.started) {
+      // Seed depth levels behind each touch; the first snapshot is seq 1.
+      for (unsigned int i = 0; i < options_.depth; ++i) {
+        if (state.mid > i) {
+          state.reference.yes[state.mid - i] = 50U + Uniform(500U);
+        }
+        if (no_mid > i) {
+          state.reference.no[no_mid - i] = 50U + Uniform(500U);
+        }
+      }
+      state.seq = 1U;
+      state.started = true;
+    }
+    EmitSnapshot(market, text, payloads);
+    if (state.holding) {
+      // Arrives after the snapshot that already covers it.
+      state.holding = false;
+      EmitDelta(market, state.held, text, payloads);
+    }
+    return;
+  }
+
+  const double trade_probability =
+      in_burst ? std::min(0.5, 4.0 * options_.trade_probability)
+               : options_.trade_probability;
+  if (Chance(trade_probability)) {
+    const Side taker = Chance(0.5) ? Side::kYes : Side::kNo;
+    // A YES taker lifts the best NO bid, a NO taker the best YES bid.
+    const std::map<unsigned int, uint64_t>& hit =
+        taker == Side::kYes ? state.reference.no : state.reference.yes;
+    if (!hit.empty()) {
+      const unsigned int best = hit.rbegin()->first;
+      const uint64_t resting = hit.rbegin()->second;
+      const unsigned int count = static_cast<unsigned int>(
+          std::min<uint64_t>(resting, 1U + Uniform(50U)));
+      const unsigned int yes_price = taker == Side::kYes ? kLevels - best : best;
+      const unsigned int no_price = taker == Side::kYes ? best : kLevels - best;
+      state.reference.ApplyTrade(taker, yes_price, no_price, count);
+      EmitTrade(market, taker, yes_price, no_price, count, text, payloads);
+      return;
+    }
+  }
+
+  // Delta clustered near the side's touch.
+  Delta delta;
+  delta.side = Chance(0.5) ? Side::kYes : Side::kNo;
+  const unsigned int touch = delta.side == Side::kYes ? state.mid : no_mid;
+  unsigned int distance = 0U;
+  while (distance + 1U < touch && distance < options_.depth + 4U &&
+         Chance(0.6)) {
+    ++distance;
+  }
+  delta.price = touch - distance;
+  const uint64_t resting = state.reference.QtyAt(delta.side, delta.price);
+  if (resting != 0U && Chance(0.45)) {
+    const unsigned int most =
+        static_cast<unsigned int>(std::min<uint64_t>(resting, 1U << 30U));
+    delta.delta = -static_cast<int>(1U + Uniform(most));
+  } else {
+    delta.delta = static_cast<int>(1U + Uniform(200U));
+  }
+  delta.seq = ++state.seq;
+  state.reference.ApplyDelta(delta.side, delta.price, delta.delta);
+
+  if (Chance(0.0005)) {
+    // Slow touch drift, keeping depth levels on both sides in range.
+    const unsigned int lowest = options_.depth + 2U;
+    if (Chance(0.5)) {
+      if (state.mid + lowest + 1U < kLevels) ++state.mid;
+    } else if (state.mid > lowest) {
+      --state.mid;
+    }
+  }
+
+  if (Chance(options_.drop_probability)) {
+    ++stats_.dropped;
+    if (!state.resync_scheduled) {
+      state.resync_scheduled = true;
+      resyncs_.push_back(Resync{emitted_ + options_.resync_delay, market});
+    }
+    return;
+  }
+  if (!state.holding && Chance(options_.reorder_probability)) {
+    ++stats_.reordered;
+    state.holding = true;
+    state.held = delta;
+    return;
+  }
+  EmitDelta(market, delta, text, payloads);
+  if (Chance(options_.duplicate_probability)) {
+    ++stats_.duplicated;
+    EmitDelta(market, delta, text, payloads);
+  }
+  if (state.holding) {
+    state.holding = false;
+    EmitDelta(market, state.held, text, payloads);
+  }
+}
+
+/**
+ * @brief Generates payloads until @p count more have been delivered (a
+ *        step can deliver up to three, so it may overshoot by two).
+ */
+void FeedSimulator::Generate(size_t count, std::vector<char>* text,
+                             std::vector<FeedPayload>* payloads) {
+  const size_t target = payloads->size() + count;
+  while (payloads->size() < target) {
+    if (resync_head_ < resyncs_.size() &&
+        resyncs_[resync_head_].due <= emitted_) {
+      const uint32_t market = resyncs_[resync_head_++].market;
+      if (resync_head_ == resyncs_.size()) {
+        resyncs_.clear();
+        resync_head_ = 0U;
+      }
+      markets_[market].resync_scheduled = false;
+      ++stats_.resyncs;
+      EmitSnapshot(market, text, payloads);
+      continue;
+    }
+
+    uint32_t market;
+    const bool in_burst = burst_remaining_ != 0U;
+    if (in_burst) {
+      --burst_remaining_;
+      market = burst_market_;
+    } else {
+      market = PickMarket();
+      if (options_.max_burst != 0U && Chance(options_.burst_probability)) {
+        burst_market_ = market;
+        burst_remaining_ = Uniform(options_.max_burst);
+      }
+    }
+    Step(market, in_burst, text, payloads);
+  }
+}
+
+/**
+ * @brief Flushes held deltas, then every resync snapshot still due.
+ */
+void FeedSimulator::Finish(std::vector<char>* text,
+                           std::vector<FeedPayload>* payloads) {
+  for (size_t market = 0; market < markets_.size(); ++market) {
+    Market& state = markets_[market];
+    if (state.holding) {
+      state.holding = false;
+      EmitDelta(static_cast<uint32_t>(market), state.held, text, payloads);
+    }
+  }
+  for (; resync_head_ < resyncs_.size(); ++resync_head_) {
+    const uint32_t market = resyncs_[resync_head_].market;
+    markets_[market].resync_scheduled = false;
+    ++stats_.resyncs;
+    EmitSnapshot(market, text, payloads);
+  }
+  resyncs_.clear();
+  resync_head_ = 0U;
+}
@@ -0,0 +1,209 @@
+#ifndef PROJECT_FEED_SIMULATOR_H_
+#define PROJECT_FEED_SIMULATOR_H_
+
+#include <cstddef> // for size_t
+#include <cstdint> // for uint32_t, uint64_t
+#include <map>     // for std::map
+#include <vector>  // for std::vector
+#include "message_types.h"
+
+/**
+ * @brief Naive per-market book used as the correctness oracle: one ordered
+ *        map per side from price to resting quantity, with no sequencing.
+ *        It always holds the venue's true state, including every message
+ *        the simulator withheld from the delivered stream.
+ */
+struct ReferenceBook
+{
+  std::map<unsigned int, uint64_t> yes;
+  std::map<unsigned int, uint64_t> no;
+
+  std::map<unsigned int, uint64_t> &row(Side side)
+  {
+    return side == Side::kNo ? no : yes;
+  }
+  const std::map<unsigned int, uint64_t> &row(Side side) const
+  {
+    return side == Side::kNo ? no : yes;
+  }
+
+  /// Adds @p delta at (@p side, @p price); a level reaching 0 is erased.
+  void ApplyDelta(Side side, unsigned int price, int64_t delta);
+  /// Same level choice as OrderBook::ApplyTrade.
+  void ApplyTrade(Side taker_side, unsigned int yes_price,
+                  unsigned int no_price, uint64_t count);
+  uint64_t QtyAt(Side side, unsigned int price) const;
+};
+
+/**
+ * @brief Location of one generated payload in the caller's text buffer.
+ */
+struct FeedPayload
+{
+  /// Simulator market index (also usable as a global MarketId).
+  uint32_t market;
+  MessageType type;
+  uint32_t offset;
+  uint32_t length;
+};
+
+/**
+ * @class FeedSimulator
+ *
+ * @brief Deterministic generator of venue-format JSON payloads
+ *        (orderbook_snapshot / orderbook_delta / trade envelopes) across
+ *        many markets, for load and correctness testing without a venue.
+ *
+ * The same Options (including the seed) always produce the same bytes:
+ * the generator uses its own xorshift64* rather than the
+ * implementation-defined std:: distributions.
+ *
+ * Traffic shape:
+ * - Market popularity is Zipfian: market i is picked with weight
+ *   1 / (i + 1)^zipf_exponent, so market 0 is the hottest.
+ * - A burst pins the next 1..max_burst messages to one market (news, a
+ *   sweep), with a raised trade share.
+ * - Deltas cluster near each market's touch; trades hit the best bid of
+ *   the opposite row; every market starts with a snapshot, and snapshots
+ *   recur at snapshot_probability.
+ *
+ * Gap injection damages only the delivered stream. A dropped delta leaves
+ * the book stale until the market's resync snapshot, resync_delay
+ * messages later (as a client's resubscribe would). A duplicated delta is
+ * delivered twice in a row. A reordered delta is held back until the
+ * market's next delta has been delivered. Every generated message is
+ * applied to the market's ReferenceBook in true order, so after Finish()
+ * each OrderBook fed the delivered stream must equal its reference.
+ */
+class FeedSimulator
+{
+public:
+  struct Options
+  {
+    uint64_t seed = 1;
+    size_t market_count = 1000;
+    double zipf_exponent = 1.0;
+    /// Levels seeded behind each touch in a market's first snapshot; at
+    /// most 48 (larger values are clamped) so both touches stay on the grid.
+    unsigned int depth = 10;
+    /// Per message: share of trades, and of (refresh) snapshots.
+    double trade_probability = 0.08;
+    double snapshot_probability = 0.001;
+    /// Per message: chance to start a burst on the chosen market.
+    double burst_probability = 0.01;
+    unsigned int max_burst = 32;
+    /// Per delivered delta.
+    double drop_probability = 0.0;
+    double duplicate_probability = 0.0;
+    double reorder_probability = 0.0;
+    /// Messages between a drop and the market's resync snapshot.
+    unsigned int resync_delay = 64;
+  };
+
+  /// Delivered payloads by type (duplicates included), and injected damage.
+  struct Stats
+  {
+    uint64_t snapshots{0};
+    uint64_t deltas{0};
+    uint64_t trades{0};
+    uint64_t dropped{0};
+    uint64_t duplicated{0};
+    uint64_t reordered{0};
+    uint64_t resyncs{0};
+  };
+
+  explicit FeedSimulator(const Options &options);
+
+  /**
+   * @brief Appends at least @p count delivered payloads to @p text and
+   *        their locations to @p payloads (one step can deliver up to
+   *        three). May be called repeatedly; the stream continues where
+   *        the previous call stopped.
+   */
+  void Generate(size_t count, std::vector<char> *text,
+                std::vector<FeedPayload> *payloads);
+
+  /**
+   * @brief Delivers held (reordered) deltas and the resync snapshots still
+   *        due, so every book fed the stream ends in sync.
+   */
+  void Finish(std::vector<char> *text, std::vector<FeedPayload> *payloads);
+
+  size_t market_count() const { return markets_.size(); }
+  const ReferenceBook &reference(size_t market) const
+  {
+    return markets_[market].reference;
+  }
+  /// The market's ticker (not NUL-terminated), as sent in its payloads.
+  const char *ticker(size_t market) const
+  {
+    return tickers_.data() + market * kTickerLen;
+  }
+  static constexpr size_t kTickerLen = 10;  // "SIM-" + 6 digits.
+
+  const Stats &stats() const { return stats_; }
+
+private:
+  struct Delta
+  {
+    unsigned int price;
+    int delta;
+    Side side;
+    uint64_t seq;
+  };
+
+  struct Market
+  {
+    ReferenceBook reference;
+    /// Seq of the market's last delta (and of its snapshots).
+    uint64_t seq = 0;
+    /// YES touch; the NO touch is kLevels - mid - 1.
+    unsigned int mid = 50;
+    bool started = false;
+    bool resync_scheduled = false;
+    bool holding = false;
+    Delta held{};
+  };
+
+  struct Resync
+  {
+    uint64_t due;
+    uint32_t market;
+  };
+
+  static Options Clamped(Options options);
+
+  uint64_t NextRandom();
+  unsigned int Uniform(unsigned int n);
+  bool Chance(double p);
+  /// Zipf-distributed market index.
+  uint32_t PickMarket();
+
+  void EmitSnapshot(uint32_t market, std::vector<char> *text,
+                    std::vector<FeedPayload> *payloads);
+  void EmitDelta(uint32_t market, const Delta &delta, std::vector<char> *text,
+                 std::vector<FeedPayload> *payloads);
+  void EmitTrade(uint32_t market, Side taker_side, unsigned int yes_price,
+                 unsigned int no_price, unsigned int count,
+                 std::vector<char> *text, std::vector<FeedPayload> *payloads);
+  /// One true delta or trade for @p market, delivered or damaged.
+  void Step(uint32_t market, bool in_burst, std::vector<char> *text,
+            std::vector<FeedPayload> *payloads);
+
+  const Options options_;
+  uint64_t rng_state_;
+  /// Cumulative popularity weights, normalized to 1.
+  std::vector<double> cdf_;
+  std::vector<Market> markets_;
+  std::vector<char> tickers_;
+  /// Pending resync snapshots in due order.
+  std::vector<Resync> resyncs_;
+  size_t resync_head_ = 0;
+  uint64_t emitted_ = 0;
+  uint64_t trade_seq_ = 0;
+  uint32_t burst_market_ = 0;
+  unsigned int burst_remaining_ = 0;
+  Stats stats_;
+};
+
+#endif // PROJECT_FEED_SIMULATOR_H_
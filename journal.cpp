@@ -0,0 +1,438 @@
+#include "journal.h"
+
+#include <cstring>  // for std::memcpy, std::memcmp, std::memset
+
+#include <fcntl.h>     // for open
+#include <sys/mman.h>  // for mmap, munmap
+#include <sys/stat.h>  // for fstat
+#include <unistd.h>    // for pwrite, close
+
+namespace {
+
+constexpr char kMagic[8] = {'F', 'O', 'B', 'J', 'R', 'N', 'L', '1'};
+constexpr uint32_t kVersion = 1U;
+
+/**
+ * @brief Size of one record / position unit in bytes.
+ */
+constexpr uint64_t kUnit = 32U;
+
+static_assert(sizeof(JournalFileHeader) % kUnit == 0, "header is unit-sized");
+static_assert(kMaxCompactSnapshotSize / kUnit < 0xFFFFU,
+              "payload_units must fit a snapshot");
+
+}  // namespace
+
+// =============================================================================
+// JournalWriter Method Definitions
+// =============================================================================
+
+/**
+ * @brief Closes the journal if it is still open.
+ */
+JournalWriter::~JournalWriter() {
+  Close();
+}
+
+/**
+ * @brief Creates the journal file and reserves room for the header.
+ *
+ * @param path Destination path (truncated if it exists).
+ * @param options Checkpoint and buffering configuration.
+ * @return False if the file could not be created.
+ */
+bool JournalWriter::Open(const char* path, const Options& options) {
+  if (fd_ >= 0) return false;
+  fd_ = ::open(path, O_CREAT | O_TRUNC | O_RDWR, 0644);
+  if (fd_ < 0) return false;
+
+  options_ = options;
+  buffer_.assign(sizeof(JournalFileHeader), 0U);  // Patched on Close.
+  buffer_.reserve(options_.buffer_size);
+  buffer_offset_ = 0U;
+  next_unit_ = static_cast<uint32_t>(sizeof(JournalFileHeader) / kUnit);
+  record_count_ = 0U;
+  markets_.clear();
+  return true;
+}
+
+/**
+ * @brief Registers a market ticker.
+ *
+ * @return The dense journal market ID.
+ */
+uint32_t JournalWriter::AddMarket(const char* ticker, size_t ticker_len) {
+  for (size_t i = 0; i < markets_.size(); ++i) {
+    if (markets_[i].ticker.size() == ticker_len &&
+        std::memcmp(markets_[i].ticker.data(), ticker, ticker_len) == 0) {
+      return static_cast<uint32_t>(i);
+    }
+  }
+  markets_.emplace_back();
+  markets_.back().ticker.assign(ticker, ticker_len);
+  return static_cast<uint32_t>(markets_.size() - 1U);
+}
+
+/**
+ * @brief Appends a snapshot (stored in compact form).
+ */
+bool JournalWriter::Append(uint32_t market_id, const SnapshotMessage& snap) {
+  if (market_id >= markets_.size()) return false;
+  alignas(8) uint8_t payload[kMaxCompactSnapshotSize];
+  const size_t len = EncodeCompactSnapshot(snap, payload, sizeof(payload));
+  if (len == 0U) return false;
+
+  markets_[market_id].book.ApplySnapshot(&snap);
+  markets_[market_id].since_checkpoint = 0U;
+  return AppendPayloadRecord(JournalRecordType::kSnapshot, market_id, snap.seq,
+                             payload, len);
+}
+
+/**
+ * @brief Appends a delta.
+ */
+bool JournalWriter::Append(uint32_t market_id, const DeltaMessage& delta) {
+  if (market_id >= markets_.size() || delta.price > 0xFFFFU) return false;
+  JournalRecord record{};
+  record.type = JournalRecordType::kDelta;
+  record.side = static_cast<uint8_t>(delta.side);
+  record.market_id = market_id;
+  record.seq = delta.seq;
+  record.price = static_cast<uint16_t>(delta.price);
+  record.quantity = delta.delta;
+  markets_[market_id].book.ApplyDelta(&delta);
+  return Write(record, nullptr, 0U) && MaybeCheckpoint(market_id);
+}
+
+/**
+ * @brief Appends a trade.
+ */
+bool JournalWriter::Append(uint32_t market_id, const TradeMessage& trade) {
+  if (market_id >= markets_.size() || trade.yes_price > 0xFFFFU ||
+      trade.no_price > 0xFFFFU) {
+    return false;
+  }
+  JournalRecord record{};
+  record.type = JournalRecordType::kTrade;
+  record.side = static_cast<uint8_t>(trade.taker_side);
+  record.market_id = market_id;
+  record.seq = trade.seq;
+  record.price = static_cast<uint16_t>(trade.yes_price);
+  record.no_price = static_cast<uint16_t>(trade.no_price);
+  record.quantity = trade.count;
+  record.ts = trade.ts;
+  markets_[market_id].book.ApplyTrade(&trade);
+  return Write(record, nullptr, 0U) && MaybeCheckpoint(market_id);
+}
+
+/**
+ * @brief Writes a snapshot-like record followed by its padded payload.
+ */
+bool JournalWriter::AppendPayloadRecord(JournalRecordType type,
+                                        uint32_t market_id, uint64_t seq,
+                                        const uint8_t* payload,
+                                        size_t payload_len) {
+  JournalRecord record{};
+  record.type = type;
+  record.market_id = market_id;
+  record.seq = seq;
+  record.payload_units =
+      static_cast<uint16_t>((payload_len + kUnit - 1U) / kUnit);
+  return Write(record, payload, payload_len);
+}
+
+/**
+ * @brief Emits a checkpoint of the shadow book once the interval elapses.
+ */
+bool JournalWriter::MaybeCheckpoint(uint32_t market_id) {
+  MarketState& market = markets_[market_id];
+  if (options_.checkpoint_interval == 0U ||
+      ++market.since_checkpoint < options_.checkpoint_interval) {
+    return true;
+  }
+  market.since_checkpoint = 0U;
+  if (market.book.buffered_delta_count() != 0U) {
+    // Mid-gap: a checkpoint would drop the deltas replay needs to buffer.
+    return true;
+  }
+
+  alignas(8) uint8_t payload[kMaxCompactSnapshotSize];
+  const size_t len = market.book.EncodeSnapshot(payload, sizeof(payload));
+  if (len == 0U) return false;
+  CompactSnapshotView view;
+  view.Parse(payload, len);
+  return AppendPayloadRecord(JournalRecordType::kCheckpoint, market_id,
+                             view.seq(), payload, len);
+}
+
+/**
+ * @brief Buffers a record and links the market's previous record to it.
+ *
+ * The link is patched in the buffer when the previous record is still
+ * there, otherwise written in place in the file.
+ */
+bool JournalWriter::Write(JournalRecord record, const uint8_t* payload,
+                          size_t payload_len) {
+  const size_t total = kUnit + uint64_t{record.payload_units} * kUnit;
+  if (buffer_.size() + total > options_.buffer_size && !Flush()) {
+    return false;
+  }
+
+  const uint32_t unit = next_unit_;
+  MarketState& market = markets_[record.market_id];
+  if (market.record_count == 0U) {
+    market.first_record = unit;
+  } else {
+    const uint64_t link_offset = uint64_t{market.last_record} * kUnit +
+                                 offsetof(JournalRecord, next_record);
+    if (link_offset >= buffer_offset_) {
+      std::memcpy(&buffer_[link_offset - buffer_offset_], &unit, sizeof(unit));
+    } else if (!WriteAt(link_offset, &unit, sizeof(unit))) {
+      return false;
+    }
+  }
+  market.last_record = unit;
+  ++market.record_count;
+  ++record_count_;
+
+  record.next_record = 0U;
+  const size_t at = buffer_.size();
+  buffer_.resize(at + total, 0U);
+  std::memcpy(&buffer_[at], &record, sizeof(record));
+  if (payload_len != 0U) {
+    std::memcpy(&buffer_[at + kUnit], payload, payload_len);
+  }
+  next_unit_ += static_cast<uint32_t>(total / kUnit);
+  return true;
+}
+
+/**
+ * @brief Writes the buffered bytes to the file.
+ */
+bool JournalWriter::Flush() {
+  if (!WriteAt(buffer_offset_, buffer_.data(), buffer_.size())) return false;
+  buffer_offset_ += buffer_.size();
+  buffer_.clear();
+  return true;
+}
+
+/**
+ * @brief pwrite loop.
+ */
+bool JournalWriter::WriteAt(uint64_t offset, const void* data, size_t len) {
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  while (len > 0U) {
+    const ssize_t written =
+        ::pwrite(fd_, bytes, len, static_cast<off_t>(offset));
+    if (written <= 0) return false;
+    bytes += written;
+    offset += static_cast<uint64_t>(written);
+    len -= static_cast<size_t>(written);
+  }
+  return true;
+}
+
+/**
+ * @brief Writes the index, ticker bytes and final header, then closes.
+ *
+ * @return False on I/O error (the file is closed either way).
+ */
+bool JournalWriter::Close() {
+  if (fd_ < 0) return true;
+
+  bool ok = Flush();
+  const uint64_t index_offset = uint64_t{next_unit_} * kUnit;
+  uint64_t ticker_offset =
+      index_offset + markets_.size() * sizeof(JournalMarketIndex);
+
+  std::vector<uint8_t> tail(ticker_offset - index_offset);
+  for (size_t i = 0; i < markets_.size(); ++i) {
+    JournalMarketIndex entry{};
+    entry.first_record = markets_[i].first_record;
+    entry.last_record = markets_[i].last_record;
+    entry.record_count = markets_[i].record_count;
+    entry.ticker_offset = ticker_offset;
+    entry.ticker_len = static_cast<uint32_t>(markets_[i].ticker.size());
+    std::memcpy(&tail[i * sizeof(entry)], &entry, sizeof(entry));
+    tail.insert(tail.end(), markets_[i].ticker.begin(),
+                markets_[i].ticker.end());
+    ticker_offset += entry.ticker_len;
+  }
+  ok = ok && WriteAt(index_offset, tail.data(), tail.size());
+
+  JournalFileHeader header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.market_count = static_cast<uint32_t>(markets_.size());
+  header.record_count = record_count_;
+  header.index_offset = index_offset;
+  header.file_size = index_offset + tail.size();
+  ok = ok && WriteAt(0U, &header, sizeof(header));
+
+  ok = (::close(fd_) == 0) && ok;
+  fd_ = -1;
+  return ok;
+}
+
+// =============================================================================
+// JournalReader Method Definitions
+// =============================================================================
+
+/**
+ * @brief Unmaps the journal.
+ */
+JournalReader::~JournalReader() {
+  Close();
+}
+
+/**
+ * @brief Maps a journal read-only and validates its header and index.
+ *
+ * @param path Journal written by JournalWriter.
+ * @return False if the file is missing, truncated or not a journal, or if
+ *         an index entry points outside the file.
+ */
+bool JournalReader::Open(const char* path) {
+  Close();
+  const int fd = ::open(path, O_RDONLY);
+  if (fd < 0) return false;
+  struct stat st;
+  if (::fstat(fd, &st) != 0 ||
+      static_cast<size_t>(st.st_size) < sizeof(JournalFileHeader)) {
+    ::close(fd);
+    return false;
+  }
+  void* mapping = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ,
+                         MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (mapping == MAP_FAILED) return false;
+
+  base_ = static_cast<const uint8_t*>(mapping);
+  size_ = static_cast<size_t>(st.st_size);
+  header_ = reinterpret_cast<const JournalFileHeader*>(base_);
+  const uint64_t index_offset = header_->index_offset;
+  if (std::memcmp(header_->magic, kMagic, sizeof(kMagic)) != 0 ||
+      header_->version != kVersion || header_->file_size != size_ ||
+      index_offset < sizeof(JournalFileHeader) || index_offset % kUnit != 0U ||
+      index_offset / kUnit > UINT32_MAX || index_offset > size_ ||
+      uint64_t{header_->market_count} >
+          (size_ - index_offset) / sizeof(JournalMarketIndex)) {
+    Close();
+    return false;
+  }
+  index_ = reinterpret_cast<const JournalMarketIndex*>(base_ + index_offset);
+  end_unit_ = static_cast<uint32_t>(index_offset / kUnit);
+
+  // Every ticker must lie in the file and every stream must start on a
+  // record; the links themselves are checked as they are walked.
+  for (uint32_t i = 0; i < header_->market_count; ++i) {
+    const JournalMarketIndex& entry = index_[i];
+    const bool ticker_ok = entry.ticker_offset <= size_ &&
+                           entry.ticker_len <= size_ - entry.ticker_offset;
+    const bool first_ok =
+        entry.first_record == 0U || HasRecordAt(entry.first_record);
+    if (!ticker_ok || !first_ok) {
+      Close();
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Releases the mapping.
+ */
+void JournalReader::Close() {
+  if (base_ != nullptr) {
+    ::munmap(const_cast<uint8_t*>(base_), size_);
+  }
+  base_ = nullptr;
+  size_ = 0U;
+  header_ = nullptr;
+  index_ = nullptr;
+  end_unit_ = 0U;
+}
+
+/**
+ * @brief Applies one record to a book, reading payloads in place.
+ *
+ * @return False for an unknown type or a corrupt payload.
+ */
+bool JournalReader::Apply(const JournalRecord& record, OrderBook* book) const {
+  switch (record.type) {
+    case JournalRecordType::kDelta: {
+      DeltaMessage delta{};
+      delta.price = record.price;
+      delta.delta = record.quantity;
+      delta.side = static_cast<Side>(record.side);
+      delta.seq = record.seq;
+      book->ApplyDelta(&delta);
+      return true;
+    }
+    case JournalRecordType::kTrade: {
+      TradeMessage trade{};
+      trade.yes_price = record.price;
+      trade.no_price = record.no_price;
+      trade.count = record.quantity;
+      trade.taker_side = static_cast<Side>(record.side);
+      trade.ts = record.ts;
+      trade.seq = record.seq;
+      book->ApplyTrade(&trade);
+      return true;
+    }
+    case JournalRecordType::kSnapshot:
+    case JournalRecordType::kCheckpoint: {
+      // The payload must end inside the record area of this mapping.
+      const uint8_t* payload = reinterpret_cast<const uint8_t*>(&record) + kUnit;
+      const uint8_t* record_end = base_ + uint64_t{end_unit_} * kUnit;
+      if (payload < base_ || payload > record_end ||
+          uint64_t{record.payload_units} * kUnit >
+              static_cast<uint64_t>(record_end - payload)) {
+        return false;
+      }
+      CompactSnapshotView view;
+      if (!view.Parse(payload, uint64_t{record.payload_units} * kUnit)) {
+        return false;
+      }
+      book->ApplySnapshot(view);
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+/**
+ * @brief Interns every journal market into the registry.
+ */
+bool JournalReader::InternMarkets(
+    BookRegistry* registry, std::vector<BookRegistry::MarketId>* ids) const {
+  ids->resize(market_count());
+  for (uint32_t i = 0; i < market_count(); ++i) {
+    (*ids)[i] = registry->Intern(ticker(i), index_[i].ticker_len);
+    if ((*ids)[i] == BookRegistry::kInvalidMarketId) return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Replays all records in file order on the calling thread.
+ *
+ * @return False if the registry is too small or a record is corrupt.
+ */
+bool JournalReader::ReplayAll(BookRegistry* registry) const {
+  std::vector<BookRegistry::MarketId> ids;
+  if (!InternMarkets(registry, &ids)) return false;
+
+  uint32_t unit = kFirstRecordUnit;
+  while (unit < end_unit_) {
+    if (!HasRecordAt(unit)) return false;
+    const JournalRecord& record = RecordAt(unit);
+    if (record.market_id >= market_count() ||
+        !Apply(record, &registry->book(ids[record.market_id]))) {
+      return false;
+    }
+    unit += 1U + record.payload_units;
+  }
+  return true;
+}
@@ -0,0 +1,301 @@
+#ifndef PROJECT_JOURNAL_H_
+#define PROJECT_JOURNAL_H_
+
+#include <atomic>   // for std::atomic
+#include <cstddef>  // for size_t
+#include <cstdint>  // for uint8_t, uint16_t, uint32_t, uint64_t
+#include <string>   // for std::string
+#include <thread>   // for std::thread
+#include <vector>   // for std::vector
+#include "book_registry.h"
+#include "compact_snapshot.h"
+#include "message_types.h"
+#include "orderbook.h"
+
+// ---------------------------------------------------------------------------
+// Binary capture format
+// ---------------------------------------------------------------------------
+/**
+ * @brief On-disk layout (host byte order):
+ *
+ *   JournalFileHeader                       64 bytes
+ *   JournalRecord...                        32 bytes each; snapshot and
+ *                                           checkpoint records are followed
+ *                                           by payload_units * 32 bytes of
+ *                                           compact snapshot encoding
+ *   JournalMarketIndex[market_count]        at index_offset
+ *   ticker bytes                            referenced by the index
+ *
+ * Every record links to the next record of the same market (next_record),
+ * so one market's stream can be replayed without scanning the others.
+ * Positions are in 32-byte units from the start of the file; 0 means none.
+ */
+enum class JournalRecordType : uint8_t {
+  kInvalid = 0,
+  kSnapshot,
+  kDelta,
+  kTrade,
+  /// Book state written by the journal itself every checkpoint_interval
+  /// records per market; replay applies it like a snapshot.
+  kCheckpoint,
+};
+
+struct JournalFileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t market_count;
+  uint64_t record_count;
+  uint64_t index_offset;  // Byte offset of the market index.
+  uint64_t file_size;
+  uint8_t reserved[24];
+};
+
+struct JournalRecord {
+  JournalRecordType type;
+  uint8_t side;            // Delta side / trade taker side (Side).
+  uint16_t payload_units;  // Trailing payload, in 32-byte units.
+  uint32_t market_id;      // Dense journal market ID.
+  uint64_t seq;
+  uint32_t next_record;    // Next record of this market, 0 if last.
+  uint16_t price;          // Delta price / trade yes_price.
+  uint16_t no_price;       // Trade no_price.
+  int32_t quantity;        // Delta / trade count.
+  int32_t ts;              // Trade ts.
+};
+
+struct JournalMarketIndex {
+  uint32_t first_record;
+  uint32_t last_record;
+  uint64_t record_count;
+  uint64_t ticker_offset;  // Byte offset of the ticker in the file.
+  uint32_t ticker_len;
+  uint32_t reserved;
+};
+
+static_assert(sizeof(JournalFileHeader) == 64, "journal format");
+static_assert(sizeof(JournalRecord) == 32, "journal format");
+static_assert(sizeof(JournalMarketIndex) == 32, "journal format");
+
+/**
+ * @class JournalWriter
+ *
+ * @brief Appends decoded messages to a journal file.
+ *
+ * The writer keeps a shadow OrderBook per market so it can embed
+ * checkpoints; it buffers output and patches per-market links in place.
+ * Not thread-safe.
+ */
+class JournalWriter
+{
+public:
+  struct Options
+  {
+    /// Records per market between embedded checkpoints; 0 disables them.
+    uint32_t checkpoint_interval = 10000;
+    /// Size of the output buffer in bytes.
+    size_t buffer_size = 4U << 20U;
+  };
+
+  JournalWriter() = default;
+  ~JournalWriter();
+
+  JournalWriter(const JournalWriter &) = delete;
+  JournalWriter &operator=(const JournalWriter &) = delete;
+
+  /// Creates (truncates) @p path. Returns false on I/O error.
+  bool Open(const char *path, const Options &options);
+
+  /// Registers a market and returns its dense journal ID (existing ID if the
+  /// ticker is already registered).
+  uint32_t AddMarket(const char *ticker, size_t ticker_len);
+
+  bool Append(uint32_t market_id, const SnapshotMessage &snap);
+  bool Append(uint32_t market_id, const DeltaMessage &delta);
+  bool Append(uint32_t market_id, const TradeMessage &trade);
+
+  /// Flushes records, writes the index and final header, closes the file.
+  bool Close();
+
+private:
+  struct MarketState
+  {
+    std::string ticker;
+    uint32_t first_record = 0;
+    uint32_t last_record = 0;
+    uint64_t record_count = 0;
+    uint32_t since_checkpoint = 0;
+    OrderBook book;
+  };
+
+  /// Appends a record (and optional payload), linking it into its market.
+  bool Write(JournalRecord record, const uint8_t *payload, size_t payload_len);
+  bool AppendPayloadRecord(JournalRecordType type, uint32_t market_id,
+                           uint64_t seq, const uint8_t *payload,
+                           size_t payload_len);
+  bool MaybeCheckpoint(uint32_t market_id);
+  bool Flush();
+  bool WriteAt(uint64_t offset, const void *data, size_t len);
+
+  int fd_ = -1;
+  Options options_;
+  std::vector<uint8_t> buffer_;
+  /// File offset of buffer_[0].
+  uint64_t buffer_offset_ = 0;
+  /// Next free 32-byte unit in the file.
+  uint32_t next_unit_ = 0;
+  uint64_t record_count_ = 0;
+  std::vector<MarketState> markets_;
+};
+
+/**
+ * @class JournalReader
+ *
+ * @brief Memory-maps a journal and replays it.
+ *
+ * Records are read straight from the mapping: snapshots/checkpoints are
+ * applied through CompactSnapshotView without copying their payloads.
+ * Replay into a BookRegistry first interns every journal ticker (in journal
+ * ID order), so IDs match an empty registry exactly.
+ */
+class JournalReader
+{
+public:
+  JournalReader() = default;
+  ~JournalReader();
+
+  JournalReader(const JournalReader &) = delete;
+  JournalReader &operator=(const JournalReader &) = delete;
+
+  /// Maps and validates @p path. Returns false if missing or malformed.
+  bool Open(const char *path);
+  void Close();
+
+  uint32_t market_count() const { return header_->market_count; }
+  uint64_t record_count() const { return header_->record_count; }
+  const JournalMarketIndex &market(uint32_t id) const { return index_[id]; }
+  const char *ticker(uint32_t id) const
+  {
+    return reinterpret_cast<const char *>(base_ + index_[id].ticker_offset);
+  }
+
+  /// Record at a 32-byte unit position; check it with HasRecordAt first.
+  const JournalRecord &RecordAt(uint32_t unit) const
+  {
+    return *reinterpret_cast<const JournalRecord *>(base_ + uint64_t{unit} * 32U);
+  }
+
+  /// True if a record and its whole payload lie at @p unit, inside the
+  /// record area (below the index).
+  bool HasRecordAt(uint32_t unit) const
+  {
+    return unit >= kFirstRecordUnit && unit < end_unit_ &&
+           end_unit_ - unit > RecordAt(unit).payload_units;
+  }
+
+  /// Applies one record to @p book. Returns false for unknown record types.
+  bool Apply(const JournalRecord &record, OrderBook *book) const;
+
+  /**
+   * @brief Walks one market's records in order, calling
+   *        fn(const JournalRecord&).
+   *
+   * @return False if a link leaves the record area or points backwards
+   *         (a corrupt journal); the records before it were visited.
+   */
+  template <typename Fn>
+  bool ForEachMarketRecord(uint32_t market_id, Fn &&fn) const
+  {
+    for (uint32_t unit = index_[market_id].first_record; unit != 0U;) {
+      if (!HasRecordAt(unit)) {
+        return false;
+      }
+      const JournalRecord &record = RecordAt(unit);
+      fn(record);
+      // Records are appended in file order, so links only go forward.
+      if (record.next_record != 0U && record.next_record <= unit) {
+        return false;
+      }
+      unit = record.next_record;
+    }
+    return true;
+  }
+
+  /// Replays every record in file order on the calling thread.
+  bool ReplayAll(BookRegistry *registry) const;
+
+  /**
+   * @brief Replays each market's stream on one of @p num_threads threads.
+   *
+   * Markets are handed out dynamically, and every book is touched by exactly
+   * one thread. After each record, on_applied(MarketId, const JournalRecord&,
+   * const OrderBook&) runs on the replaying thread.
+   *
+   * @return False if the registry is too small or any market's stream was
+   *         corrupt (the other markets are still replayed).
+   */
+  template <typename OnApplied>
+  bool ReplaySharded(BookRegistry *registry, unsigned int num_threads,
+                     OnApplied on_applied) const
+  {
+    std::vector<BookRegistry::MarketId> ids;
+    if (!InternMarkets(registry, &ids)) {
+      return false;
+    }
+    std::atomic<uint32_t> next_market{0};
+    std::atomic<bool> failed{false};
+    auto worker = [&] {
+      for (;;) {
+        const uint32_t market =
+            next_market.fetch_add(1U, std::memory_order_relaxed);
+        if (market >= market_count()) {
+          return;
+        }
+        OrderBook &book = registry->book(ids[market]);
+        bool applied = true;
+        const bool walked =
+            ForEachMarketRecord(market, [&](const JournalRecord &record) {
+              applied = Apply(record, &book) && applied;
+              on_applied(ids[market], record,
+                         static_cast<const OrderBook &>(book));
+            });
+        if (!walked || !applied) {
+          failed.store(true, std::memory_order_relaxed);
+        }
+      }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned int i = 1; i < num_threads; ++i) {
+      threads.emplace_back(worker);
+    }
+    worker();
+    for (std::thread &thread : threads) {
+      thread.join();
+    }
+    return !failed.load(std::memory_order_relaxed);
+  }
+
+  bool ReplaySharded(BookRegistry *registry, unsigned int num_threads) const
+  {
+    return ReplaySharded(registry, num_threads,
+                         [](BookRegistry::MarketId, const JournalRecord &,
+                            const OrderBook &) {});
+  }
+
+private:
+  /// The header occupies the first two units.
+  static constexpr uint32_t kFirstRecordUnit = sizeof(JournalFileHeader) / 32U;
+
+  /// Interns all journal tickers into @p registry; ids[journal_id] = id.
+  bool InternMarkets(BookRegistry *registry,
+                     std::vector<BookRegistry::MarketId> *ids) const;
+
+  const uint8_t *base_ = nullptr;
+  size_t size_ = 0;
+  const JournalFileHeader *header_ = nullptr;
+  const JournalMarketIndex *index_ = nullptr;
+  /// First unit past the record area (index_offset / 32).
+  uint32_t end_unit_ = 0;
+};
+
+#endif  // PROJECT_JOURNAL_H_
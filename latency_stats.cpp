@@ -0,0 +1,216 @@
+#include "latency_stats.h"
+
+#include <chrono>  // for std::chrono::steady_clock
+#include <memory>  // for std::unique_ptr
+#include <mutex>   // for std::mutex, std::lock_guard
+
+namespace {
+
+constexpr unsigned int kOpCount = static_cast<unsigned int>(LatencyOp::kCount);
+
+/**
+ * @brief One thread's histograms. Linked into a global list on creation and
+ *        never freed.
+ */
+struct ThreadLatencyStats
+{
+  explicit ThreadLatencyStats(size_t max_markets)
+      : market_capacity(max_markets),
+        per_market(new LatencyStats::MarketHistogram[max_markets * kOpCount])
+  {
+  }
+
+  LatencyStats::OpHistogram per_op[kOpCount];
+  const size_t market_capacity;
+  /// [market_id * kOpCount + op].
+  std::unique_ptr<LatencyStats::MarketHistogram[]> per_market;
+  ThreadLatencyStats* next = nullptr;
+};
+
+std::mutex g_registry_mutex;
+ThreadLatencyStats* g_threads = nullptr;
+std::atomic<size_t> g_max_markets{4096};
+
+thread_local ThreadLatencyStats* t_stats = nullptr;
+
+/**
+ * @brief Creates and registers the calling thread's histograms.
+ */
+ThreadLatencyStats* RegisterThisThread() {
+  auto* stats =
+      new ThreadLatencyStats(g_max_markets.load(std::memory_order_relaxed));
+  std::lock_guard<std::mutex> lock(g_registry_mutex);
+  stats->next = g_threads;
+  g_threads = stats;
+  return stats;
+}
+
+/**
+ * @brief Running merge of any number of same-shaped histograms.
+ */
+template <typename Histogram>
+class Merged
+{
+public:
+  void Add(const Histogram& histogram) {
+    count_ += histogram.count();
+    sum_ += histogram.sum();
+    if (histogram.max() > max_) max_ = histogram.max();
+    for (unsigned int i = 0; i < Histogram::kBuckets; ++i) {
+      buckets_[i] += histogram.bucket(i);
+    }
+  }
+
+  uint64_t count() const { return count_; }
+
+  LatencySummary Summary() const {
+    LatencySummary summary;
+    summary.count = count_;
+    if (count_ == 0U) return summary;
+    summary.mean = static_cast<double>(sum_) / static_cast<double>(count_);
+    summary.p50 = Percentile(0.50);
+    summary.p90 = Percentile(0.90);
+    summary.p99 = Percentile(0.99);
+    summary.p999 = Percentile(0.999);
+    summary.max = max_;
+    return summary;
+  }
+
+private:
+  /// Upper bound of the bucket holding the q-quantile, capped at max.
+  uint64_t Percentile(double q) const {
+    const uint64_t rank =
+        static_cast<uint64_t>(q * static_cast<double>(count_ - 1U)) + 1U;
+    uint64_t seen = 0U;
+    for (unsigned int i = 0; i < Histogram::kBuckets; ++i) {
+      seen += buckets_[i];
+      if (seen >= rank) {
+        const uint64_t bound = Histogram::BucketUpperBound(i);
+        return bound < max_ ? bound : max_;
+      }
+    }
+    return max_;
+  }
+
+  uint64_t count_ = 0U;
+  uint64_t sum_ = 0U;
+  uint64_t max_ = 0U;
+  uint64_t buckets_[Histogram::kBuckets] = {};
+};
+
+}  // namespace
+
+// =============================================================================
+// LatencyStats Method Definitions
+// =============================================================================
+
+/**
+ * @brief Sets the per-market histogram capacity for threads that have not
+ *        recorded yet.
+ *
+ * @param max_markets Market IDs below this get their own histograms.
+ */
+void LatencyStats::Configure(size_t max_markets) {
+  g_max_markets.store(max_markets, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Allocates the calling thread's histograms ahead of its first
+ *        record, keeping the allocation off the hot path.
+ */
+void LatencyStats::WarmUpThisThread() {
+  if (t_stats == nullptr) {
+    t_stats = RegisterThisThread();
+  }
+}
+
+/**
+ * @brief Adds one sample to the calling thread's histograms.
+ *
+ * @param op Operation row.
+ * @param market_id Market, or kNoMarket for operations not tied to one.
+ * @param ticks Elapsed LatencyClock ticks.
+ */
+void LatencyStats::Record(LatencyOp op, uint32_t market_id, uint64_t ticks) {
+  ThreadLatencyStats* stats = t_stats;
+  if (__builtin_expect(stats == nullptr, 0)) {
+    stats = t_stats = RegisterThisThread();
+  }
+  const unsigned int row = static_cast<unsigned int>(op);
+  stats->per_op[row].Record(ticks);
+  if (market_id < stats->market_capacity) {
+    stats->per_market[static_cast<size_t>(market_id) * kOpCount + row].Record(
+        ticks);
+  }
+}
+
+/**
+ * @brief Distribution of one operation across all markets and threads.
+ */
+LatencySummary LatencyStats::Summarize(LatencyOp op) {
+  Merged<OpHistogram> merged;
+  std::lock_guard<std::mutex> lock(g_registry_mutex);
+  for (const ThreadLatencyStats* t = g_threads; t != nullptr; t = t->next) {
+    merged.Add(t->per_op[static_cast<unsigned int>(op)]);
+  }
+  return merged.Summary();
+}
+
+/**
+ * @brief Distribution of one operation on one market, across threads.
+ */
+LatencySummary LatencyStats::Summarize(LatencyOp op, uint32_t market_id) {
+  Merged<MarketHistogram> merged;
+  std::lock_guard<std::mutex> lock(g_registry_mutex);
+  for (const ThreadLatencyStats* t = g_threads; t != nullptr; t = t->next) {
+    if (market_id < t->market_capacity) {
+      merged.Add(t->per_market[static_cast<size_t>(market_id) * kOpCount +
+                               static_cast<unsigned int>(op)]);
+    }
+  }
+  return merged.Summary();
+}
+
+/**
+ * @brief Per-market summaries for every market that has samples for @p op.
+ *
+ * Cold path: allocates the result and walks every thread's market rows.
+ */
+std::vector<MarketLatency> LatencyStats::ExportMarkets(LatencyOp op) {
+  std::vector<MarketLatency> result;
+  size_t markets = 0U;
+  {
+    std::lock_guard<std::mutex> lock(g_registry_mutex);
+    for (const ThreadLatencyStats* t = g_threads; t != nullptr; t = t->next) {
+      if (t->market_capacity > markets) markets = t->market_capacity;
+    }
+  }
+  for (size_t id = 0; id < markets; ++id) {
+    const LatencySummary summary = Summarize(op, static_cast<uint32_t>(id));
+    if (summary.count != 0U) {
+      result.push_back(MarketLatency{static_cast<uint32_t>(id), summary});
+    }
+  }
+  return result;
+}
+
+/**
+ * @brief Measures LatencyClock against steady_clock over ~10 ms (first call
+ *        only).
+ */
+double LatencyStats::TicksPerNanosecond() {
+  static const double ticks_per_ns = [] {
+    using Steady = std::chrono::steady_clock;
+    const Steady::time_point wall_start = Steady::now();
+    const uint64_t tick_start = LatencyClock::Now();
+    while (Steady::now() - wall_start < std::chrono::milliseconds(10)) {
+    }
+    const uint64_t ticks = LatencyClock::Now() - tick_start;
+    const double ns = static_cast<double>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(Steady::now() -
+                                                             wall_start)
+            .count());
+    return ns > 0.0 ? static_cast<double>(ticks) / ns : 1.0;
+  }();
+  return ticks_per_ns;
+}
@@ -0,0 +1,244 @@
+#ifndef PROJECT_LATENCY_STATS_H_
+#define PROJECT_LATENCY_STATS_H_
+
+#include <atomic>  // for std::atomic
+#include <cstddef> // for size_t
+#include <cstdint> // for uint32_t, uint64_t
+#include <vector>  // for std::vector
+
+#if !defined(__x86_64__) && !defined(__i386__)
+#include <chrono>  // for std::chrono::steady_clock
+#endif
+
+// ---------------------------------------------------------------------------
+// Hot-path latency instrumentation
+// ---------------------------------------------------------------------------
+//
+// Build with FAST_ORDERBOOK_INSTRUMENTATION defined (CMake option of the same
+// name) to time the book's hot paths. Otherwise ORDERBOOK_LATENCY_SCOPE
+// expands to nothing and its arguments are not evaluated: no code, no data
+// and no TLS access on the hot path.
+//
+// Each instrumented thread records into its own histograms (allocated on its
+// first record, or by LatencyStats::WarmUpThisThread). Counters are
+// single-writer relaxed atomics that are loaded and stored, never
+// read-modify-written, so recording is plain moves on x86 while exporters on
+// other threads still read them without a data race.
+//
+// Values are in ticks of LatencyClock: rdtsc on x86, steady_clock
+// nanoseconds elsewhere. To use another clock, define
+// FAST_ORDERBOOK_LATENCY_CLOCK as the name of a type with a static
+// uint64_t Now().
+
+/// Instrumented operations (histogram rows).
+enum class LatencyOp : uint8_t {
+  kSnapshot = 0,
+  kDelta,
+  kTrade,
+  kTopN,
+  /// One BookRegistry::ApplyDeltas call (a whole run of deltas).
+  kDeltaBatch,
+  kCount,
+};
+
+/**
+ * @brief Default instrumentation clock.
+ */
+struct TscClock
+{
+  static uint64_t Now()
+  {
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    return static_cast<uint64_t>(
+        std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+  }
+};
+
+#if defined(FAST_ORDERBOOK_LATENCY_CLOCK)
+using LatencyClock = FAST_ORDERBOOK_LATENCY_CLOCK;
+#else
+using LatencyClock = TscClock;
+#endif
+
+/**
+ * @class LogHistogram
+ *
+ * @brief HDR-style log-bucketed histogram of uint64 values.
+ *
+ * Values below 2^kSubBucketBits get exact buckets; above that every power of
+ * two is split into 2^kSubBucketBits linear sub-buckets, so the relative
+ * error is at most 2^-kSubBucketBits. Single writer (Record), any readers.
+ */
+template <unsigned int kSubBucketBits>
+class LogHistogram
+{
+public:
+  static constexpr unsigned int kSubBuckets = 1U << kSubBucketBits;
+  static constexpr unsigned int kBuckets = (65U - kSubBucketBits) * kSubBuckets;
+
+  static unsigned int BucketOf(uint64_t value)
+  {
+    if (value < kSubBuckets) {
+      return static_cast<unsigned int>(value);
+    }
+    const unsigned int msb =
+        63U - static_cast<unsigned int>(__builtin_clzll(value));
+    const unsigned int shift = msb - kSubBucketBits;
+    return ((shift + 1U) << kSubBucketBits) |
+           static_cast<unsigned int>((value >> shift) & (kSubBuckets - 1U));
+  }
+
+  /// Largest value that falls into @p bucket.
+  static uint64_t BucketUpperBound(unsigned int bucket)
+  {
+    if (bucket < kSubBuckets) {
+      return bucket;
+    }
+    const unsigned int shift = (bucket >> kSubBucketBits) - 1U;
+    const uint64_t base =
+        (static_cast<uint64_t>(kSubBuckets) | (bucket & (kSubBuckets - 1U)))
+        << shift;
+    return base + ((static_cast<uint64_t>(1) << shift) - 1U);
+  }
+
+  /// Writer thread only.
+  void Record(uint64_t value)
+  {
+    Bump(&buckets_[BucketOf(value)], uint64_t{1});
+    Bump(&count_, uint64_t{1});
+    Bump(&sum_, value);
+    if (value > max_.load(std::memory_order_relaxed)) {
+      max_.store(value, std::memory_order_relaxed);
+    }
+  }
+
+  uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+  uint64_t sum() const { return sum_.load(std::memory_order_relaxed); }
+  uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+  uint64_t bucket(unsigned int i) const
+  {
+    return buckets_[i].load(std::memory_order_relaxed);
+  }
+
+private:
+  template <typename T>
+  static void Bump(std::atomic<T> *counter, T by)
+  {
+    counter->store(counter->load(std::memory_order_relaxed) + by,
+                   std::memory_order_relaxed);
+  }
+
+  std::atomic<uint64_t> count_{0};
+  std::atomic<uint64_t> sum_{0};
+  std::atomic<uint64_t> max_{0};
+  std::atomic<uint64_t> buckets_[kBuckets]{};
+};
+
+/**
+ * @brief Exported view of one histogram (or a merge of several), in ticks.
+ */
+struct LatencySummary
+{
+  uint64_t count{0};
+  double mean{0.0};
+  uint64_t p50{0};
+  uint64_t p90{0};
+  uint64_t p99{0};
+  uint64_t p999{0};
+  uint64_t max{0};
+};
+
+struct MarketLatency
+{
+  uint32_t market_id;
+  LatencySummary summary;
+};
+
+/**
+ * @class LatencyStats
+ *
+ * @brief Process-wide access to the per-thread histograms.
+ *
+ * Operation histograms use 8 sub-buckets per octave (<= 12.5% error).
+ * Per-market histograms use one bucket per power of two to keep them small
+ * (~2.7 KB per market per thread), and exist for market IDs below
+ * max_markets; others are only counted in the operation totals.
+ *
+ * The export calls merge every thread that has recorded so far. They take a
+ * lock that only thread registration shares, so they never stall the hot
+ * path. Per-thread storage is never freed, so data recorded by threads that
+ * have since exited is still exported.
+ */
+class LatencyStats
+{
+public:
+  using OpHistogram = LogHistogram<3>;
+  using MarketHistogram = LogHistogram<0>;
+
+  static constexpr uint32_t kNoMarket = UINT32_MAX;
+
+  /// True when built with FAST_ORDERBOOK_INSTRUMENTATION.
+  static constexpr bool enabled()
+  {
+#if defined(FAST_ORDERBOOK_INSTRUMENTATION)
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  /// Per-market histogram rows for threads registered afterwards
+  /// (default 4096). Call before the first record.
+  static void Configure(size_t max_markets);
+
+  /// Allocates this thread's histograms now instead of on first record.
+  static void WarmUpThisThread();
+
+  /// Records one sample for the calling thread.
+  static void Record(LatencyOp op, uint32_t market_id, uint64_t ticks);
+
+  /// Merged across threads.
+  static LatencySummary Summarize(LatencyOp op);
+  static LatencySummary Summarize(LatencyOp op, uint32_t market_id);
+  /// Every market with at least one sample for @p op, by market ID.
+  static std::vector<MarketLatency> ExportMarkets(LatencyOp op);
+
+  /// Calibrated LatencyClock ticks per nanosecond (measured once, ~10 ms).
+  static double TicksPerNanosecond();
+};
+
+/**
+ * @brief RAII timer behind ORDERBOOK_LATENCY_SCOPE.
+ */
+class LatencyScope
+{
+public:
+  LatencyScope(LatencyOp op, uint32_t market_id)
+      : start_(LatencyClock::Now()), market_id_(market_id), op_(op)
+  {
+  }
+  ~LatencyScope()
+  {
+    LatencyStats::Record(op_, market_id_, LatencyClock::Now() - start_);
+  }
+
+  LatencyScope(const LatencyScope &) = delete;
+  LatencyScope &operator=(const LatencyScope &) = delete;
+
+private:
+  const uint64_t start_;
+  const uint32_t market_id_;
+  const LatencyOp op_;
+};
+
+#if defined(FAST_ORDERBOOK_INSTRUMENTATION)
+#define ORDERBOOK_LATENCY_SCOPE(op, market_id) \
+  const LatencyScope orderbook_latency_scope_((op), (market_id))
+#else
+#define ORDERBOOK_LATENCY_SCOPE(op, market_id) static_cast<void>(0)
+#endif
+
+#endif // PROJECT_LATENCY_STATS_H_
@@ -0,0 +1,205 @@
+#include "message_arena.h"
+
+#include <cstring>  // for std::memcpy
+
+#include "compact_snapshot.h"
+
+namespace {
+
+/**
+ * @brief Alignment of arena blocks (one cache line).
+ */
+constexpr size_t kBlockAlignment = 64U;
+
+}  // namespace
+
+// =============================================================================
+// MessageArena Method Definitions
+// =============================================================================
+
+/**
+ * @brief Creates an empty arena; blocks are allocated on first use.
+ *
+ * @param block_size Bytes per block (larger requests get their own block).
+ */
+MessageArena::MessageArena(size_t block_size) : block_size_(block_size) {}
+
+/**
+ * @brief Frees every block of every generation.
+ */
+MessageArena::~MessageArena() {
+  for (Generation& gen : generations_) {
+    for (const Block& block : gen.blocks) {
+      ::operator delete(block.data, std::align_val_t(kBlockAlignment));
+    }
+  }
+}
+
+/**
+ * @brief Slow path of Allocate: skips to the next block that fits, and
+ *        allocates a new block only when the generation has none left.
+ */
+void* MessageArena::AllocateSlow(size_t bytes, size_t align) {
+  Generation& gen = generations_[current_];
+  for (;;) {
+    if (gen.block < gen.blocks.size()) {
+      const Block& block = gen.blocks[gen.block];
+      const size_t start = (gen.offset + align - 1U) & ~(align - 1U);
+      if (start + bytes <= block.size) {
+        gen.offset = start + bytes;
+        return block.data + start;
+      }
+      if (gen.offset == 0U) {
+        // An untouched block that is too small: leave it for later epochs
+        // and put a big enough one in front of it.
+        break;
+      }
+      ++gen.block;
+      gen.offset = 0U;
+      continue;
+    }
+    break;
+  }
+
+  const size_t size = bytes > block_size_ ? bytes : block_size_;
+  const Block block{static_cast<uint8_t*>(::operator new(
+                        size, std::align_val_t(kBlockAlignment))),
+                    size};
+  gen.blocks.insert(gen.blocks.begin() + static_cast<ptrdiff_t>(gen.block),
+                    block);
+  ++block_count_;
+  // Blocks are cache-line aligned, so offset 0 satisfies any align <= 64.
+  gen.offset = bytes;
+  return block.data;
+}
+
+/**
+ * @brief Copies a byte string into the current epoch.
+ */
+const char* MessageArena::CopyBytes(const char* bytes, size_t len) {
+  if (len == 0U) {
+    return nullptr;
+  }
+  char* copy = static_cast<char*>(Allocate(len, 1U));
+  std::memcpy(copy, bytes, len);
+  return copy;
+}
+
+/**
+ * @brief Makes a slot self-contained: its string fields now point into the
+ *        arena instead of the receive buffer.
+ */
+void MessageArena::Retain(MessageSlot* slot) {
+  switch (slot->type) {
+    case MessageType::kSnapshot: {
+      CompactSnapshotRef& snap = slot->snapshot;
+      snap.market_ticker_ptr =
+          CopyBytes(snap.market_ticker_ptr, snap.market_ticker_len);
+      snap.market_id_ptr = CopyBytes(snap.market_id_ptr, snap.market_id_len);
+      // The encoding is 4-byte aligned; keep it so when copying.
+      uint8_t* data = static_cast<uint8_t*>(Allocate(snap.size, 4U));
+      std::memcpy(data, snap.data, snap.size);
+      snap.data = data;
+      break;
+    }
+    case MessageType::kDelta: {
+      DeltaMessage& delta = slot->delta;
+      delta.market_ticker_ptr =
+          CopyBytes(delta.market_ticker_ptr, delta.market_ticker_len);
+      delta.market_id_ptr = CopyBytes(delta.market_id_ptr, delta.market_id_len);
+      break;
+    }
+    case MessageType::kTrade: {
+      TradeMessage& trade = slot->trade;
+      trade.trade_id_ptr = CopyBytes(trade.trade_id_ptr, trade.trade_id_len);
+      trade.market_ticker_ptr =
+          CopyBytes(trade.market_ticker_ptr, trade.market_ticker_len);
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+/**
+ * @brief Encodes a snapshot into the arena and points a slot at it.
+ */
+bool MessageArena::EncodeSnapshot(const SnapshotMessage& snap,
+                                  MessageSlot* slot) {
+  if (snap.yes_count < 0 || snap.yes_count > kMaxBookLevels ||
+      snap.no_count < 0 || snap.no_count > kMaxBookLevels) {
+    return false;
+  }
+  const size_t size = CompactSnapshotSize(static_cast<size_t>(snap.yes_count),
+                                          static_cast<size_t>(snap.no_count));
+  uint8_t* data = static_cast<uint8_t*>(Allocate(size, 4U));
+  if (EncodeCompactSnapshot(snap, data, size) != size) {
+    return false;
+  }
+  slot->type = MessageType::kSnapshot;
+  slot->snapshot = CompactSnapshotRef{snap.market_ticker_ptr,
+                                      snap.market_ticker_len,
+                                      snap.market_id_ptr,
+                                      snap.market_id_len,
+                                      data,
+                                      size};
+  return true;
+}
+
+/**
+ * @brief Arena copy of a snapshot, including its string bytes.
+ */
+SnapshotMessage* MessageArena::Copy(const SnapshotMessage& msg) {
+  SnapshotMessage* copy = static_cast<SnapshotMessage*>(
+      Allocate(sizeof(SnapshotMessage), alignof(SnapshotMessage)));
+  std::memcpy(copy, &msg, sizeof(SnapshotMessage));
+  copy->market_ticker_ptr =
+      CopyBytes(msg.market_ticker_ptr, msg.market_ticker_len);
+  copy->market_id_ptr = CopyBytes(msg.market_id_ptr, msg.market_id_len);
+  return copy;
+}
+
+/**
+ * @brief Arena copy of a delta, including its string bytes.
+ */
+DeltaMessage* MessageArena::Copy(const DeltaMessage& msg) {
+  DeltaMessage* copy = static_cast<DeltaMessage*>(
+      Allocate(sizeof(DeltaMessage), alignof(DeltaMessage)));
+  *copy = msg;
+  copy->market_ticker_ptr =
+      CopyBytes(msg.market_ticker_ptr, msg.market_ticker_len);
+  copy->market_id_ptr = CopyBytes(msg.market_id_ptr, msg.market_id_len);
+  return copy;
+}
+
+/**
+ * @brief Arena copy of a trade, including its string bytes.
+ */
+TradeMessage* MessageArena::Copy(const TradeMessage& msg) {
+  TradeMessage* copy = static_cast<TradeMessage*>(
+      Allocate(sizeof(TradeMessage), alignof(TradeMessage)));
+  *copy = msg;
+  copy->trade_id_ptr = CopyBytes(msg.trade_id_ptr, msg.trade_id_len);
+  copy->market_ticker_ptr =
+      CopyBytes(msg.market_ticker_ptr, msg.market_ticker_len);
+  return copy;
+}
+
+/**
+ * @brief Starts the next epoch if its generation is free again.
+ *
+ * Epoch e uses generation e % kEpochs, so epoch e + 1 may reuse its
+ * generation once epoch e + 1 - kEpochs has been released.
+ */
+bool MessageArena::Advance() {
+  const uint64_t next = epoch_ + 1U;
+  if (next >= kEpochs &&
+      released_.load(std::memory_order_acquire) < next - kEpochs + 1U) {
+    return false;
+  }
+  epoch_ = next;
+  current_ = static_cast<unsigned int>(next % kEpochs);
+  generations_[current_].block = 0U;
+  generations_[current_].offset = 0U;
+  return true;
+}
@@ -0,0 +1,149 @@
+#ifndef PROJECT_MESSAGE_ARENA_H_
+#define PROJECT_MESSAGE_ARENA_H_
+
+#include <atomic>  // for std::atomic
+#include <cstddef> // for size_t
+#include <cstdint> // for uint8_t, uint64_t
+#include <new>     // for placement new
+#include <vector>  // for std::vector
+#include "message_types.h"
+
+/**
+ * @class MessageArena
+ *
+ * @brief Bump allocator for decoded messages and the string bytes they
+ *        point at, reclaimed in bulk per epoch.
+ *
+ * One producer thread (normally the decoder) allocates. Allocations go into
+ * the current epoch. Advance closes the epoch at a batch boundary, and a
+ * consumer calls Release once it no longer references anything from that
+ * epoch or an older one. Storage is split into kEpochs generations used
+ * round-robin. Each generation keeps its blocks after a reset, so
+ * reclaiming an epoch is O(1), and once every generation has grown to its
+ * working size nothing is allocated or freed on the steady-state path.
+ *
+ * Retain() is the usual entry point: it copies a MessageSlot's ticker,
+ * market_id and trade_id bytes into the arena and repoints the slot, so
+ * the slot can outlive the receive buffer it was decoded from.
+ * EncodeSnapshot() stores a decoded snapshot's compact encoding for a slot
+ * to reference.
+ *
+ * Only Release and released() may be called from another thread (a
+ * single consumer).
+ */
+class MessageArena
+{
+public:
+  /// Generations cycled through; at most kEpochs - 1 closed epochs can be
+  /// outstanding (unreleased) while the producer keeps advancing.
+  static constexpr unsigned int kEpochs = 4;
+
+  explicit MessageArena(size_t block_size = 64U << 10U);
+  ~MessageArena();
+
+  MessageArena(const MessageArena &) = delete;
+  MessageArena &operator=(const MessageArena &) = delete;
+
+  /**
+   * @brief Returns @p bytes of storage aligned to @p align (a power of
+   *        two, at most 64), valid until the current epoch is released.
+   */
+  void *Allocate(size_t bytes, size_t align = alignof(std::max_align_t))
+  {
+    Generation &gen = generations_[current_];
+    if (gen.block < gen.blocks.size()) {
+      const Block &block = gen.blocks[gen.block];
+      const size_t start = (gen.offset + align - 1U) & ~(align - 1U);
+      if (start + bytes <= block.size) {
+        gen.offset = start + bytes;
+        return block.data + start;
+      }
+    }
+    return AllocateSlow(bytes, align);
+  }
+
+  /// Default-constructs a T in the arena. T must be trivially
+  /// destructible; nothing is ever destroyed.
+  template <typename T>
+  T *New()
+  {
+    return new (Allocate(sizeof(T), alignof(T))) T();
+  }
+
+  /// Copies @p len bytes into the arena (nullptr for len == 0).
+  const char *CopyBytes(const char *bytes, size_t len);
+
+  /// Repoints every string field of @p slot (and a snapshot's encoding)
+  /// at an arena copy.
+  void Retain(MessageSlot *slot);
+
+  /**
+   * @brief Encodes @p snap compactly into the arena and makes @p slot a
+   *        snapshot slot referencing it. The ticker and market_id still
+   *        point where @p snap's do; Retain() copies them too if needed.
+   *
+   * @return False if @p snap does not encode (counts/prices out of range).
+   */
+  bool EncodeSnapshot(const SnapshotMessage &snap, MessageSlot *slot);
+
+  /// Deep copies (message plus string bytes) owned by the arena.
+  SnapshotMessage *Copy(const SnapshotMessage &msg);
+  DeltaMessage *Copy(const DeltaMessage &msg);
+  TradeMessage *Copy(const TradeMessage &msg);
+
+  /// Epoch that allocations currently go to.
+  uint64_t epoch() const { return epoch_; }
+
+  /**
+   * @brief Closes the current epoch and starts the next one, rewinding the
+   *        generation it reuses.
+   *
+   * @return False (staying in the current epoch) if the consumer has not
+   *         yet released the epoch that last used that generation.
+   */
+  bool Advance();
+
+  /// Consumer side: all epochs <= @p epoch are no longer referenced.
+  void Release(uint64_t epoch)
+  {
+    if (epoch + 1U > released_.load(std::memory_order_relaxed)) {
+      released_.store(epoch + 1U, std::memory_order_release);
+    }
+  }
+  /// Number of epochs released so far (epochs below this are free).
+  uint64_t released() const
+  {
+    return released_.load(std::memory_order_acquire);
+  }
+
+  /// Blocks allocated from the heap since construction (for monitoring the
+  /// warm-up; constant in steady state).
+  size_t block_count() const { return block_count_; }
+
+private:
+  struct Block
+  {
+    uint8_t *data;
+    size_t size;
+  };
+
+  /// One generation's blocks plus its bump position.
+  struct Generation
+  {
+    std::vector<Block> blocks;
+    size_t block = 0U;
+    size_t offset = 0U;
+  };
+
+  /// Moves to the next block of the generation, growing it if needed.
+  void *AllocateSlow(size_t bytes, size_t align);
+
+  const size_t block_size_;
+  Generation generations_[kEpochs];
+  unsigned int current_ = 0U;
+  uint64_t epoch_ = 0U;
+  size_t block_count_ = 0U;
+  alignas(64) std::atomic<uint64_t> released_{0};
+};
+
+#endif // PROJECT_MESSAGE_ARENA_H_
@@ -0,0 +1,562 @@
+#include "message_decoder.h"
+
+#include <cstdint>  // for uint64_t
+#include <cstring>  // for std::memcmp
+
+#if defined(__SSE2__)
+#include <emmintrin.h>  // for SSE2 intrinsics
+#endif
+
+namespace {
+
+// =============================================================================
+// SIMD scanning primitives
+// =============================================================================
+
+/**
+ * @brief Returns a pointer to the first byte in [p, end) equal to any of the
+ *        characters in @p set, or @p end if there is none.
+ *
+ * @p set is a string literal; its trailing NUL is not part of the set.
+ */
+template <size_t N>
+inline const char* FindFirstOf(const char* p, const char* end,
+                               const char (&set)[N]) {
+#if defined(__SSE2__)
+  while (end - p >= 16) {
+    const __m128i chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i hits = _mm_setzero_si128();
+    for (size_t i = 0; i + 1 < N; ++i) {
+      hits = _mm_or_si128(hits, _mm_cmpeq_epi8(chunk, _mm_set1_epi8(set[i])));
+    }
+    const int mask = _mm_movemask_epi8(hits);
+    if (mask != 0) {
+      return p + __builtin_ctz(static_cast<unsigned int>(mask));
+    }
+    p += 16;
+  }
+#endif
+  for (; p < end; ++p) {
+    for (size_t i = 0; i + 1 < N; ++i) {
+      if (*p == set[i]) return p;
+    }
+  }
+  return end;
+}
+
+/**
+ * @brief Returns the number of consecutive ASCII digits starting at @p p.
+ */
+inline size_t DigitRunLength(const char* p, const char* end) {
+  const char* start = p;
+#if defined(__SSE2__)
+  const __m128i below = _mm_set1_epi8('0' - 1);
+  const __m128i above = _mm_set1_epi8('9' + 1);
+  while (end - p >= 16) {
+    const __m128i chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    // Bytes >= 0x80 compare as negative and therefore never look like digits.
+    const __m128i digits = _mm_and_si128(_mm_cmpgt_epi8(chunk, below),
+                                         _mm_cmplt_epi8(chunk, above));
+    const unsigned int non_digits =
+        ~static_cast<unsigned int>(_mm_movemask_epi8(digits)) & 0xFFFFU;
+    if (non_digits != 0U) {
+      return static_cast<size_t>(p - start) + __builtin_ctz(non_digits);
+    }
+    p += 16;
+  }
+#endif
+  while (p < end && static_cast<unsigned char>(*p - '0') <= 9U) {
+    ++p;
+  }
+  return static_cast<size_t>(p - start);
+}
+
+// =============================================================================
+// Cursor-based JSON walking
+// =============================================================================
+
+/**
+ * @brief Read position within the caller's buffer.
+ */
+struct Cursor {
+  const char* p;
+  const char* end;
+};
+
+inline void SkipWhitespace(Cursor* c) {
+  while (c->p < c->end &&
+         (*c->p == ' ' || *c->p == '\n' || *c->p == '\r' || *c->p == '\t')) {
+    ++c->p;
+  }
+}
+
+/**
+ * @brief Consumes @p expected (after optional whitespace).
+ */
+inline bool Expect(Cursor* c, char expected) {
+  SkipWhitespace(c);
+  if (c->p >= c->end || *c->p != expected) return false;
+  ++c->p;
+  return true;
+}
+
+/**
+ * @brief Parses a string value, returning its contents as a view into the
+ *        buffer. Escaped strings are accepted but returned verbatim.
+ */
+inline bool ParseString(Cursor* c, const char** out_ptr, size_t* out_len) {
+  if (!Expect(c, '"')) return false;
+  const char* start = c->p;
+  for (;;) {
+    const char* hit = FindFirstOf(c->p, c->end, "\"\\");
+    if (hit >= c->end) return false;
+    if (*hit == '"') {
+      *out_ptr = start;
+      *out_len = static_cast<size_t>(hit - start);
+      c->p = hit + 1;
+      return true;
+    }
+    // Backslash: skip it and the escaped character.
+    c->p = hit + 2;
+    if (c->p > c->end) return false;
+  }
+}
+
+/**
+ * @brief Parses an optionally signed integer that fits in 32 bits.
+ */
+inline bool ParseInt(Cursor* c, int64_t min_value, int64_t max_value,
+                     int64_t* out) {
+  SkipWhitespace(c);
+  bool negative = false;
+  if (c->p < c->end && *c->p == '-') {
+    negative = true;
+    ++c->p;
+  }
+  const size_t digits = DigitRunLength(c->p, c->end);
+  if (digits == 0 || digits > 10) return false;
+
+  uint64_t value = 0;
+  for (size_t i = 0; i < digits; ++i) {
+    value = value * 10U + static_cast<uint64_t>(c->p[i] - '0');
+  }
+  c->p += digits;
+
+  // Fractions and exponents are never valid for the fields we decode.
+  if (c->p < c->end && (*c->p == '.' || *c->p == 'e' || *c->p == 'E')) {
+    return false;
+  }
+
+  const int64_t signed_value =
+      negative ? -static_cast<int64_t>(value) : static_cast<int64_t>(value);
+  if (signed_value < min_value || signed_value > max_value) return false;
+  *out = signed_value;
+  return true;
+}
+
+/**
+ * @brief Parses a non-negative integer of up to 19 digits.
+ */
+inline bool ParseUint64(Cursor* c, uint64_t* out) {
+  SkipWhitespace(c);
+  const size_t digits = DigitRunLength(c->p, c->end);
+  if (digits == 0 || digits > 19) return false;
+
+  uint64_t value = 0;
+  for (size_t i = 0; i < digits; ++i) {
+    value = value * 10U + static_cast<uint64_t>(c->p[i] - '0');
+  }
+  c->p += digits;
+  *out = value;
+  return true;
+}
+
+inline bool ParseUnsigned(Cursor* c, unsigned int* out) {
+  int64_t value = 0;
+  if (!ParseInt(c, 0, UINT32_MAX, &value)) return false;
+  *out = static_cast<unsigned int>(value);
+  return true;
+}
+
+inline bool ParseSigned(Cursor* c, int* out) {
+  int64_t value = 0;
+  if (!ParseInt(c, INT32_MIN, INT32_MAX, &value)) return false;
+  *out = static_cast<int>(value);
+  return true;
+}
+
+/**
+ * @brief Skips over any JSON value (string, number, literal, object, array).
+ */
+bool SkipValue(Cursor* c) {
+  SkipWhitespace(c);
+  if (c->p >= c->end) return false;
+
+  const char first = *c->p;
+  if (first == '"') {
+    const char* ignored_ptr;
+    size_t ignored_len;
+    return ParseString(c, &ignored_ptr, &ignored_len);
+  }
+
+  if (first != '{' && first != '[') {
+    // Number or literal: runs until the next delimiter of the parent.
+    c->p = FindFirstOf(c->p, c->end, ",}]");
+    return c->p < c->end;
+  }
+
+  // Container: track depth, skipping over strings so that brackets inside
+  // them are not counted.
+  int depth = 0;
+  for (;;) {
+    const char* hit = FindFirstOf(c->p, c->end, "\"{}[]");
+    if (hit >= c->end) return false;
+    c->p = hit;
+    switch (*hit) {
+      case '"': {
+        const char* ignored_ptr;
+        size_t ignored_len;
+        if (!ParseString(c, &ignored_ptr, &ignored_len)) return false;
+        continue;
+      }
+      case '{':
+      case '[':
+        ++depth;
+        break;
+      default:
+        --depth;
+        break;
+    }
+    ++c->p;
+    if (depth == 0) return true;
+  }
+}
+
+template <size_t N>
+inline bool KeyIs(const char* key, size_t key_len, const char (&name)[N]) {
+  return key_len == N - 1 && std::memcmp(key, name, N - 1) == 0;
+}
+
+/**
+ * @brief Iterates the fields of an object, invoking
+ *        `on_field(key, key_len, cursor)` with the cursor positioned at the
+ *        value. The callback must consume the value (or call SkipValue) and
+ *        returns false to abort, or sets *stop to end the walk early.
+ */
+template <typename OnField>
+bool ForEachField(Cursor* c, OnField&& on_field) {
+  if (!Expect(c, '{')) return false;
+  SkipWhitespace(c);
+  if (c->p < c->end && *c->p == '}') {
+    ++c->p;
+    return true;
+  }
+  for (;;) {
+    const char* key;
+    size_t key_len;
+    if (!ParseString(c, &key, &key_len)) return false;
+    if (!Expect(c, ':')) return false;
+    bool stop = false;
+    if (!on_field(key, key_len, c, &stop)) return false;
+    if (stop) return true;
+    SkipWhitespace(c);
+    if (c->p >= c->end) return false;
+    if (*c->p == ',') {
+      ++c->p;
+      continue;
+    }
+    if (*c->p == '}') {
+      ++c->p;
+      return true;
+    }
+    return false;
+  }
+}
+
+inline bool ParseSide(Cursor* c, Side* out) {
+  const char* value;
+  size_t value_len;
+  if (!ParseString(c, &value, &value_len)) return false;
+  if (KeyIs(value, value_len, "yes")) {
+    *out = Side::kYes;
+  } else if (KeyIs(value, value_len, "no")) {
+    *out = Side::kNo;
+  } else {
+    *out = Side::kUndefined;
+  }
+  return true;
+}
+
+/**
+ * @brief Parses `[[price, qty], ...]` into the given snapshot arrays.
+ */
+bool ParseLevels(Cursor* c, int* count, unsigned int* prices,
+                 unsigned int* qtys) {
+  *count = 0;
+  if (!Expect(c, '[')) return false;
+  SkipWhitespace(c);
+  if (c->p < c->end && *c->p == ']') {
+    ++c->p;
+    return true;
+  }
+  for (;;) {
+    if (*count >= kMaxBookLevels) return false;
+    if (!Expect(c, '[')) return false;
+    if (!ParseUnsigned(c, &prices[*count])) return false;
+    if (!Expect(c, ',')) return false;
+    if (!ParseUnsigned(c, &qtys[*count])) return false;
+    if (!Expect(c, ']')) return false;
+    ++*count;
+
+    SkipWhitespace(c);
+    if (c->p >= c->end) return false;
+    if (*c->p == ',') {
+      ++c->p;
+      continue;
+    }
+    return Expect(c, ']');
+  }
+}
+
+bool ParseSnapshotBody(Cursor* c, SnapshotMessage* out) {
+  out->market_ticker_ptr = nullptr;
+  out->market_ticker_len = 0;
+  out->market_id_ptr = nullptr;
+  out->market_id_len = 0;
+  out->yes_count = 0;
+  out->no_count = 0;
+
+  return ForEachField(c, [out](const char* key, size_t key_len, Cursor* v,
+                               bool*) {
+    if (KeyIs(key, key_len, "market_ticker")) {
+      return ParseString(v, &out->market_ticker_ptr, &out->market_ticker_len);
+    }
+    if (KeyIs(key, key_len, "market_id")) {
+      return ParseString(v, &out->market_id_ptr, &out->market_id_len);
+    }
+    if (KeyIs(key, key_len, "yes")) {
+      return ParseLevels(v, &out->yes_count, out->yes_price, out->yes_qty);
+    }
+    if (KeyIs(key, key_len, "no")) {
+      return ParseLevels(v, &out->no_count, out->no_price, out->no_qty);
+    }
+    return SkipValue(v);
+  });
+}
+
+bool ParseDeltaBody(Cursor* c, DeltaMessage* out) {
+  out->market_ticker_ptr = nullptr;
+  out->market_ticker_len = 0;
+  out->market_id_ptr = nullptr;
+  out->market_id_len = 0;
+  out->price = 0;
+  out->delta = 0;
+  out->side = Side::kUndefined;
+
+  return ForEachField(c, [out](const char* key, size_t key_len, Cursor* v,
+                               bool*) {
+    if (KeyIs(key, key_len, "market_ticker")) {
+      return ParseString(v, &out->market_ticker_ptr, &out->market_ticker_len);
+    }
+    if (KeyIs(key, key_len, "market_id")) {
+      return ParseString(v, &out->market_id_ptr, &out->market_id_len);
+    }
+    if (KeyIs(key, key_len, "price")) {
+      return ParseUnsigned(v, &out->price);
+    }
+    if (KeyIs(key, key_len, "delta")) {
+      return ParseSigned(v, &out->delta);
+    }
+    if (KeyIs(key, key_len, "side")) {
+      return ParseSide(v, &out->side);
+    }
+    return SkipValue(v);
+  });
+}
+
+bool ParseTradeBody(Cursor* c, TradeMessage* out) {
+  out->trade_id_ptr = nullptr;
+  out->trade_id_len = 0;
+  out->market_ticker_ptr = nullptr;
+  out->market_ticker_len = 0;
+  out->yes_price = 0;
+  out->no_price = 0;
+  out->count = 0;
+  out->taker_side = Side::kUndefined;
+  out->ts = 0;
+
+  return ForEachField(c, [out](const char* key, size_t key_len, Cursor* v,
+                               bool*) {
+    if (KeyIs(key, key_len, "trade_id")) {
+      return ParseString(v, &out->trade_id_ptr, &out->trade_id_len);
+    }
+    if (KeyIs(key, key_len, "market_ticker")) {
+      return ParseString(v, &out->market_ticker_ptr, &out->market_ticker_len);
+    }
+    if (KeyIs(key, key_len, "yes_price")) {
+      return ParseUnsigned(v, &out->yes_price);
+    }
+    if (KeyIs(key, key_len, "no_price")) {
+      return ParseUnsigned(v, &out->no_price);
+    }
+    if (KeyIs(key, key_len, "count")) {
+      return ParseSigned(v, &out->count);
+    }
+    if (KeyIs(key, key_len, "taker_side")) {
+      return ParseSide(v, &out->taker_side);
+    }
+    if (KeyIs(key, key_len, "ts")) {
+      return ParseSigned(v, &out->ts);
+    }
+    return SkipValue(v);
+  });
+}
+
+MessageType TypeFromName(const char* name, size_t name_len) {
+  if (KeyIs(name, name_len, "orderbook_delta")) return MessageType::kDelta;
+  if (KeyIs(name, name_len, "trade")) return MessageType::kTrade;
+  if (KeyIs(name, name_len, "orderbook_snapshot")) {
+    return MessageType::kSnapshot;
+  }
+  return MessageType::kUnknown;
+}
+
+/**
+ * @brief Fields of the top-level envelope we care about.
+ */
+struct Envelope {
+  MessageType type = MessageType::kUnknown;
+  const char* body = nullptr;  // Start of the "msg" value, if seen.
+  uint64_t seq = 0;            // "seq", or 0 if absent.
+};
+
+/**
+ * @brief Walks the top-level object. When @p stop_at_type is set the walk
+ *        ends as soon as "type" has been read.
+ */
+bool ParseEnvelope(Cursor* c, bool stop_at_type, Envelope* env) {
+  return ForEachField(c, [env, stop_at_type](const char* key, size_t key_len,
+                                             Cursor* v, bool* stop) {
+    if (KeyIs(key, key_len, "type")) {
+      const char* name;
+      size_t name_len;
+      if (!ParseString(v, &name, &name_len)) return false;
+      env->type = TypeFromName(name, name_len);
+      *stop = stop_at_type;
+      return true;
+    }
+    if (KeyIs(key, key_len, "seq")) {
+      return ParseUint64(v, &env->seq);
+    }
+    if (KeyIs(key, key_len, "msg")) {
+      SkipWhitespace(v);
+      env->body = v->p;
+    }
+    return SkipValue(v);
+  });
+}
+
+}  // namespace
+
+// =============================================================================
+// Public API
+// =============================================================================
+
+/**
+ * @brief Classifies a payload by its top-level "type" field.
+ *
+ * @param data Pointer to the JSON text.
+ * @param len Length of the JSON text in bytes.
+ * @return The message type, or kUnknown.
+ */
+MessageType ClassifyMessage(const char* data, size_t len) {
+  Cursor cursor{data, data + len};
+  Envelope env;
+  if (!ParseEnvelope(&cursor, /*stop_at_type=*/true, &env)) {
+    return MessageType::kUnknown;
+  }
+  return env.type;
+}
+
+/**
+ * @brief Decodes a payload into the output matching its "type".
+ *
+ * @param data Pointer to the JSON text; string fields will point into it.
+ * @param len Length of the JSON text in bytes.
+ * @param snapshot Output for "orderbook_snapshot" payloads (may be null).
+ * @param delta Output for "orderbook_delta" payloads (may be null).
+ * @param trade Output for "trade" payloads (may be null).
+ * @return The decoded message type, or kUnknown on failure.
+ */
+MessageType DecodeMessage(const char* data, size_t len,
+                          SnapshotMessage* snapshot,
+                          DeltaMessage* delta,
+                          TradeMessage* trade) {
+  Cursor cursor{data, data + len};
+  Envelope env;
+  if (!ParseEnvelope(&cursor, /*stop_at_type=*/false, &env) ||
+      env.body == nullptr) {
+    return MessageType::kUnknown;
+  }
+
+  Cursor body{env.body, data + len};
+  bool ok = false;
+  switch (env.type) {
+    case MessageType::kSnapshot:
+      ok = snapshot != nullptr && ParseSnapshotBody(&body, snapshot);
+      if (ok) snapshot->seq = env.seq;
+      break;
+    case MessageType::kDelta:
+      ok = delta != nullptr && ParseDeltaBody(&body, delta);
+      if (ok) delta->seq = env.seq;
+      break;
+    case MessageType::kTrade:
+      ok = trade != nullptr && ParseTradeBody(&body, trade);
+      if (ok) trade->seq = env.seq;
+      break;
+    default:
+      break;
+  }
+  return ok ? env.type : MessageType::kUnknown;
+}
+
+/**
+ * @brief Decodes an "orderbook_snapshot" payload.
+ *
+ * @param data Pointer to the JSON text; string fields will point into it.
+ * @param len Length of the JSON text in bytes.
+ * @param out Snapshot to fill.
+ * @return True on success.
+ */
+bool DecodeSnapshot(const char* data, size_t len, SnapshotMessage* out) {
+  return DecodeMessage(data, len, out, nullptr, nullptr) ==
+         MessageType::kSnapshot;
+}
+
+/**
+ * @brief Decodes an "orderbook_delta" payload.
+ *
+ * @param data Pointer to the JSON text; string fields will point into it.
+ * @param len Length of the JSON text in bytes.
+ * @param out Delta to fill.
+ * @return True on success.
+ */
+bool DecodeDelta(const char* data, size_t len, DeltaMessage* out) {
+  return DecodeMessage(data, len, nullptr, out, nullptr) ==
+         MessageType::kDelta;
+}
+
+/**
+ * @brief Decodes a "trade" payload.
+ *
+ * @param data Pointer to the JSON text; string fields will point into it.
+ * @param len Length of the JSON text in bytes.
+ * @param out Trade to fill.
+ * @return True on success.
+ */
+bool DecodeTrade(const char* data, size_t len, TradeMessage* out) {
+  return DecodeMessage(data, len, nullptr, nullptr, out) ==
+         MessageType::kTrade;
+}
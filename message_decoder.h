@@ -0,0 +1,67 @@
+#ifndef PROJECT_MESSAGE_DECODER_H_
+#define PROJECT_MESSAGE_DECODER_H_
+
+#include <cstddef>  // for size_t
+#include "message_types.h"
+
+// ---------------------------------------------------------------------------
+// Zero-copy JSON decoder
+// ---------------------------------------------------------------------------
+/**
+ * @brief Specialized decoder for the venue's "orderbook_snapshot",
+ *        "orderbook_delta" and "trade" websocket payloads.
+ *
+ * The decoder walks the JSON text once, using SIMD (SSE2 when available) to
+ * locate structural characters and digit runs. It never allocates: results
+ * are written into the caller's message aggregates, and every string field
+ * (market_ticker_ptr, market_id_ptr, trade_id_ptr) points directly into the
+ * caller's buffer, which must therefore outlive the decoded message.
+ *
+ * Only the subset of JSON the venue actually emits is supported: integer
+ * numbers, strings without escapes in the fields we extract, and the usual
+ * nesting of objects/arrays. Unknown keys are skipped. Any malformed input
+ * makes the decode functions return false (or MessageType::kUnknown).
+ */
+
+/**
+ * @brief Classifies a payload by its top-level "type" field without decoding
+ *        the body.
+ *
+ * @return kSnapshot, kDelta or kTrade, or kUnknown for any other/invalid type.
+ */
+MessageType ClassifyMessage(const char* data, size_t len);
+
+/**
+ * @brief Decodes a payload into whichever output matches its "type".
+ *
+ * Any output pointer may be null, in which case payloads of that type are
+ * reported as kUnknown. Only the output matching the payload's "type" is
+ * written; if its body then fails to decode, kUnknown is returned and that
+ * output is left partially filled, so its contents must not be used.
+ *
+ * @return The decoded message type, or kUnknown on failure.
+ */
+MessageType DecodeMessage(const char* data, size_t len,
+                          SnapshotMessage* snapshot,
+                          DeltaMessage* delta,
+                          TradeMessage* trade);
+
+/**
+ * @brief Decodes an "orderbook_snapshot" payload.
+ *
+ * @return False if the payload is malformed, is not a snapshot, or holds more
+ *         than kMaxBookLevels levels on one side.
+ */
+bool DecodeSnapshot(const char* data, size_t len, SnapshotMessage* out);
+
+/**
+ * @brief Decodes an "orderbook_delta" payload.
+ */
+bool DecodeDelta(const char* data, size_t len, DeltaMessage* out);
+
+/**
+ * @brief Decodes a "trade" payload.
+ */
+bool DecodeTrade(const char* data, size_t len, TradeMessage* out);
+
+#endif  // PROJECT_MESSAGE_DECODER_H_
@@ -2,6 +2,7 @@
 #define PROJECT_MESSAGE_TYPES_H_
 
 #include <cstddef>  // for size_t
+#include <cstdint>  // for uint8_t, uint32_t, uint64_t
 
 // ---------------------------------------------------------------------------
 // Constants
@@ -45,6 +46,9 @@ struct SnapshotMessage {
   int no_count;
   unsigned int no_price[kMaxBookLevels];
   unsigned int no_qty[kMaxBookLevels];
+
+  // Venue sequence number from the envelope ("seq"); 0 if unsequenced.
+  uint64_t seq;
 };
 
 // ---------------------------------------------------------------------------
@@ -63,6 +67,9 @@ struct DeltaMessage {
   unsigned int price;
   int delta;
   Side side;
+
+  // Venue sequence number from the envelope ("seq"); 0 if unsequenced.
+  uint64_t seq;
 };
 
 // ---------------------------------------------------------------------------
@@ -84,7 +91,59 @@ struct TradeMessage {
   int count;
   Side taker_side;
   int ts;
+
+  // Venue sequence number from the envelope ("seq"); 0 if unsequenced.
+  // Trades arrive on their own channel and are not gap-checked by OrderBook.
+  uint64_t seq;
+};
+
+// ---------------------------------------------------------------------------
+// CompactSnapshotRef
+// ---------------------------------------------------------------------------
+/**
+ * @brief A snapshot as carried by a MessageSlot: the market's identity plus a
+ *        pointer to its compact encoding (compact_snapshot.h). Like the
+ *        string fields, the encoding is not owned and must stay valid until
+ *        the slot has been consumed.
+ */
+struct CompactSnapshotRef {
+  const char* market_ticker_ptr;
+  size_t market_ticker_len;
+
+  const char* market_id_ptr;
+  size_t market_id_len;
+
+  const uint8_t* data;
+  size_t size;
+};
+
+// ---------------------------------------------------------------------------
+// MessageSlot
+// ---------------------------------------------------------------------------
+/**
+ * @brief Fixed-size tagged union of the three message kinds, used as the
+ *        element type of the ingestion ring.
+ *
+ * Snapshots travel by reference to their compact encoding
+ * (MessageArena::EncodeSnapshot fills one in), so a slot is two cache lines
+ * rather than the ~1.6 KB an embedded SnapshotMessage would cost every
+ * delta and trade.
+ *
+ * market_id is an optional routing hint (a BookRegistry::MarketId); leave it
+ * at kUnresolvedMarketId to have the consumer resolve the book by ticker.
+ */
+struct alignas(64) MessageSlot {
+  static constexpr uint32_t kUnresolvedMarketId = UINT32_MAX;
+
+  MessageType type;
+  uint32_t market_id;
+  union {
+    CompactSnapshotRef snapshot;
+    DeltaMessage delta;
+    TradeMessage trade;
+  };
 };
 
+static_assert(sizeof(MessageSlot) <= 128, "MessageSlot should stay small");
 
 #endif  // PROJECT_MESSAGE_TYPES_H_
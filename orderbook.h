@@ -1,68 +1,488 @@
 #ifndef PROJECT_ORDERBOOK_H_
 #define PROJECT_ORDERBOOK_H_
 
+#include <array>   // for std::array
+#include <cstddef> // for size_t
 #include <cstdint> // for uint64_t
+#include <type_traits> // for std::is_unsigned_v
 #include <utility> // for std::pair
 #include <vector>  // for std::vector
 #include <cstring> // for std::memset
+#include <span>    // for std::span
+#include "bitset.h"
+#include "book_kernels.h"
+#include "compact_snapshot.h"
+#include "latency_stats.h"
 #include "message_types.h"
+#include "top_of_book.h"
 
 /**
- * @class OrderBook
+ * @brief What a book does when a delta or trade would take a level below
+ *        zero or past the quantity type's maximum.
+ *
+ * kTrust applies a delta's raw change, so such a level wraps like unsigned
+ * arithmetic (the fastest option); a trade still removes no more than
+ * rests at its level. kClamp saturates the level to [0, max] and counts the
+ * anomaly. kFlagAndResync also saturates and counts, and additionally marks
+ * the book stale so that sequenced deltas are buffered until the next
+ * snapshot resyncs it.
+ */
+enum class ValidationPolicy : uint8_t {
+  kTrust = 0,
+  kClamp,
+  kFlagAndResync,
+};
+
+/**
+ * @brief How ApplyTrade interacts with the venue's own deltas for a fill.
+ *
+ * kApply removes the traded quantity outright; use it when the feed does
+ * not also send a delta for the fill. kProvisional is for venues that
+ * report a fill both as a trade and as an orderbook delta: the trade
+ * removes the quantity at once (capped at what rests) and remembers it,
+ * and the next negative delta on that level is netted against the
+ * remembered amount instead of removing it a second time.
+ */
+enum class TradeHandling : uint8_t {
+  kApply = 0,
+  kProvisional,
+};
+
+/**
+ * @class BasicOrderBook
  *
  * @brief Maintains bids and asks in direct arrays indexed by price, plus
- *        two 128-bit bitsets (one for bids, one for asks) to indicate which
- *        prices have nonzero quantity. BSR/BSF instructions yield O(1)
- *        best-bid/ask lookups. We also provide top-N methods by repeatedly
- *        scanning local copies of these bitsets.
+ *        one bitset per side to indicate which prices have nonzero
+ *        quantity. BSR/BSF instructions yield O(1) best-bid/ask lookups.
+ *        We also provide top-N methods by walking those bitsets.
  *
- * NOTE: This implementation assumes kMaxBookLevels <= 128, because
- * we use a fixed 128-bit bitset. If kMaxBookLevels > 128, you must
- * expand the bitset size or choose another data structure.
+ * @tparam kLevels Number of price levels; prices are [0, kLevels).
+ * @tparam QtyT    Unsigned per-level quantity type.
+ *
+ * The bitset is picked at compile time from the level count (BitsetFor):
+ * one word for up to 64 levels, two words for up to 128 and a two-level
+ * summary bitmap beyond that. OrderBook is the 100-level instantiation used
+ * everywhere else; it is explicitly instantiated in orderbook.cpp.
  */
-class OrderBook
+template <unsigned int kLevels = kMaxBookLevels, typename QtyT = unsigned int>
+class BasicOrderBook
 {
+  static_assert(kLevels > 0U, "BasicOrderBook needs at least one level");
+  static_assert(std::is_unsigned_v<QtyT>,
+                "quantities wrap like unsigned int on negative deltas");
+
 public:
-  /// We store [0..kMaxBookLevels-1] inclusive.
-  static constexpr unsigned int kArraySize = kMaxBookLevels;
+  /// We store [0..kLevels-1] inclusive.
+  static constexpr unsigned int kArraySize = kLevels;
+
+  /// Deltas held while stale, waiting for a resyncing snapshot.
+  static constexpr unsigned int kMaxBufferedDeltas = 64;
+
+  /// Levels with unreconciled provisional trades (TradeHandling::
+  /// kProvisional). When full, entries are dropped round-robin and their
+  /// decrements become final.
+  static constexpr unsigned int kMaxProvisionalTrades = 8;
+
+  using Qty = QtyT;
+  /// Per-side price bitset selected for kLevels.
+  using Bitset = BitsetFor<kLevels>;
+
+  /// (price, quantity) pair as returned by the depth queries.
+  using Level = std::pair<unsigned int, QtyT>;
+
+  BasicOrderBook();
+
+  /**
+   * Sequencing: a snapshot with seq S syncs the book and the next delta is
+   * expected to carry S + 1. A delta that skips ahead marks the book stale;
+   * stale books buffer deltas (up to kMaxBufferedDeltas) instead of applying
+   * them, and the next snapshot replays whichever buffered deltas follow it
+   * contiguously. Messages with seq == 0 are unsequenced and always applied.
+   */
+  void ApplySnapshot(const SnapshotMessage *snap);
+  void ApplySnapshot(const CompactSnapshotView &snap);
+
+  /**
+   * @brief Serializes the current book in the compact snapshot encoding
+   *        (levels ascending by price). The encoded seq is the last applied
+   *        sequence number, or 0 if the book is stale.
+   *
+   * @return Bytes written, or 0 if @p capacity is too small.
+   */
+  size_t EncodeSnapshot(uint8_t *out, size_t capacity) const
+    requires(kLevels <= 256U && sizeof(QtyT) <= sizeof(uint32_t));
+  void ApplyDelta(const DeltaMessage *msg);
+  void ApplyTrade(const TradeMessage *trade);
+
+  /**
+   * @brief ApplyDelta for callers that already know the side at compile
+   *        time; msg->side is ignored.
+   */
+  template <Side kSide>
+  void ApplyDelta(const DeltaMessage *msg);
 
   /**
-   * @brief 128-bit bitset split into two 64-bit parts
+   * @brief Applies a run of deltas for this market in one pass.
+   *
+   * Quantities are updated without touching the bitsets; both bitsets are
+   * then rebuilt once from the arrays. The result is identical to calling
+   * ApplyDelta on each message in order.
    */
-  struct Bitset128
+  void ApplyDeltas(std::span<const DeltaMessage> msgs);
+
+  Level BestBid() const;
+  Level BestAsk() const;
+
+  /// BestBid and BestAsk as one TopOfBook (version 0), for change detection.
+  TopOfBook Touch() const;
+
+  std::vector<Level> GetTopNBids(int n) const;
+  std::vector<Level> GetTopNAsks(int n) const;
+
+  /**
+   * @brief Allocation-free depth queries: write up to out.size() levels
+   *        (best first) into the caller's buffer.
+   *
+   * @return The number of levels written.
+   */
+  size_t GetTopNBids(std::span<Level> out) const;
+  size_t GetTopNAsks(std::span<Level> out) const;
+
+  /**
+   * @brief Result of a walk-the-book fill estimate.
+   *
+   * notional is the sum of price * qty over the levels consumed, so the
+   * average fill price is notional / filled_qty.
+   */
+  struct FillEstimate
   {
-    uint64_t low{0};
-    uint64_t high{0};
-
-    void SetBit(unsigned int pos);
-    void ClearBit(unsigned int pos);
-    bool TestBit(unsigned int pos) const;
-    int HighestSetBit() const;
-    int LowestSetBit() const;
+    uint64_t filled_qty{0};
+    uint64_t notional{0};
   };
 
-  OrderBook();
+  /**
+   * Incremental L2 publication. Every price level whose quantity changes
+   * (through any Apply* call, including levels a snapshot adds or removes)
+   * is marked dirty on its side, so a publisher can forward only what
+   * changed since its last publish: O(changed levels) rather than O(depth).
+   */
+  struct LevelChange
+  {
+    Side side;
+    unsigned int price;
+    QtyT qty;  // New quantity; 0 means the level was removed.
+  };
 
-  void ApplySnapshot(const SnapshotMessage *snap);
-  void ApplyDelta(const DeltaMessage *msg);
-  void ApplyTrade(const TradeMessage *trade);
+  /// Levels changed since they were last collected.
+  unsigned int dirty_level_count() const
+  {
+    return dirty_[kBidIndex].Count() + dirty_[kAskIndex].Count();
+  }
 
-  std::pair<unsigned int, unsigned int> BestBid() const;
-  std::pair<unsigned int, unsigned int> BestAsk() const;
+  /**
+   * @brief Writes up to out.size() changes (bids, then asks, each ascending
+   *        by price) and clears their dirty bits. Call again while
+   *        dirty_level_count() != 0 to drain a larger backlog.
+   *
+   * @return The number of changes written.
+   */
+  size_t CollectChanges(std::span<LevelChange> out);
+
+  /**
+   * @brief Encodes every dirty level as a diff in the compact snapshot
+   *        layout (qty 0 = level removed; unlisted levels unchanged) and
+   *        clears the dirty set. The encoded seq is as for EncodeSnapshot.
+   *        Parse with CompactSnapshotView and apply with ApplyDiff.
+   *
+   * @return Bytes written, or 0 (dirty set kept) if it does not fit.
+   */
+  size_t EncodeDiff(uint8_t *out, size_t capacity)
+    requires(kLevels <= 256U && sizeof(QtyT) <= sizeof(uint32_t));
+
+  /**
+   * @brief Sets each listed level to its quantity, leaving the others as
+   *        they are. Sequencing state is not touched; a mirror book should
+   *        track diff.seq() itself.
+   */
+  void ApplyDiff(const CompactSnapshotView &diff);
+
+  /// Forgets all pending changes (e.g. after publishing a full snapshot).
+  void ClearDirty();
 
-  std::vector<std::pair<unsigned int, unsigned int>> GetTopNBids(int n) const;
-  std::vector<std::pair<unsigned int, unsigned int>> GetTopNAsks(int n) const;
+  /**
+   * @brief Opts in to lock-free top-of-book publication.
+   *
+   * After every ApplySnapshot/ApplyDelta/ApplyDeltas/ApplyTrade the book
+   * publishes its touch into @p published, which other threads may read
+   * without locking. Pass nullptr to stop publishing. The target is owned by
+   * the caller and must outlive the subscription.
+   */
+  void SetPublishedTopOfBook(PublishedTopOfBook *published);
+
+  /// True until a sequenced snapshot syncs the book, and after any gap.
+  bool IsStale() const { return stale_; }
+  /// Sequence number the next delta must carry to be applied directly.
+  uint64_t expected_seq() const { return expected_seq_; }
+  /// Last sequence number the book reflects, or 0 while stale.
+  uint64_t last_applied_seq() const
+  {
+    return stale_ ? 0U : expected_seq_ - 1U;
+  }
+  /// Number of deltas currently held for replay.
+  unsigned int buffered_delta_count() const { return buffered_count_; }
+  /// Number of gaps detected since construction.
+  uint64_t gap_count() const { return gap_count_; }
+
+  /**
+   * @brief Selects how out-of-range level quantities are handled (default
+   *        kTrust). Takes effect from the next Apply* call.
+   */
+  void SetValidationPolicy(ValidationPolicy policy) { policy_ = policy; }
+  ValidationPolicy validation_policy() const { return policy_; }
+  /// Level updates that had to be saturated since construction. Always 0
+  /// under kTrust, which does not check.
+  uint64_t anomaly_count() const { return anomaly_count_; }
+
+  /**
+   * @brief Selects the trade handling mode (default kApply). Switching
+   *        modes forgets any unreconciled provisional trades, leaving their
+   *        decrements in place.
+   */
+  void SetTradeHandling(TradeHandling handling);
+  TradeHandling trade_handling() const { return trade_handling_; }
+  /// Levels still waiting for the delta that confirms a provisional trade.
+  unsigned int provisional_trade_count() const { return provisional_count_; }
+  /// Provisional entries dropped unreconciled because the ring was full.
+  uint64_t provisional_evictions() const { return provisional_evictions_; }
+
+  /// Quantity resting at @p price on @p side's row (kYes = bids, kNo =
+  /// asks); 0 out of range.
+  QtyT QtyAt(Side side, unsigned int price) const
+  {
+    return price < kArraySize ? levels_[SideIndex(side)][price] : QtyT{0};
+  }
+
+  /// Running totals over all resting levels on one side (kYes = bids,
+  /// kNo = asks), maintained incrementally by every Apply* call.
+  uint64_t TotalQty(Side side) const;
+  uint64_t TotalNotional(Side side) const;
+
+  /**
+   * @brief Total quantity resting within @p ticks of the best price on
+   *        @p side (ticks = 0 is the touch only). O(levels in range).
+   */
+  uint64_t CumulativeQtyWithin(Side side, unsigned int ticks) const;
+
+  /**
+   * @brief Walks @p side from the best price until @p qty is filled or the
+   *        side is exhausted. O(levels consumed), no allocation.
+   */
+  FillEstimate CostToFill(Side side, uint64_t qty) const;
+
+  /**
+   * @brief (B - A) / (B + A) where B and A are the bid and ask quantities
+   *        weighted per price, each array kArraySize long and indexed like
+   *        its row (asks by kNo price). One pass over both rows with the
+   *        book_kernels dot product.
+   */
+  double DepthImbalance(const double *bid_weights,
+                        const double *ask_weights) const;
+
+  /**
+   * @brief Quantity of @p side in consecutive bands of @p band_width
+   *        prices, written to @p out from price 0 up. Returns the number
+   *        of bands written.
+   */
+  size_t DepthProfile(Side side, unsigned int band_width,
+                      std::span<uint64_t> out) const;
+
+  /**
+   * @brief Compile-time depth queries returned by value. Slots past the
+   *        last populated level are (0, 0), matching BestBid/BestAsk.
+   */
+  template <size_t N>
+  std::array<Level, N> GetTopNBids() const
+  {
+    std::array<Level, N> levels{};
+    GetTopNBids(std::span<Level>(levels));
+    return levels;
+  }
+
+  template <size_t N>
+  std::array<Level, N> GetTopNAsks() const
+  {
+    std::array<Level, N> levels{};
+    GetTopNAsks(std::span<Level>(levels));
+    return levels;
+  }
+
+  /**
+   * Implied cross-side view for binary markets, where a contract pays
+   * kPayout ticks: a NO bid at p is a YES ask at kPayout - p, and a YES bid
+   * at p is a NO ask at kPayout - p. The stored sides are treated as YES
+   * bids (kYes) and NO bids (kNo).
+   *
+   * Mirroring reverses price order, so the implied asks are just the
+   * opposite side walked from its highest set bit: BestYesAsk is one BSR on
+   * the NO bitset and the implied top-N is O(levels returned), exactly like
+   * the direct queries, with no extra state to maintain on updates.
+   * Empty sides read as (0, 0).
+   */
+  static constexpr unsigned int kPayout = kLevels;
+
+  Level BestYesAsk() const;
+  Level BestNoAsk() const;
+
+  /// Implied asks, lowest price first. @return The number of levels written.
+  size_t GetImpliedTopNYesAsks(std::span<Level> out) const;
+  size_t GetImpliedTopNNoAsks(std::span<Level> out) const;
+
+  template <size_t N>
+  std::array<Level, N> GetImpliedTopNYesAsks() const
+  {
+    std::array<Level, N> levels{};
+    GetImpliedTopNYesAsks(std::span<Level>(levels));
+    return levels;
+  }
+
+  template <size_t N>
+  std::array<Level, N> GetImpliedTopNNoAsks() const
+  {
+    std::array<Level, N> levels{};
+    GetImpliedTopNNoAsks(std::span<Level>(levels));
+    return levels;
+  }
+
+  /**
+   * @brief YES spread against the implied ask: BestYesAsk - best YES bid,
+   *        i.e. kPayout - best YES bid - best NO bid. Zero or negative when
+   *        the two sides cross.
+   *
+   * @return False (leaving @p spread untouched) if either side is empty.
+   */
+  bool ImpliedSpread(int *spread) const;
 
 private:
-  /// Bids array (indexed by price 0..kMaxBookLevels-1).
-  alignas(64) unsigned int bids_[kArraySize];
-  /// Asks array (indexed by price 0..kMaxBookLevels-1).
-  alignas(64) unsigned int asks_[kArraySize];
-
-  /// Which bid prices have nonzero qty
-  Bitset128 bids_bitset_;
-  /// Which ask prices have nonzero qty
-  Bitset128 asks_bitset_;
+  /**
+   * @brief Sequencing-relevant part of a DeltaMessage, kept while stale.
+   */
+  struct BufferedDelta
+  {
+    uint64_t seq;
+    unsigned int price;
+    int delta;
+    Side side;
+  };
+
+  /**
+   * @brief Trade quantity already removed from one level and not yet
+   *        confirmed by a delta; qty == 0 marks a free slot.
+   */
+  struct ProvisionalTrade
+  {
+    unsigned int price;
+    unsigned int side_index;
+    QtyT qty;
+  };
+
+  /// Row of levels_/bitsets_/totals for each side.
+  static constexpr unsigned int kBidIndex = 0;
+  static constexpr unsigned int kAskIndex = 1;
+
+  /// Maps kYes -> kBidIndex and kNo -> kAskIndex; kUndefined maps to
+  /// kBidIndex and must be masked by the caller.
+  static constexpr unsigned int SideIndex(Side side)
+  {
+    return static_cast<unsigned int>(side == Side::kNo);
+  }
+
+  /// ApplyDelta without the sequence check.
+  void ApplyDeltaUnchecked(unsigned int price_value, int delta_value,
+                           Side side);
+  template <Side kSide>
+  void ApplyDeltaUnchecked(unsigned int price_value, int delta_value);
+  /// Adds @p delta_value to one level and re-derives its bit; branch-free
+  /// under kTrust.
+  void ApplyLevelDelta(unsigned int side_index, unsigned int price_value,
+                       int64_t delta_value);
+  /// ApplyLevelDelta for kClamp/kFlagAndResync: saturates the level.
+  void ApplyLevelDeltaChecked(unsigned int side_index,
+                              unsigned int price_value, int64_t delta_value);
+  /// ApplyTrade under kProvisional: removes and remembers the quantity.
+  void ApplyProvisionalTrade(unsigned int side_index, unsigned int price_value,
+                             int64_t remove_qty);
+  /// Nets a delta against a provisional trade on the same level and
+  /// returns what is left to apply.
+  int64_t ReconcileProvisional(unsigned int side_index,
+                               unsigned int price_value, int64_t delta_value);
+  /// Handles any delta that does not match expected_seq_ while synced.
+  void OnSequenceBreak(const DeltaMessage *msg);
+  /// Inserts into the seq-ordered replay buffer (drops dups/overflow).
+  void BufferDelta(const DeltaMessage *msg);
+  /// Applies buffered deltas that continue from expected_seq_.
+  void DrainBufferedDeltas();
+
+  /// Zeroes both sides' quantities and bitsets.
+  void ClearLevels();
+  /// Shared end of ApplySnapshot: totals, resync, publication.
+  void FinishSnapshot(uint64_t seq);
+
+  /// Pushes the current touch to published_, if set.
+  void PublishTopOfBook();
+
+  /// Writes the mirror of one side's levels, highest stored price first.
+  size_t GetImpliedTopN(unsigned int side_index, std::span<Level> out) const;
+
+  /// Recomputes bitsets_ from the quantity arrays.
+  void RebuildBitsets();
+  /// Recomputes the running totals from the quantity arrays.
+  void RecomputeTotals();
+
+  /// Quantity per price, [kBidIndex] = bids and [kAskIndex] = asks
+  /// (each row indexed by price 0..kLevels-1).
+  alignas(64) QtyT levels_[2][kArraySize];
+
+  /// Which prices have nonzero qty, per side.
+  Bitset bitsets_[2];
+
+  /// Levels changed since last collected, per side.
+  Bitset dirty_[2];
+
+  /// Sum of qty and of price * qty over all levels, per side.
+  uint64_t total_qty_[2];
+  uint64_t total_notional_[2];
+
+  /// Opt-in seqlock view of the touch (not owned); nullptr when disabled.
+  PublishedTopOfBook *published_;
+
+  /// Sequence tracking state (see ApplySnapshot/ApplyDelta).
+  uint64_t expected_seq_;
+  uint64_t gap_count_;
+  bool stale_;
+  /// Read on every level update; kept next to the sequence state.
+  ValidationPolicy policy_;
+  /// Set by a kFlagAndResync anomaly: only a snapshot clears stale_.
+  bool resync_pending_;
+  TradeHandling trade_handling_;
+  /// Live provisional_ entries; 0 keeps the delta path off the ring.
+  unsigned int provisional_count_;
+  uint64_t anomaly_count_;
+  unsigned int buffered_count_;
+  /// Seq-ordered deltas awaiting replay; cold unless the book is stale.
+  BufferedDelta buffered_[kMaxBufferedDeltas];
+  /// Provisional trades, one entry per level; next_provisional_ is the
+  /// slot written next (oldest first when the ring is full).
+  ProvisionalTrade provisional_[kMaxProvisionalTrades];
+  unsigned int next_provisional_;
+  uint64_t provisional_evictions_;
 };
 
+/// The 100-level, 32-bit-quantity book used by the registry and feed.
+using OrderBook = BasicOrderBook<>;
+
+#include "orderbook_inl.h"
+
+// Compiled once in orderbook.cpp.
+extern template class BasicOrderBook<kMaxBookLevels, unsigned int>;
+
 #endif // PROJECT_ORDERBOOK_H_
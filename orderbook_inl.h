@@ -0,0 +1,1311 @@
+#ifndef PROJECT_ORDERBOOK_INL_H_
+#define PROJECT_ORDERBOOK_INL_H_
+
+// Member definitions of BasicOrderBook; included from orderbook.h only.
+
+#include <cstring>  // For std::memset
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>  // For AVX-512/AVX2 intrinsics
+#endif
+
+namespace orderbook_detail {
+
+/**
+ * @brief Scatters (price, qty) pairs into one side's array. Out-of-range
+ *        prices are ignored; a repeated price keeps its last quantity.
+ *
+ * With AVX-512 and 32-bit quantities, 16 pairs are stored per masked
+ * scatter (32- or 8-bit price columns). Scatter lanes to the same address
+ * retire in lane order, which preserves last-wins. The caller derives the
+ * bitset from the array afterwards.
+ */
+template <unsigned int kLevels, typename LevelQtyT, typename PriceT,
+          typename QtyT>
+inline void LoadLevels(LevelQtyT* levels, const PriceT* prices,
+                       const QtyT* qtys, int count) {
+  int i = 0;
+#if defined(__AVX512F__)
+  if constexpr (sizeof(LevelQtyT) == 4U && sizeof(QtyT) == 4U &&
+                (sizeof(PriceT) == 4U || sizeof(PriceT) == 1U)) {
+    const __m512i limit = _mm512_set1_epi32(static_cast<int>(kLevels));
+    for (; i + 16 <= count; i += 16) {
+      __m512i index;
+      if constexpr (sizeof(PriceT) == 4U) {
+        index = _mm512_loadu_si512(prices + i);
+      } else {
+        // Zero-masked form: GCC's unmasked wrapper trips
+        // -Wmaybe-uninitialized on its undefined pass-through operand.
+        index = _mm512_maskz_cvtepu8_epi32(
+            0xFFFF,
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(prices + i)));
+      }
+      const __m512i quantity = _mm512_loadu_si512(qtys + i);
+      const __mmask16 in_range = _mm512_cmplt_epu32_mask(index, limit);
+      _mm512_mask_i32scatter_epi32(levels, in_range, index, quantity, 4);
+    }
+  }
+#endif
+  for (; i < count; ++i) {
+    const unsigned int price_value = prices[i];
+    if (price_value < kLevels) {
+      levels[price_value] = static_cast<LevelQtyT>(qtys[i]);
+    }
+  }
+}
+
+/**
+ * @brief Builds a bitset with bit i set iff qty[i] != 0, for i < count.
+ *
+ * For 32-bit quantities this is vectorized: a 16-lane test-mask per step
+ * when built for AVX-512, zero-compares plus movemask (8 lanes) for AVX2.
+ * Builds without either call book_kernels::NonZeroWords, which picks the
+ * widest variant the CPU supports at run time. The tail (and any other
+ * quantity width) is handled scalar so we never read past the array.
+ */
+template <typename BitsetT, typename QtyT>
+inline BitsetT BuildNonZeroBitset(const QtyT* qty, unsigned int count) {
+  uint64_t words[BitsetT::kWords] = {};
+  unsigned int i = 0;
+  if constexpr (sizeof(QtyT) == sizeof(uint32_t)) {
+#if defined(__AVX512F__)
+    for (; i + 16U <= count; i += 16U) {
+      const __m512i v = _mm512_loadu_si512(qty + i);
+      // i is a multiple of 16, so the 16 bits never straddle two words.
+      words[i >> 6U] |= static_cast<uint64_t>(_mm512_test_epi32_mask(v, v))
+                        << (i & 63U);
+    }
+#elif defined(__AVX2__)
+    const __m256i zero8 = _mm256_setzero_si256();
+    for (; i + 8U <= count; i += 8U) {
+      const __m256i v =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(qty + i));
+      const __m256 is_zero = _mm256_castsi256_ps(_mm256_cmpeq_epi32(v, zero8));
+      const uint64_t bits =
+          static_cast<uint64_t>(~_mm256_movemask_ps(is_zero) & 0xFF);
+      // i is a multiple of 8, so the 8 bits never straddle two words.
+      words[i >> 6U] |= bits << (i & 63U);
+    }
+#else
+    book_kernels::NonZeroWords(reinterpret_cast<const uint32_t*>(qty), count,
+                               words);
+    i = count;
+#endif
+  }
+  for (; i < count; ++i) {
+    words[i >> 6U] |= static_cast<uint64_t>(qty[i] != 0U) << (i & 63U);
+  }
+
+  BitsetT result;
+  for (unsigned int w = 0; w < BitsetT::kWords; ++w) {
+    result.SetWord(w, words[w]);
+  }
+  return result;
+}
+
+/**
+ * @brief dst |= src, word by word.
+ */
+template <typename BitsetT>
+inline void OrInto(BitsetT* dst, const BitsetT& src) {
+  for (unsigned int w = 0; w < BitsetT::kWords; ++w) {
+    dst->SetWord(w, dst->Word(w) | src.Word(w));
+  }
+}
+
+/**
+ * @brief Saturating old + delta over [0, max QtyT].
+ *
+ * Narrow quantities are summed in int64 and clamped with two selects; a
+ * 64-bit quantity uses the overflow builtins instead.
+ *
+ * @param out Receives the saturated quantity.
+ * @return True if the result had to be clamped.
+ */
+template <typename QtyT>
+inline bool SaturatingAdd(QtyT old, int64_t delta, QtyT* out) {
+  constexpr QtyT kMax = static_cast<QtyT>(~QtyT{0});
+  if constexpr (sizeof(QtyT) < sizeof(int64_t)) {
+    const int64_t next = static_cast<int64_t>(old) + delta;
+    const int64_t floored = next < 0 ? 0 : next;
+    const int64_t clamped =
+        floored > static_cast<int64_t>(kMax) ? static_cast<int64_t>(kMax)
+                                             : floored;
+    *out = static_cast<QtyT>(clamped);
+    return clamped != next;
+  } else {
+    // Modular negation gives |delta| even for INT64_MIN.
+    const QtyT magnitude = delta < 0 ? QtyT{0} - static_cast<QtyT>(delta)
+                                     : static_cast<QtyT>(delta);
+    QtyT result;
+    if (delta < 0) {
+      const bool under = __builtin_sub_overflow(old, magnitude, &result);
+      *out = under ? QtyT{0} : result;
+      return under;
+    }
+    const bool over = __builtin_add_overflow(old, magnitude, &result);
+    *out = over ? kMax : result;
+    return over;
+  }
+}
+
+}  // namespace orderbook_detail
+
+// =============================================================================
+// BasicOrderBook Method Definitions
+// =============================================================================
+
+/**
+ * @brief Default constructor that initializes the order book with zeroed data.
+ */
+template <unsigned int kLevels, typename QtyT>
+BasicOrderBook<kLevels, QtyT>::BasicOrderBook() {
+  std::memset(levels_, 0, sizeof(levels_));
+  bitsets_[kBidIndex].Clear();
+  bitsets_[kAskIndex].Clear();
+  dirty_[kBidIndex].Clear();
+  dirty_[kAskIndex].Clear();
+  total_qty_[kBidIndex] = 0U;
+  total_notional_[kBidIndex] = 0U;
+  total_qty_[kAskIndex] = 0U;
+  total_notional_[kAskIndex] = 0U;
+  expected_seq_ = 0U;
+  gap_count_ = 0U;
+  stale_ = true;
+  policy_ = ValidationPolicy::kTrust;
+  resync_pending_ = false;
+  anomaly_count_ = 0U;
+  trade_handling_ = TradeHandling::kApply;
+  provisional_count_ = 0U;
+  std::memset(provisional_, 0, sizeof(provisional_));
+  next_provisional_ = 0U;
+  provisional_evictions_ = 0U;
+  buffered_count_ = 0U;
+  published_ = nullptr;
+}
+
+/**
+ * @brief Sets (or clears, with nullptr) the published top-of-book target.
+ *
+ * The current touch is published immediately.
+ *
+ * @param published Caller-owned seqlock view written by this book's thread.
+ */
+template <unsigned int kLevels, typename QtyT>
+void BasicOrderBook<kLevels, QtyT>::SetPublishedTopOfBook(
+    PublishedTopOfBook* published) {
+  published_ = published;
+  PublishTopOfBook();
+}
+
+/**
+ * @brief Publishes the current best bid/ask if publication is enabled.
+ */
+template <unsigned int kLevels, typename QtyT>
+inline void BasicOrderBook<kLevels, QtyT>::PublishTopOfBook() {
+  if (published_ == nullptr) {
+    return;
+  }
+  const Level bid = BestBid();
+  const Level ask = BestAsk();
+  published_->Publish(bid.first, static_cast<unsigned int>(bid.second),
+                      ask.first, static_cast<unsigned int>(ask.second));
+}
+
+/**
+ * @brief Applies a snapshot to the order book, clearing previous data and loading new bids/asks.
+ *
+ * @param snap Pointer to a SnapshotMessage containing bid and ask data.
+ */
+template <unsigned int kLevels, typename QtyT>
+void BasicOrderBook<kLevels, QtyT>::ApplySnapshot(const SnapshotMessage* snap) {
+  ClearLevels();
+  // Load bids ("yes" side), then asks ("no" side).
+  orderbook_detail::LoadLevels<kLevels>(levels_[kBidIndex], snap->yes_price,
+                                        snap->yes_qty, snap->yes_count);
+  orderbook_detail::LoadLevels<kLevels>(levels_[kAskIndex], snap->no_price,
+                                        snap->no_qty, snap->no_count);
+  RebuildBitsets();
+  FinishSnapshot(snap->seq);
+}
+
+/**
+ * @brief Applies a compact (variable-length) snapshot; equivalent to the
+ *        SnapshotMessage overload.
+ *
+ * @param snap A parsed compact snapshot.
+ */
+template <unsigned int kLevels, typename QtyT>
+void BasicOrderBook<kLevels, QtyT>::ApplySnapshot(
+    const CompactSnapshotView& snap) {
+  ClearLevels();
+  orderbook_detail::LoadLevels<kLevels>(levels_[kBidIndex], snap.yes_price(),
+                                        snap.yes_qty(),
+                                        static_cast<int>(snap.yes_count()));
+  orderbook_detail::LoadLevels<kLevels>(levels_[kAskIndex], snap.no_price(),
+                                        snap.no_qty(),
+                                        static_cast<int>(snap.no_count()));
+  RebuildBitsets();
+  FinishSnapshot(snap.seq());
+}
+
+/**
+ * @brief Writes the book as a compact snapshot.
+ *
+ * Only available when prices fit the encoding's 8-bit price columns and
+ * quantities its 32-bit quantity columns.
+ *
+ * @param out 4-byte-aligned destination.
+ * @param capacity Bytes available at @p out (kMaxCompactSnapshotSize always
+ *        suffices for the default book).
+ * @return Bytes written, or 0 on failure.
+ */
+template <unsigned int kLevels, typename QtyT>
+size_t BasicOrderBook<kLevels, QtyT>::EncodeSnapshot(uint8_t* out,
+                                                     size_t capacity) const
+  requires(kLevels <= 256U && sizeof(QtyT) <= sizeof(uint32_t))
+{
+  const unsigned int yes_count = bitsets_[kBidIndex].Count();
+  const unsigned int no_count = bitsets_[kAskIndex].Count();
+  const size_t size = CompactSnapshotSize(yes_count, no_count);
+  if (yes_count > kMaxBookLevels || no_count > kMaxBookLevels ||
+      size > capacity || (reinterpret_cast<uintptr_t>(out) & 3U) != 0U) {
+    return 0U;
+  }
+
+  CompactSnapshotHeader header;
+  header.size_bytes = static_cast<uint32_t>(size);
+  header.yes_count = static_cast<uint16_t>(yes_count);
+  header.no_count = static_cast<uint16_t>(no_count);
+  header.seq = last_applied_seq();
+  std::memset(out, 0, size);
+  std::memcpy(out, &header, sizeof(header));
+
+  uint32_t* yes_qty = reinterpret_cast<uint32_t*>(out + sizeof(header));
+  uint32_t* no_qty = yes_qty + yes_count;
+  uint8_t* yes_price = reinterpret_cast<uint8_t*>(no_qty + no_count);
+  uint8_t* no_price = yes_price + yes_count;
+
+  unsigned int i = 0U;
+  bitsets_[kBidIndex].ForEachInRange(0U, kArraySize - 1U, [&](unsigned int p) {
+    yes_qty[i] = levels_[kBidIndex][p];
+    yes_price[i++] = static_cast<uint8_t>(p);
+  });
+  i = 0U;
+  bitsets_[kAskIndex].ForEachInRange(0U, kArraySize - 1U, [&](unsigned int p) {
+    no_qty[i] = levels_[kAskIndex][p];
+    no_price[i++] = static_cast<uint8_t>(p);
+  });
+  return size;
+}
+
+/**
+ * @brief Drains dirty levels into a caller buffer.
+ *
+ * @param out Destination; at most out.size() changes are written.
+ * @return The number of changes written.
+ */
+template <unsigned int kLevels, typename QtyT>
+size_t BasicOrderBook<kLevels, QtyT>::CollectChanges(
+    std::span<LevelChange> out) {
+  size_t count = 0;
+  for (unsigned int side = 0; side < 2U && count < out.size(); ++side) {
+    const Side side_value = side == kBidIndex ? Side::kYes : Side::kNo;
+    // The walk reads its own copy of each word, so clearing as we go is safe.
+    dirty_[side].ForEachAscending([&](unsigned int price) {
+      out[count++] = LevelChange{side_value, price, levels_[side][price]};
+      dirty_[side].ClearBit(price);
+      return count < out.size();
+    });
+  }
+  return count;
+}
+
+/**
+ * @brief Encodes the dirty levels as a compact diff and clears them.
+ *
+ * @param out 4-byte-aligned destination.
+ * @param capacity Bytes available at @p out.
+ * @return Bytes written, or 0 on failure.
+ */
+template <unsigned int kLevels, typename QtyT>
+size_t BasicOrderBook<kLevels, QtyT>::EncodeDiff(uint8_t* out,
+                                                 size_t capacity)
+  requires(kLevels <= 256U && sizeof(QtyT) <= sizeof(uint32_t))
+{
+  const unsigned int yes_count = dirty_[kBidIndex].Count();
+  const unsigned int no_count = dirty_[kAskIndex].Count();
+  const size_t size = CompactSnapshotSize(yes_count, no_count);
+  if (yes_count > kMaxBookLevels || no_count > kMaxBookLevels ||
+      size > capacity || (reinterpret_cast<uintptr_t>(out) & 3U) != 0U) {
+    return 0U;
+  }
+
+  CompactSnapshotHeader header;
+  header.size_bytes = static_cast<uint32_t>(size);
+  header.yes_count = static_cast<uint16_t>(yes_count);
+  header.no_count = static_cast<uint16_t>(no_count);
+  header.seq = last_applied_seq();
+  std::memset(out, 0, size);
+  std::memcpy(out, &header, sizeof(header));
+
+  uint32_t* qty = reinterpret_cast<uint32_t*>(out + sizeof(header));
+  uint8_t* price = reinterpret_cast<uint8_t*>(qty + yes_count + no_count);
+  unsigned int i = 0U;
+  for (unsigned int side = 0; side < 2U; ++side) {
+    dirty_[side].ForEachAscending([&](unsigned int p) {
+      qty[i] = levels_[side][p];
+      price[i++] = static_cast<uint8_t>(p);
+      return true;
+    });
+  }
+  ClearDirty();
+  return size;
+}
+
+/**
+ * @brief Applies a diff produced by EncodeDiff.
+ *
+ * @param diff A parsed diff; out-of-range prices are ignored.
+ */
+template <unsigned int kLevels, typename QtyT>
+void BasicOrderBook<kLevels, QtyT>::ApplyDiff(const CompactSnapshotView& diff) {
+  const uint32_t* const qtys[2] = {diff.yes_qty(), diff.no_qty()};
+  const uint8_t* const prices[2] = {diff.yes_price(), diff.no_price()};
+  const unsigned int counts[2] = {diff.yes_count(), diff.no_count()};
+  for (unsigned int side = 0; side < 2U; ++side) {
+    for (unsigned int i = 0; i < counts[side]; ++i) {
+      const unsigned int price_value = prices[side][i];
+      if (price_value >= kArraySize) {
+        continue;
+      }
+      const QtyT target = static_cast<QtyT>(qtys[side][i]);
+      ApplyLevelDelta(side, price_value,
+                      static_cast<int64_t>(target) -
+                          static_cast<int64_t>(levels_[side][price_value]));
+    }
+  }
+  PublishTopOfBook();
+}
+
+/**
+ * @brief Clears both dirty sets.
+ */
+template <unsigned int kLevels, typename QtyT>
+void BasicOrderBook<kLevels, QtyT>::ClearDirty() {
+  dirty_[kBidIndex].Clear();
+  dirty_[kAskIndex].Clear();
+}
+
+/**
+ * @brief Zeroes both quantity arrays and bitsets. Every level that was
+ *        populated is marked dirty.
+ */
+template <unsigned int kLevels, typename QtyT>
+void BasicOrderBook<kLevels, QtyT>::ClearLevels() {
+  orderbook_detail::OrInto(&dirty_[kBidIndex], bitsets_[kBidIndex]);
+  orderbook_detail::OrInto(&dirty_[kAskIndex], bitsets_[kAskIndex]);
+  std::memset(levels_, 0, sizeof(levels_));
+  bitsets_[kBidIndex].Clear();
+  bitsets_[kAskIndex].Clear();
+}
+
+/**
+ * @brief Common tail of every ApplySnapshot overload: totals, sequencing,
+ *        publication.
+ *
+ * @param seq The snapshot's sequence number (0 if unsequenced).
+ */
+template <unsigned int kLevels, typename QtyT>
+void BasicOrderBook<kLevels, QtyT>::FinishSnapshot(uint64_t seq) {
+  // Levels the snapshot populated are dirty too (ClearLevels marked the old
+  // ones); a level restored to its old qty is reported redundantly.
+  orderbook_detail::OrInto(&dirty_[kBidIndex], bitsets_[kBidIndex]);
+  orderbook_detail::OrInto(&dirty_[kAskIndex], bitsets_[kAskIndex]);
+  RecomputeTotals();
+  resync_pending_ = false;
+  // The snapshot already reflects any fill we were holding a trade for.
+  std::memset(provisional_, 0, sizeof(provisional_));
+  provisional_count_ = 0U;
+
+  // Resync: replay whatever buffered deltas continue from this snapshot.
+  // An unsequenced snapshot cannot anchor sequenced deltas, so it leaves the
+  // book stale (unsequenced deltas still apply).
+  if (seq == 0U) {
+    stale_ = true;
+    buffered_count_ = 0U;
+  } else {
+    expected_seq_ = seq + 1U;
+    stale_ = false;
+    DrainBufferedDeltas();
+  }
+
+  PublishTopOfBook();
+}
+
+/**
+ * @brief Applies a delta update to the order book, adjusting the specified side's quantity.
+ *
+ * The sequence check is a single, normally not-taken branch; anything other
+ * than the expected in-order delta on a synced book goes to OnSequenceBreak.
+ *
+ * @param msg Pointer to a DeltaMessage indicating side, price, and delta quantity.
+ */
+template <unsigned int kLevels, typename QtyT>
+void BasicOrderBook<kLevels, QtyT>::ApplyDelta(const DeltaMessage* msg) {
+  if (__builtin_expect((msg->seq != expected_seq_) | stale_, 0)) {
+    OnSequenceBreak(msg);
+  } else {
+    ++expected_seq_;
+    ApplyDeltaUnchecked(msg->price, msg->delta, msg->side);
+  }
+  PublishTopOfBook();
+}
+
+/**
+ * @brief ApplyDelta with the side fixed at compile time.
+ *
+ * @param msg Delta to apply; its side field is not read.
+ */
+template <unsigned int kLevels, typename QtyT>
+template <Side kSide>
+void BasicOrderBook<kLevels, QtyT>::ApplyDelta(const DeltaMessage* msg) {
+  if (__builtin_expect((msg->seq != expected_seq_) | stale_, 0)) {
+    DeltaMessage sided = *msg;
+    sided.side = kSide;
+    OnSequenceBreak(&sided);
+  } else {
+    ++expected_seq_;
+    ApplyDeltaUnchecked<kSide>(msg->price, msg->delta);
+  }
+  PublishTopOfBook();
+}
+
+/**
+ * @brief Adds a signed quantity to one level and recomputes its bit from
+ *        (qty != 0).
+ *
+ * Under kTrust there are no data-dependent branches: the side is an array
+ * index and the bit is assigned rather than chosen between SetBit and
+ * ClearBit. The policy test itself is invariant for the book, so it is
+ * always predicted.
+ *
+ * @param side_index kBidIndex or kAskIndex.
+ * @param price_value Price level; must be < kArraySize.
+ * @param delta_value Signed quantity change (0 leaves the level as is).
+ */
+template <unsigned int kLevels, typename QtyT>
+inline void BasicOrderBook<kLevels, QtyT>::ApplyLevelDelta(
+    unsigned int side_index, unsigned int price_value, int64_t delta_value) {
+  if (__builtin_expect(policy_ != ValidationPolicy::kTrust, 0)) {
+    ApplyLevelDeltaChecked(side_index, price_value, delta_value);
+    return;
+  }
+  QtyT& level = levels_[side_index][price_value];
+  level += static_cast<QtyT>(delta_value);
+  total_qty_[side_index] += static_cast<uint64_t>(delta_value);
+  total_notional_[side_index] +=
+      static_cast<uint64_t>(delta_value * price_value);
+  bitsets_[side_index].AssignBit(price_value, level != 0U);
+  dirty_[side_index].SetBitIf(price_value, delta_value != 0);
+}
+
+/**
+ * @brief ApplyLevelDelta under kClamp or kFlagAndResync.
+ *
+ * The level saturates at 0 and at the quantity type's maximum, and the
+ * totals move by the change actually applied, so they stay equal to the
+ * sum over the levels. A saturated update is counted and, under
+ * kFlagAndResync, marks the book stale until the next snapshot.
+ *
+ * @param side_index kBidIndex or kAskIndex.
+ * @param price_value Price level; must be < kArraySize.
+ * @param delta_value Signed quantity change.
+ */
+template <unsigned int kLevels, typename QtyT>
+void BasicOrderBook<kLevels, QtyT>::ApplyLevelDeltaChecked(
+    unsigned int side_index, unsigned int price_value, int64_t delta_value) {
+  QtyT& level = levels_[side_index][price_value];
+  const QtyT old = level;
+  const bool clamped =
+      orderbook_detail::SaturatingAdd<QtyT>(old, delta_value, &level);
+  const uint64_t applied =
+      static_cast<uint64_t>(level) - static_cast<uint64_t>(old);
+  total_qty_[side_index] += applied;
+  total_notional_[side_index] += applied * price_value;
+  bitsets_[side_index].AssignBit(price_value, level != 0U);
+  dirty_[side_index].SetBitIf(price_value, level != old);
+  anomaly_count_ += static_cast<uint64_t>(clamped);
+  resync_pending_ |= clamped & (policy_ == ValidationPolicy::kFlagAndResync);
+  stale_ |= resync_pending_;
+}
+
+/**
+ * @brief Adjusts one level's quantity without any sequence checks.
+ *
+ * @param price_value Price level.
+ * @param delta_value Signed quantity change.
+ * @param side kYes for bids, kNo for asks; anything else is ignored.
+ */
+template <unsigned int kLevels, typename QtyT>
+void BasicOrderBook<kLevels, QtyT>::ApplyDeltaUnchecked(
+    unsigned int price_value, int delta_value, Side side) {
+  if (price_value >= kArraySize) {
+    // Out of range -- ignore or handle error (no functionality changes here).
+    return;
+  }
+  // An undefined (or corrupt) side contributes a zero delta to the bid row,
+  // which leaves the level and its bit unchanged.
+  const int64_t keep =
+      -static_cast<int64_t>((side == Side::kYes) | (side == Side::kNo));
+  int64_t masked = static_cast<int64_t>(delta_value) & keep;
+  if (__builtin_expect(provisional_count_ != 0U, 0)) {
+    masked = ReconcileProvisional(SideIndex(side), price_value, masked);
+  }
+  ApplyLevelDelta(SideIndex(side), price_value, masked);
+}
+
+/**
+ * @brief ApplyDeltaUnchecked with the side fixed at compile time.
+ *
+ * @param price_value Price level.
+ * @param delta_value Signed quantity change.
+ */
+template <unsigned int kLevels, typename QtyT>
+template <Side kSide>
+void BasicOrderBook<kLevels, QtyT>::ApplyDeltaUnchecked(
+    unsigned int price_value, int delta_value) {
+  static_assert(kSide == Side::kYes || kSide == Side::kNo,
+                "a delta must target a book side");
+  if (price_value >= kArraySize) {
+    return;
+  }
+  int64_t value = delta_value;
+  if (__builtin_expect(provisional_count_ != 0U, 0)) {
+    value = ReconcileProvisional(SideIndex(kSide), price_value, value);
+  }
+  ApplyLevelDelta(SideIndex(kSide), price_value, value);
+}
+
+/**
+ * @brief Slow path for deltas that are unsequenced, out of order, or arrive
+ *        while the book is stale.
+ *
+ * @param msg The delta that failed the in-order check.
+ */
+template <unsigned int kLevels, typename QtyT>
+void BasicOrderBook<kLevels, QtyT>::OnSequenceBreak(const DeltaMessage* msg) {
+  const uint64_t seq = msg->seq;
+  if (seq == 0U) {
+    // Unsequenced feed: apply as-is, leave sequencing state untouched.
+    ApplyDeltaUnchecked(msg->price, msg->delta, msg->side);
+    return;
+  }
+  if (!stale_ && seq < expected_seq_) {
+    return;  // Duplicate or already covered by the last snapshot.
+  }
+  if (stale_ && !resync_pending_ && seq == expected_seq_ &&
+      expected_seq_ != 0U) {
+    // The missing delta arrived late: apply it and try to catch up from the
+    // buffer without waiting for a snapshot.
+    ++expected_seq_;
+    ApplyDeltaUnchecked(msg->price, msg->delta, msg->side);
+    DrainBufferedDeltas();
+    return;
+  }
+  if (!stale_) {
+    stale_ = true;
+    ++gap_count_;
+  }
+  BufferDelta(msg);
+}
+
+/**
+ * @brief Inserts a delta into the replay buffer, keeping it ordered by seq.
+ *
+ * Duplicates are dropped. When the buffer is full, the newest deltas are
+ * dropped; the resulting hole is detected as a fresh gap after replay.
+ *
+ * @param msg Delta to hold.
+ */
+template <unsigned int kLevels, typename QtyT>
+void BasicOrderBook<kLevels, QtyT>::BufferDelta(const DeltaMessage* msg) {
+  const uint64_t seq = msg->seq;
+  unsigned int pos = buffered_count_;
+  while (pos > 0U && buffered_[pos - 1U].seq > seq) {
+    --pos;
+  }
+  if (pos > 0U && buffered_[pos - 1U].seq == seq) {
+    return;  // Duplicate.
+  }
+  if (buffered_count_ == kMaxBufferedDeltas) {
+    if (pos == kMaxBufferedDeltas) {
+      return;  // Newer than everything held; drop.
+    }
+    --buffered_count_;  // Evict the newest to make room.
+  }
+  std::memmove(&buffered_[pos + 1U], &buffered_[pos],
+               (buffered_count_ - pos) * sizeof(BufferedDelta));
+  buffered_[pos] = BufferedDelta{seq, msg->price, msg->delta, msg->side};
+  ++buffered_count_;
+}
+
+/**
+ * @brief Replays buffered deltas that continue from expected_seq_.
+ *
+ * Entries older than expected_seq_ are discarded. If the buffer empties
+ * without hitting another hole the book is synced again; otherwise it stays
+ * stale and keeps the remaining entries.
+ */
+template <unsigned int kLevels, typename QtyT>
+void BasicOrderBook<kLevels, QtyT>::DrainBufferedDeltas() {
+  unsigned int i = 0U;
+  for (; i < buffered_count_; ++i) {
+    const BufferedDelta& held = buffered_[i];
+    if (held.seq < expected_seq_) {
+      continue;
+    }
+    if (held.seq != expected_seq_) {
+      break;  // Still a hole.
+    }
+    ++expected_seq_;
+    ApplyDeltaUnchecked(held.price, held.delta, held.side);
+  }
+
+  const unsigned int remaining = buffered_count_ - i;
+  std::memmove(&buffered_[0], &buffered_[i], remaining * sizeof(BufferedDelta));
+  buffered_count_ = remaining;
+  stale_ = (remaining != 0U) | resync_pending_;
+}
+
+/**
+ * @brief Applies a batch of deltas, deferring bitset maintenance to the end.
+ *
+ * Each delta is a branch-free add into the side's array (an undefined side
+ * contributes zero); only out-of-range prices are skipped. The bitsets are
+ * rebuilt once after the whole run, so best bid/ask reflect the final state.
+ * Runs that do not continue the expected sequence are applied one by one.
+ *
+ * @param msgs Deltas for this market, in feed order.
+ */
+template <unsigned int kLevels, typename QtyT>
+void BasicOrderBook<kLevels, QtyT>::ApplyDeltas(
+    std::span<const DeltaMessage> msgs) {
+  // The fast path needs the whole run to continue the sequence exactly (or
+  // to be entirely unsequenced). Otherwise fall back to per-message handling
+  // so the gap/buffer logic sees every delta.
+  uint64_t in_order = !stale_;
+  uint64_t unsequenced = 1U;
+  uint64_t next_seq = expected_seq_;
+  for (const DeltaMessage& msg : msgs) {
+    in_order &= static_cast<uint64_t>(msg.seq == next_seq);
+    unsequenced &= static_cast<uint64_t>(msg.seq == 0U);
+    ++next_seq;
+  }
+  if (__builtin_expect((in_order | unsequenced) == 0U, 0)) {
+    for (const DeltaMessage& msg : msgs) {
+      ApplyDelta(&msg);
+    }
+    return;
+  }
+  if (__builtin_expect((policy_ != ValidationPolicy::kTrust) |
+                           (provisional_count_ != 0U),
+                       0)) {
+    // Validated runs, and runs that may confirm provisional trades, go
+    // level by level. A kFlagAndResync anomaly marks the book stale
+    // mid-run; the rest of the run is then buffered as ApplyDelta would.
+    for (size_t i = 0; i < msgs.size(); ++i) {
+      if (__builtin_expect(stale_, 0)) {
+        for (; i < msgs.size(); ++i) {
+          ApplyDelta(&msgs[i]);
+        }
+        return;
+      }
+      expected_seq_ += in_order;
+      ApplyDeltaUnchecked(msgs[i].price, msgs[i].delta, msgs[i].side);
+    }
+    PublishTopOfBook();
+    return;
+  }
+  if (in_order != 0U) {
+    expected_seq_ = next_seq;
+  }
+
+  // kUndefined maps onto the bid row with a zeroed delta.
+  for (const DeltaMessage& msg : msgs) {
+    const unsigned int price_value = msg.price;
+    if (price_value >= kArraySize) {
+      continue;
+    }
+    const unsigned int side_index = SideIndex(msg.side);
+    const int64_t keep = -static_cast<int64_t>(
+        (msg.side == Side::kYes) | (msg.side == Side::kNo));
+    const int64_t delta_value = static_cast<int64_t>(msg.delta) & keep;
+    levels_[side_index][price_value] += static_cast<QtyT>(delta_value);
+    dirty_[side_index].SetBitIf(price_value, delta_value != 0);
+    total_qty_[side_index] += static_cast<uint64_t>(delta_value);
+    total_notional_[side_index] +=
+        static_cast<uint64_t>(delta_value * price_value);
+  }
+
+  RebuildBitsets();
+  PublishTopOfBook();
+}
+
+/**
+ * @brief Recomputes both bitsets from the quantity arrays.
+ */
+template <unsigned int kLevels, typename QtyT>
+void BasicOrderBook<kLevels, QtyT>::RebuildBitsets() {
+  for (unsigned int side = 0; side < 2U; ++side) {
+    bitsets_[side] =
+        orderbook_detail::BuildNonZeroBitset<Bitset>(levels_[side], kArraySize);
+  }
+}
+
+/**
+ * @brief Recomputes the running totals from the quantity arrays.
+ */
+template <unsigned int kLevels, typename QtyT>
+void BasicOrderBook<kLevels, QtyT>::RecomputeTotals() {
+  if constexpr (sizeof(QtyT) == sizeof(uint32_t)) {
+    for (unsigned int side = 0; side < 2U; ++side) {
+      const LevelSums sums = book_kernels::SumLevels(
+          reinterpret_cast<const uint32_t*>(levels_[side]), kArraySize);
+      total_qty_[side] = sums.qty;
+      total_notional_[side] = sums.notional;
+    }
+  } else {
+    for (unsigned int side = 0; side < 2U; ++side) {
+      uint64_t qty = 0U;
+      uint64_t notional = 0U;
+      for (unsigned int price = 0; price < kArraySize; ++price) {
+        qty += levels_[side][price];
+        notional += static_cast<uint64_t>(levels_[side][price]) * price;
+      }
+      total_qty_[side] = qty;
+      total_notional_[side] = notional;
+    }
+  }
+}
+
+/**
+ * @brief Applies a trade message, removing executed quantity from the matched side of the book.
+ *
+ * Under TradeHandling::kProvisional the removal is remembered so that the
+ * venue's delta for the same fill does not remove it again. Under kTrust a
+ * trade removes at most the quantity resting at its level, so a fill the
+ * venue already reported as a delta cannot wrap the level into view.
+ *
+ * @param trade Pointer to a TradeMessage containing trade details.
+ */
+template <unsigned int kLevels, typename QtyT>
+void BasicOrderBook<kLevels, QtyT>::ApplyTrade(const TradeMessage* trade) {
+  // The quantity to remove from the side that was "hit."
+  const int remove_qty = trade->count;
+  if (remove_qty <= 0) {
+    return;  // No removal.
+  }
+
+  // A "yes" taker consumes "no" orders from the ask side at no_price; a
+  // "no" taker consumes "yes" orders from the bid side at yes_price. Both
+  // are selected by index; an undefined taker side removes nothing.
+  const Side taker = trade->taker_side;
+  const unsigned int side_index =
+      static_cast<unsigned int>(taker == Side::kYes) ? kAskIndex : kBidIndex;
+  const unsigned int price_value =
+      side_index == kAskIndex ? trade->no_price : trade->yes_price;
+  if (price_value < kArraySize) {
+    const int64_t keep =
+        -static_cast<int64_t>((taker == Side::kYes) | (taker == Side::kNo));
+    if (__builtin_expect(trade_handling_ == TradeHandling::kProvisional, 0)) {
+      ApplyProvisionalTrade(side_index, price_value,
+                            static_cast<int64_t>(remove_qty) & keep);
+    } else {
+      int64_t removed = static_cast<int64_t>(remove_qty) & keep;
+      if (policy_ == ValidationPolicy::kTrust) {
+        // The checked policies saturate (and count) in ApplyLevelDelta.
+        const int64_t resting =
+            static_cast<int64_t>(levels_[side_index][price_value]);
+        removed = removed < resting ? removed : resting;
+      }
+      ApplyLevelDelta(side_index, price_value, -removed);
+    }
+  }
+
+  PublishTopOfBook();
+}
+
+/**
+ * @brief Switches trade handling, dropping any provisional entries.
+ *
+ * @param handling kApply or kProvisional.
+ */
+template <unsigned int kLevels, typename QtyT>
+void BasicOrderBook<kLevels, QtyT>::SetTradeHandling(TradeHandling handling) {
+  trade_handling_ = handling;
+  std::memset(provisional_, 0, sizeof(provisional_));
+  provisional_count_ = 0U;
+}
+
+/**
+ * @brief Removes up to @p remove_qty from a level and records the amount
+ *        actually removed as a provisional trade on that level.
+ *
+ * Repeated trades on one level accumulate into the same entry. A new level
+ * takes a free slot if there is one; otherwise the slot at
+ * next_provisional_ is evicted and its decrement stands.
+ *
+ * @param side_index kBidIndex or kAskIndex.
+ * @param price_value Price level; must be < kArraySize.
+ * @param remove_qty Traded quantity (>= 0).
+ */
+template <unsigned int kLevels, typename QtyT>
+void BasicOrderBook<kLevels, QtyT>::ApplyProvisionalTrade(
+    unsigned int side_index, unsigned int price_value, int64_t remove_qty) {
+  const QtyT resting = levels_[side_index][price_value];
+  const QtyT removed =
+      static_cast<uint64_t>(remove_qty) < static_cast<uint64_t>(resting)
+          ? static_cast<QtyT>(remove_qty)
+          : resting;
+  if (removed == 0U) {
+    return;
+  }
+  ApplyLevelDelta(side_index, price_value, -static_cast<int64_t>(removed));
+
+  unsigned int free_slot = kMaxProvisionalTrades;
+  for (unsigned int i = 0; i < kMaxProvisionalTrades; ++i) {
+    ProvisionalTrade& entry = provisional_[i];
+    if (entry.qty == 0U) {
+      free_slot = free_slot == kMaxProvisionalTrades ? i : free_slot;
+    } else if (entry.price == price_value && entry.side_index == side_index) {
+      entry.qty += removed;
+      return;
+    }
+  }
+  if (free_slot == kMaxProvisionalTrades) {
+    free_slot = next_provisional_;
+    next_provisional_ = (next_provisional_ + 1U) % kMaxProvisionalTrades;
+    ++provisional_evictions_;
+  } else {
+    ++provisional_count_;
+  }
+  provisional_[free_slot] = ProvisionalTrade{price_value, side_index, removed};
+}
+
+/**
+ * @brief Nets a delta against the provisional trade on its level, if any.
+ *
+ * A negative delta first confirms quantity the trade already removed; only
+ * the excess is applied. Positive deltas and levels without an entry pass
+ * through unchanged.
+ *
+ * @param side_index kBidIndex or kAskIndex.
+ * @param price_value Price level.
+ * @param delta_value Signed quantity change from the feed.
+ * @return The part of @p delta_value still to apply.
+ */
+template <unsigned int kLevels, typename QtyT>
+int64_t BasicOrderBook<kLevels, QtyT>::ReconcileProvisional(
+    unsigned int side_index, unsigned int price_value, int64_t delta_value) {
+  if (delta_value >= 0) {
+    return delta_value;
+  }
+  for (unsigned int i = 0; i < kMaxProvisionalTrades; ++i) {
+    ProvisionalTrade& entry = provisional_[i];
+    if (entry.qty == 0U || entry.price != price_value ||
+        entry.side_index != side_index) {
+      continue;
+    }
+    const uint64_t wanted = static_cast<uint64_t>(-delta_value);
+    const QtyT confirmed =
+        wanted < static_cast<uint64_t>(entry.qty) ? static_cast<QtyT>(wanted)
+                                                  : entry.qty;
+    entry.qty -= confirmed;
+    provisional_count_ -= static_cast<unsigned int>(entry.qty == 0U);
+    return delta_value + static_cast<int64_t>(confirmed);
+  }
+  return delta_value;
+}
+
+/**
+ * @brief Retrieves the best bid (highest price) and its quantity.
+ *
+ * @return A pair of (price, quantity), or (0, 0) if no valid bid exists.
+ */
+template <unsigned int kLevels, typename QtyT>
+typename BasicOrderBook<kLevels, QtyT>::Level
+BasicOrderBook<kLevels, QtyT>::BestBid() const {
+  int idx = bitsets_[kBidIndex].HighestSetBit();
+  if (idx >= 0 && static_cast<unsigned int>(idx) < kArraySize) {
+    return {static_cast<unsigned int>(idx), levels_[kBidIndex][idx]};
+  }
+  return {0U, 0U};  // No valid bid.
+}
+
+/**
+ * @brief Retrieves the best ask (lowest price) and its quantity.
+ *
+ * @return A pair of (price, quantity), or (0, 0) if no valid ask exists.
+ */
+template <unsigned int kLevels, typename QtyT>
+typename BasicOrderBook<kLevels, QtyT>::Level
+BasicOrderBook<kLevels, QtyT>::BestAsk() const {
+  int idx = bitsets_[kAskIndex].LowestSetBit();
+  if (idx >= 0 && static_cast<unsigned int>(idx) < kArraySize) {
+    return {static_cast<unsigned int>(idx), levels_[kAskIndex][idx]};
+  }
+  return {0U, 0U};  // No valid ask.
+}
+
+/**
+ * @brief Current touch: the highest bid and lowest ask with their quantities.
+ *
+ * @return The touch; empty sides are (0, 0) and version is 0.
+ */
+template <unsigned int kLevels, typename QtyT>
+TopOfBook BasicOrderBook<kLevels, QtyT>::Touch() const {
+  const Level bid = BestBid();
+  const Level ask = BestAsk();
+  TopOfBook touch;
+  touch.bid_price = bid.first;
+  touch.bid_qty = static_cast<unsigned int>(bid.second);
+  touch.ask_price = ask.first;
+  touch.ask_qty = static_cast<unsigned int>(ask.second);
+  return touch;
+}
+
+/**
+ * @brief Retrieves the top N bids in descending order of price.
+ *
+ * @param n The number of bids to retrieve.
+ * @return A vector of (price, quantity) pairs, from highest to lowest.
+ */
+template <unsigned int kLevels, typename QtyT>
+std::vector<typename BasicOrderBook<kLevels, QtyT>::Level>
+BasicOrderBook<kLevels, QtyT>::GetTopNBids(int n) const {
+  std::vector<Level> result(n > 0 ? n : 0);
+  result.resize(GetTopNBids(std::span<Level>(result)));
+  return result;
+}
+
+/**
+ * @brief Retrieves the top N asks in ascending order of price.
+ *
+ * @param n The number of asks to retrieve.
+ * @return A vector of (price, quantity) pairs, from lowest to highest.
+ */
+template <unsigned int kLevels, typename QtyT>
+std::vector<typename BasicOrderBook<kLevels, QtyT>::Level>
+BasicOrderBook<kLevels, QtyT>::GetTopNAsks(int n) const {
+  std::vector<Level> result(n > 0 ? n : 0);
+  result.resize(GetTopNAsks(std::span<Level>(result)));
+  return result;
+}
+
+/**
+ * @brief Writes the top bids, highest price first, into a caller buffer.
+ *
+ * Pops set bits straight off the bitset words (highest first) rather than
+ * round-tripping through ClearBit on a copy.
+ *
+ * @param out Destination; at most out.size() levels are written.
+ * @return The number of levels written.
+ */
+template <unsigned int kLevels, typename QtyT>
+size_t BasicOrderBook<kLevels, QtyT>::GetTopNBids(std::span<Level> out) const {
+  ORDERBOOK_LATENCY_SCOPE(LatencyOp::kTopN, LatencyStats::kNoMarket);
+  size_t count = 0;
+  if (out.empty()) return count;
+  const QtyT* bids = levels_[kBidIndex];
+  bitsets_[kBidIndex].ForEachDescending([&](unsigned int pos) {
+    out[count++] = Level{pos, bids[pos]};
+    return count < out.size();
+  });
+  return count;
+}
+
+/**
+ * @brief Writes the top asks, lowest price first, into a caller buffer.
+ *
+ * Pops the lowest set bit of each word with w &= w - 1.
+ *
+ * @param out Destination; at most out.size() levels are written.
+ * @return The number of levels written.
+ */
+template <unsigned int kLevels, typename QtyT>
+size_t BasicOrderBook<kLevels, QtyT>::GetTopNAsks(std::span<Level> out) const {
+  ORDERBOOK_LATENCY_SCOPE(LatencyOp::kTopN, LatencyStats::kNoMarket);
+  size_t count = 0;
+  if (out.empty()) return count;
+  const QtyT* asks = levels_[kAskIndex];
+  bitsets_[kAskIndex].ForEachAscending([&](unsigned int pos) {
+    out[count++] = Level{pos, asks[pos]};
+    return count < out.size();
+  });
+  return count;
+}
+
+/**
+ * @brief Best implied YES ask: the highest NO bid, mirrored.
+ *
+ * @return A pair of (kPayout - price, quantity), or (0, 0) if there are no
+ *         NO bids.
+ */
+template <unsigned int kLevels, typename QtyT>
+typename BasicOrderBook<kLevels, QtyT>::Level
+BasicOrderBook<kLevels, QtyT>::BestYesAsk() const {
+  const int idx = bitsets_[kAskIndex].HighestSetBit();
+  if (idx >= 0) {
+    return {kPayout - static_cast<unsigned int>(idx), levels_[kAskIndex][idx]};
+  }
+  return {0U, 0U};
+}
+
+/**
+ * @brief Best implied NO ask: the highest YES bid, mirrored.
+ *
+ * @return A pair of (kPayout - price, quantity), or (0, 0) if there are no
+ *         YES bids.
+ */
+template <unsigned int kLevels, typename QtyT>
+typename BasicOrderBook<kLevels, QtyT>::Level
+BasicOrderBook<kLevels, QtyT>::BestNoAsk() const {
+  const int idx = bitsets_[kBidIndex].HighestSetBit();
+  if (idx >= 0) {
+    return {kPayout - static_cast<unsigned int>(idx), levels_[kBidIndex][idx]};
+  }
+  return {0U, 0U};
+}
+
+/**
+ * @brief Writes the implied YES asks (from NO bids), lowest price first.
+ *
+ * @param out Destination; at most out.size() levels are written.
+ * @return The number of levels written.
+ */
+template <unsigned int kLevels, typename QtyT>
+size_t BasicOrderBook<kLevels, QtyT>::GetImpliedTopNYesAsks(
+    std::span<Level> out) const {
+  return GetImpliedTopN(kAskIndex, out);
+}
+
+/**
+ * @brief Writes the implied NO asks (from YES bids), lowest price first.
+ *
+ * @param out Destination; at most out.size() levels are written.
+ * @return The number of levels written.
+ */
+template <unsigned int kLevels, typename QtyT>
+size_t BasicOrderBook<kLevels, QtyT>::GetImpliedTopNNoAsks(
+    std::span<Level> out) const {
+  return GetImpliedTopN(kBidIndex, out);
+}
+
+/**
+ * @brief Walks one side from its highest price down, emitting mirrored
+ *        prices, which come out in ascending order.
+ *
+ * @param side_index Row to mirror.
+ * @param out Destination; at most out.size() levels are written.
+ * @return The number of levels written.
+ */
+template <unsigned int kLevels, typename QtyT>
+size_t BasicOrderBook<kLevels, QtyT>::GetImpliedTopN(
+    unsigned int side_index, std::span<Level> out) const {
+  size_t count = 0;
+  if (out.empty()) return count;
+  const QtyT* levels = levels_[side_index];
+  bitsets_[side_index].ForEachDescending([&](unsigned int pos) {
+    out[count++] = Level{kPayout - pos, levels[pos]};
+    return count < out.size();
+  });
+  return count;
+}
+
+/**
+ * @brief Spread between the implied YES ask and the best YES bid.
+ *
+ * @param spread Receives kPayout - best YES bid - best NO bid, in ticks.
+ * @return False if either side is empty.
+ */
+template <unsigned int kLevels, typename QtyT>
+bool BasicOrderBook<kLevels, QtyT>::ImpliedSpread(int* spread) const {
+  const int yes_bid = bitsets_[kBidIndex].HighestSetBit();
+  const int no_bid = bitsets_[kAskIndex].HighestSetBit();
+  if ((yes_bid | no_bid) < 0) {
+    return false;
+  }
+  *spread = static_cast<int>(kPayout) - yes_bid - no_bid;
+  return true;
+}
+
+/**
+ * @brief Total resting quantity on one side.
+ *
+ * @param side kYes for bids, kNo for asks.
+ * @return The running total, or 0 for an undefined side.
+ */
+template <unsigned int kLevels, typename QtyT>
+uint64_t BasicOrderBook<kLevels, QtyT>::TotalQty(Side side) const {
+  if (side == Side::kYes) return total_qty_[kBidIndex];
+  if (side == Side::kNo) return total_qty_[kAskIndex];
+  return 0U;
+}
+
+/**
+ * @brief Total resting notional (sum of price * qty) on one side.
+ *
+ * @param side kYes for bids, kNo for asks.
+ * @return The running total, or 0 for an undefined side.
+ */
+template <unsigned int kLevels, typename QtyT>
+uint64_t BasicOrderBook<kLevels, QtyT>::TotalNotional(Side side) const {
+  if (side == Side::kYes) return total_notional_[kBidIndex];
+  if (side == Side::kNo) return total_notional_[kAskIndex];
+  return 0U;
+}
+
+/**
+ * @brief Sums the quantity within @p ticks of the best price.
+ *
+ * The bitset words are masked down to the price range first, so only the
+ * levels actually in range are visited.
+ *
+ * @param side kYes for bids (range below the best bid), kNo for asks
+ *        (range above the best ask).
+ * @param ticks Distance from the touch, in price levels.
+ * @return The total quantity in range, or 0 if the side is empty.
+ */
+template <unsigned int kLevels, typename QtyT>
+uint64_t BasicOrderBook<kLevels, QtyT>::CumulativeQtyWithin(
+    Side side, unsigned int ticks) const {
+  const Bitset* bitset = nullptr;
+  const QtyT* qty = nullptr;
+  unsigned int lo = 0U;
+  unsigned int hi = 0U;
+
+  if (side == Side::kYes) {
+    const int best = bitsets_[kBidIndex].HighestSetBit();
+    if (best < 0) return 0U;
+    hi = static_cast<unsigned int>(best);
+    lo = hi > ticks ? hi - ticks : 0U;
+    bitset = &bitsets_[kBidIndex];
+    qty = levels_[kBidIndex];
+  } else if (side == Side::kNo) {
+    const int best = bitsets_[kAskIndex].LowestSetBit();
+    if (best < 0) return 0U;
+    lo = static_cast<unsigned int>(best);
+    hi = ticks < kArraySize - lo ? lo + ticks : kArraySize - 1U;
+    bitset = &bitsets_[kAskIndex];
+    qty = levels_[kAskIndex];
+  } else {
+    return 0U;
+  }
+
+  uint64_t total = 0U;
+  bitset->ForEachInRange(lo, hi, [&](unsigned int pos) { total += qty[pos]; });
+  return total;
+}
+
+/**
+ * @brief Weighted bid/ask depth imbalance over every level.
+ *
+ * @param bid_weights Weight per bid price, kArraySize entries.
+ * @param ask_weights Weight per ask price on the kNo row, kArraySize entries.
+ * @return (B - A) / (B + A) for the weighted depths B and A, in [-1, 1] for
+ *         non-negative weights; 0 if both are zero.
+ */
+template <unsigned int kLevels, typename QtyT>
+double BasicOrderBook<kLevels, QtyT>::DepthImbalance(
+    const double* bid_weights, const double* ask_weights) const {
+  double bid = 0.0;
+  double ask = 0.0;
+  if constexpr (sizeof(QtyT) == sizeof(uint32_t)) {
+    bid = book_kernels::WeightedSum(
+        reinterpret_cast<const uint32_t*>(levels_[kBidIndex]), bid_weights,
+        kArraySize);
+    ask = book_kernels::WeightedSum(
+        reinterpret_cast<const uint32_t*>(levels_[kAskIndex]), ask_weights,
+        kArraySize);
+  } else {
+    for (unsigned int price = 0; price < kArraySize; ++price) {
+      bid += bid_weights[price] * static_cast<double>(levels_[kBidIndex][price]);
+      ask += ask_weights[price] * static_cast<double>(levels_[kAskIndex][price]);
+    }
+  }
+  const double total = bid + ask;
+  return total != 0.0 ? (bid - ask) / total : 0.0;
+}
+
+/**
+ * @brief Quantity per fixed-width price band of one side.
+ *
+ * @param side kYes for bids, kNo for asks (kNo row prices).
+ * @param band_width Prices per band; band k covers [k * width, (k+1) * width).
+ * @param out Receives one total per band, from price 0 up.
+ * @return Bands written: min(out.size(), ceil(kArraySize / band_width)), or
+ *         0 for an undefined side or a zero width.
+ */
+template <unsigned int kLevels, typename QtyT>
+size_t BasicOrderBook<kLevels, QtyT>::DepthProfile(
+    Side side, unsigned int band_width, std::span<uint64_t> out) const {
+  if (band_width == 0U || (side != Side::kYes && side != Side::kNo)) {
+    return 0U;
+  }
+  const QtyT* qty = levels_[SideIndex(side)];
+  const size_t bands = (kArraySize + band_width - 1U) / band_width;
+  const size_t written = out.size() < bands ? out.size() : bands;
+  // Levels past the last written band are left out, not folded in.
+  const unsigned int count =
+      written * band_width < kArraySize
+          ? static_cast<unsigned int>(written * band_width)
+          : kArraySize;
+  if constexpr (sizeof(QtyT) == sizeof(uint32_t)) {
+    book_kernels::BandSums(reinterpret_cast<const uint32_t*>(qty), count,
+                           band_width, out.data());
+  } else {
+    for (size_t band = 0; band < written; ++band) {
+      out[band] = 0U;
+    }
+    for (unsigned int price = 0; price < count; ++price) {
+      out[price / band_width] += qty[price];
+    }
+  }
+  return written;
+}
+
+/**
+ * @brief Estimates the cost of taking @p qty from one side of the book.
+ *
+ * @param side kYes walks bids from the highest price down, kNo walks asks
+ *        from the lowest price up.
+ * @param qty Quantity to fill.
+ * @return The quantity that could be filled and the notional paid for it.
+ */
+template <unsigned int kLevels, typename QtyT>
+typename BasicOrderBook<kLevels, QtyT>::FillEstimate
+BasicOrderBook<kLevels, QtyT>::CostToFill(Side side, uint64_t qty) const {
+  FillEstimate estimate;
+  if (qty == 0U) return estimate;
+
+  auto take_level = [&](const QtyT* levels, unsigned int price) {
+    const uint64_t remaining = qty - estimate.filled_qty;
+    const uint64_t take = levels[price] < remaining ? levels[price] : remaining;
+    estimate.filled_qty += take;
+    estimate.notional += take * price;
+    return estimate.filled_qty != qty;
+  };
+  if (side == Side::kYes) {
+    bitsets_[kBidIndex].ForEachDescending([&](unsigned int price) {
+      return take_level(levels_[kBidIndex], price);
+    });
+  } else if (side == Side::kNo) {
+    bitsets_[kAskIndex].ForEachAscending([&](unsigned int price) {
+      return take_level(levels_[kAskIndex], price);
+    });
+  }
+  return estimate;
+}
+
+#endif  // PROJECT_ORDERBOOK_INL_H_
@@ -0,0 +1,202 @@
+#include "queue_tracker.h"
+
+#include <cmath>    // for std::exp
+#include <cstring>  // for std::memset
+
+// =============================================================================
+// QueueTracker Method Definitions
+// =============================================================================
+
+/**
+ * @brief Creates a tracker with no tracked orders.
+ */
+QueueTracker::QueueTracker(const Options& options) : options_(options) {
+  tracked_[0].Clear();
+  tracked_[1].Clear();
+  std::memset(levels_, 0, sizeof(levels_));
+}
+
+/**
+ * @brief Records a new order at the back of the queue.
+ */
+bool QueueTracker::Place(Side side, unsigned int price, uint64_t qty,
+                         uint64_t qty_ahead) {
+  if (price >= kArraySize || (side != Side::kYes && side != Side::kNo)) {
+    return false;
+  }
+  const unsigned int row = Row(side);
+  if (tracked_[row].TestBit(price)) {
+    return false;
+  }
+  tracked_[row].SetBit(price);
+  levels_[row][price] = Level{qty_ahead, 0U, qty, 0U, qty, 0U};
+  return true;
+}
+
+/**
+ * @brief Forgets the level's order.
+ */
+void QueueTracker::Cancel(Side side, unsigned int price) {
+  if (price < kArraySize) {
+    tracked_[Row(side)].ClearBit(price);
+  }
+}
+
+/**
+ * @brief Takes @p qty of cancelled quantity out of ahead/behind.
+ */
+void QueueTracker::RemoveOthers(Level* level, uint64_t qty) const {
+  const uint64_t others = level->ahead + level->behind;
+  if (qty >= others) {
+    level->ahead = 0U;
+    level->behind = 0U;
+    return;
+  }
+  uint64_t from_ahead;
+  switch (options_.cancel_policy) {
+    case CancelPolicy::kAheadFirst:
+      from_ahead = qty < level->ahead ? qty : level->ahead;
+      break;
+    case CancelPolicy::kBehindFirst:
+      from_ahead = qty > level->behind ? qty - level->behind : 0U;
+      break;
+    default:
+      // Rounded to nearest, then moved to ahead if behind cannot cover it.
+      from_ahead = (qty * level->ahead + others / 2U) / others;
+      if (qty - from_ahead > level->behind) {
+        from_ahead = qty - level->behind;
+      }
+      break;
+  }
+  level->ahead -= from_ahead;
+  level->behind -= qty - from_ahead;
+}
+
+/**
+ * @brief Queue effect of a level delta; a bit test unless the level is
+ *        tracked.
+ */
+void QueueTracker::OnDelta(const DeltaMessage& msg) {
+  const unsigned int price = msg.price;
+  if (price >= kArraySize ||
+      (msg.side != Side::kYes && msg.side != Side::kNo)) {
+    return;
+  }
+  const unsigned int row = Row(msg.side);
+  if (!tracked_[row].TestBit(price)) {
+    return;
+  }
+  Level& level = levels_[row][price];
+  if (msg.delta > 0) {
+    const uint64_t added = static_cast<uint64_t>(msg.delta);
+    const uint64_t ours = added < level.unacked ? added : level.unacked;
+    level.unacked -= ours;
+    level.behind += added - ours;
+    return;
+  }
+  uint64_t removed = static_cast<uint64_t>(-static_cast<int64_t>(msg.delta));
+  const uint64_t confirmed =
+      removed < level.pending_trade ? removed : level.pending_trade;
+  level.pending_trade -= confirmed;
+  removed -= confirmed;
+  if (removed != 0U) {
+    RemoveOthers(&level, removed);
+  }
+}
+
+/**
+ * @brief Queue advancement from a trade on the level it executed against.
+ */
+void QueueTracker::OnTrade(const TradeMessage& trade) {
+  if (trade.count <= 0 ||
+      (trade.taker_side != Side::kYes && trade.taker_side != Side::kNo)) {
+    return;
+  }
+  // Same level selection as OrderBook::ApplyTrade: a YES taker hits the NO
+  // row at no_price, a NO taker the YES row at yes_price.
+  const bool hits_no = trade.taker_side == Side::kYes;
+  const unsigned int row = hits_no ? 1U : 0U;
+  const unsigned int price = hits_no ? trade.no_price : trade.yes_price;
+  if (price >= kArraySize || !tracked_[row].TestBit(price)) {
+    return;
+  }
+  Level& level = levels_[row][price];
+  uint64_t qty = static_cast<uint64_t>(trade.count);
+  if (options_.trade_handling == TradeHandling::kProvisional) {
+    level.pending_trade += qty;
+  }
+  const uint64_t from_ahead = qty < level.ahead ? qty : level.ahead;
+  level.ahead -= from_ahead;
+  qty -= from_ahead;
+  const uint64_t fill = qty < level.resting ? qty : level.resting;
+  level.resting -= fill;
+  level.filled += fill;
+  level.unacked = level.unacked < fill ? 0U : level.unacked - fill;
+  qty -= fill;
+  level.behind -= qty < level.behind ? qty : level.behind;
+}
+
+/**
+ * @brief Reconciles tracked levels with snapshot quantities: others shrink
+ *        by policy or grow at the back.
+ */
+void QueueTracker::OnSnapshot(const OrderBook& book) {
+  for (unsigned int row = 0; row < 2U; ++row) {
+    const Side side = row == 0U ? Side::kYes : Side::kNo;
+    tracked_[row].ForEachAscending([&](unsigned int price) {
+      if (price >= kArraySize) return false;  // Bits past the last level.
+      Level& level = levels_[row][price];
+      const uint64_t qty = book.QtyAt(side, price);
+      const uint64_t others = qty > level.resting ? qty - level.resting : 0U;
+      const uint64_t known = level.ahead + level.behind;
+      if (others < known) {
+        RemoveOthers(&level, known - others);
+      } else {
+        level.behind += others - known;
+      }
+      // A snapshot already shows our order and any fills against it.
+      level.unacked = 0U;
+      level.pending_trade = 0U;
+      return true;
+    });
+  }
+}
+
+/**
+ * @brief Current estimate for the level's order.
+ */
+QueuePosition QueueTracker::Position(Side side, unsigned int price) const {
+  QueuePosition position;
+  if (price >= kArraySize || (side != Side::kYes && side != Side::kNo)) {
+    return position;
+  }
+  const unsigned int row = Row(side);
+  if (!tracked_[row].TestBit(price)) {
+    return position;
+  }
+  const Level& level = levels_[row][price];
+  position.tracked = true;
+  position.ahead = level.ahead;
+  position.behind = level.behind;
+  position.resting = level.resting;
+  position.filled = level.filled;
+  return position;
+}
+
+/**
+ * @brief Exponential-volume fill estimate from the current qty ahead.
+ */
+double QueueTracker::FillProbability(Side side, unsigned int price,
+                                     double expected_volume) const {
+  const QueuePosition position = Position(side, price);
+  if (!position.tracked || position.resting == 0U) {
+    return 0.0;
+  }
+  if (position.ahead == 0U) {
+    return 1.0;
+  }
+  if (expected_volume <= 0.0) {
+    return 0.0;
+  }
+  return std::exp(-static_cast<double>(position.ahead) / expected_volume);
+}
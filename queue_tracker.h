@@ -0,0 +1,141 @@
+#ifndef PROJECT_QUEUE_TRACKER_H_
+#define PROJECT_QUEUE_TRACKER_H_
+
+#include <cstdint> // for uint8_t, uint64_t
+#include "message_types.h"
+#include "orderbook.h"
+
+/**
+ * @brief How cancels at a level with one of our orders are split between
+ *        the quantity ahead of it and the quantity behind it. L2 deltas do
+ *        not say which order was cancelled, so this is a modelling choice.
+ *
+ * kProRata splits each cancel in proportion to the two amounts. kAheadFirst
+ * takes it from ahead first (optimistic); kBehindFirst from behind first
+ * (pessimistic).
+ */
+enum class CancelPolicy : uint8_t {
+  kProRata = 0,
+  kAheadFirst,
+  kBehindFirst,
+};
+
+/**
+ * @brief Estimated queue state of our order at one level.
+ */
+struct QueuePosition
+{
+  bool tracked{false};
+  /// Other quantity in front of / behind our order.
+  uint64_t ahead{0};
+  uint64_t behind{0};
+  /// Our quantity still resting, and filled so far.
+  uint64_t resting{0};
+  uint64_t filled{0};
+};
+
+/**
+ * @class QueueTracker
+ *
+ * @brief Estimates the queue position of our own resting orders in one
+ *        market from the public L2 feed.
+ *
+ * There is at most one tracked order per (side, price); its state lives
+ * in a fixed array parallel to the book's level arrays, with a bitset of
+ * tracked levels. Every update first tests that bit, so untracked levels
+ * cost one bit test, and queries are O(1).
+ *
+ * Model: the level quantity in the feed includes our order once the venue
+ * shows it. A trade at the level fills whatever is ahead of us first, then
+ * us, then what is behind. A positive delta first accounts for our own
+ * order appearing (up to the placed quantity) and then joins the back of
+ * the queue. A negative delta is a cancel by someone else, split by the
+ * CancelPolicy.
+ *
+ * Feed it the same messages as the book, or attach it with
+ * BookRegistry::SetQueueTracker.
+ */
+class QueueTracker
+{
+public:
+  static constexpr unsigned int kArraySize = OrderBook::kArraySize;
+
+  struct Options
+  {
+    CancelPolicy cancel_policy = CancelPolicy::kProRata;
+    /// Match the book's TradeHandling: under kProvisional the venue also
+    /// sends a delta for every fill, which must not count as a cancel.
+    TradeHandling trade_handling = TradeHandling::kApply;
+  };
+
+  QueueTracker() : QueueTracker(Options()) {}
+  explicit QueueTracker(const Options &options);
+
+  /**
+   * @brief Starts tracking our order of @p qty at (@p side, @p price),
+   *        with @p qty_ahead of other quantity in front of it.
+   *
+   * @return False if the price is out of range or the level already has a
+   *         tracked order.
+   */
+  bool Place(Side side, unsigned int price, uint64_t qty, uint64_t qty_ahead);
+
+  /// Place with everything currently resting at the level ahead of us.
+  bool Place(Side side, unsigned int price, uint64_t qty,
+             const OrderBook &book)
+  {
+    return Place(side, price, qty, book.QtyAt(side, price));
+  }
+
+  /// Stops tracking the level (our order was cancelled or is done).
+  void Cancel(Side side, unsigned int price);
+
+  void OnDelta(const DeltaMessage &msg);
+  void OnTrade(const TradeMessage &trade);
+  /// Re-anchors every tracked level to a freshly snapshotted @p book.
+  void OnSnapshot(const OrderBook &book);
+
+  QueuePosition Position(Side side, unsigned int price) const;
+
+  /**
+   * @brief Probability that our order gets at least a partial fill, if the
+   *        volume that trades at this level over the horizon of interest
+   *        is exponentially distributed with mean @p expected_volume:
+   *        exp(-ahead / expected_volume). 0 for untracked levels.
+   */
+  double FillProbability(Side side, unsigned int price,
+                         double expected_volume) const;
+
+  unsigned int tracked_count() const
+  {
+    return tracked_[0].Count() + tracked_[1].Count();
+  }
+
+private:
+  struct Level
+  {
+    uint64_t ahead;
+    uint64_t behind;
+    uint64_t resting;
+    uint64_t filled;
+    /// Placed quantity not yet seen in the feed.
+    uint64_t unacked;
+    /// Traded quantity whose confirming delta is still due (kProvisional).
+    uint64_t pending_trade;
+  };
+
+  /// Same row mapping as the book: kYes = 0, kNo = 1.
+  static unsigned int Row(Side side)
+  {
+    return static_cast<unsigned int>(side == Side::kNo);
+  }
+
+  /// Removes @p qty of other orders by policy.
+  void RemoveOthers(Level *level, uint64_t qty) const;
+
+  Options options_;
+  OrderBook::Bitset tracked_[2];
+  Level levels_[2][kArraySize];
+};
+
+#endif // PROJECT_QUEUE_TRACKER_H_
@@ -0,0 +1,327 @@
+#include "sharded_registry.h"
+
+#include "book_worker.h"
+#include "thread_util.h"
+
+// =============================================================================
+// ShardedRegistry Method Definitions
+// =============================================================================
+
+/**
+ * @brief Creates the shards and builds each slab on its shard's core.
+ *
+ * @param max_markets Global market IDs are [0, max_markets).
+ * @param options Shard count, pinning, per-shard capacity and batching.
+ */
+ShardedRegistry::ShardedRegistry(size_t max_markets, const Options& options)
+    : options_(options),
+      routes_(max_markets, Route{kUnassigned, BookRegistry::kInvalidMarketId,
+                                 0U}) {
+  unsigned int count = options_.shard_count == 0U ? 1U : options_.shard_count;
+  if (count > kUnassigned) count = kUnassigned;
+  for (unsigned int s = 0; s < count; ++s) {
+    const int core = s < options_.cores.size() ? options_.cores[s] : -1;
+    shards_.push_back(std::make_unique<Shard>(options_.ring_capacity, core));
+    shards_.back()->free_ids.reserve(options_.markets_per_shard);
+  }
+
+  // First touch: the BookRegistry constructor writes every book, so running
+  // it on the pinned core places the slab on that core's NUMA node.
+  for (const std::unique_ptr<Shard>& shard : shards_) {
+    Shard* const target = shard.get();
+    const size_t capacity = options_.markets_per_shard;
+    std::thread builder([target, capacity] {
+      PinCurrentThread(target->core);
+      target->registry = std::make_unique<BookRegistry>(capacity);
+    });
+    builder.join();
+  }
+}
+
+/**
+ * @brief Stops the shards if they are still running.
+ */
+ShardedRegistry::~ShardedRegistry() {
+  Stop();
+}
+
+/**
+ * @brief Launches one (optionally pinned) thread per shard.
+ */
+void ShardedRegistry::Start() {
+  if (running_.exchange(true)) return;
+  for (const std::unique_ptr<Shard>& shard : shards_) {
+    Shard* const target = shard.get();
+    target->thread = std::thread([this, target] {
+      PinCurrentThread(target->core);
+      Run(target);
+    });
+  }
+}
+
+/**
+ * @brief Requests shutdown and joins every shard. Messages already pushed
+ *        are applied first.
+ */
+void ShardedRegistry::Stop() {
+  if (!running_.exchange(false)) return;
+  for (const std::unique_ptr<Shard>& shard : shards_) {
+    if (shard->thread.joinable()) {
+      shard->thread.join();
+    }
+  }
+}
+
+/**
+ * @brief Copies a slot into its market's shard ring, with the shard-local
+ *        market ID.
+ *
+ * @param slot Message whose market_id is a global market ID.
+ * @return False if the slot could not be routed or the ring is full.
+ */
+bool ShardedRegistry::Push(const MessageSlot& slot) {
+  if (slot.type == MessageType::kUnknown) {
+    return true;  // Nothing to apply; kUnknown is reserved for markers.
+  }
+  const MarketId id = slot.market_id;
+  if (id >= routes_.size()) {
+    return false;
+  }
+  Route& route = routes_[id];
+  if (route.shard == kUnassigned && !Place(id)) {
+    return false;
+  }
+
+  Shard* const shard = shards_[route.shard].get();
+  MessageSlot* const dest = shard->ring.BeginWrite();
+  if (dest == nullptr) {
+    return false;
+  }
+  *dest = slot;
+  dest->market_id = route.local_id;
+  shard->ring.CommitWrite();
+  ++route.rate;
+  return true;
+}
+
+/**
+ * @brief Greedy rebalancing step over the router's decayed message counts.
+ *
+ * Cold path: O(max_markets) per move.
+ *
+ * @param max_moves Upper bound on markets moved by this call.
+ * @return Markets moved.
+ */
+unsigned int ShardedRegistry::Rebalance(unsigned int max_moves) {
+  for (size_t i = 0; i < in_flight_.size();) {
+    if (in_flight_[i]->imported.load(std::memory_order_acquire)) {
+      in_flight_[i] = std::move(in_flight_.back());
+      in_flight_.pop_back();
+    } else {
+      ++i;
+    }
+  }
+
+  std::vector<uint64_t> load(shards_.size(), 0U);
+  for (const Route& route : routes_) {
+    if (route.shard != kUnassigned) load[route.shard] += route.rate;
+  }
+
+  unsigned int moves = 0U;
+  while (moves < max_moves) {
+    unsigned int hot = 0U;
+    unsigned int cold = 0U;
+    for (unsigned int s = 1; s < load.size(); ++s) {
+      if (load[s] > load[hot]) hot = s;
+      if (load[s] < load[cold]) cold = s;
+    }
+    const uint64_t gap = load[hot] - load[cold];
+
+    // Moving rate r turns the gap into |gap - 2r|; the best candidate is
+    // the busiest market with 2r <= gap, or failing that the one that
+    // still narrows it most (r < gap).
+    MarketId best = BookRegistry::kInvalidMarketId;
+    uint64_t best_score = gap;
+    for (MarketId id = 0; id < routes_.size(); ++id) {
+      const Route& route = routes_[id];
+      if (route.shard != hot || route.rate == 0U || route.rate >= gap) {
+        continue;
+      }
+      const uint64_t twice = 2U * route.rate;
+      const uint64_t score = twice > gap ? twice - gap : gap - twice;
+      if (score < best_score) {
+        best_score = score;
+        best = id;
+      }
+    }
+    if (best == BookRegistry::kInvalidMarketId || !Move(best, cold)) {
+      break;
+    }
+    load[hot] -= routes_[best].rate;
+    load[cold] += routes_[best].rate;
+    ++moves;
+  }
+
+  for (Route& route : routes_) {
+    route.rate >>= 1U;
+  }
+  return moves;
+}
+
+/**
+ * @brief Shard index owning a market, or shard_count() if unassigned.
+ */
+unsigned int ShardedRegistry::ShardOf(MarketId id) const {
+  const uint16_t shard = id < routes_.size() ? routes_[id].shard : kUnassigned;
+  return shard == kUnassigned ? shard_count() : shard;
+}
+
+/**
+ * @brief Read access to a market's book for inspection while stopped.
+ */
+const OrderBook* ShardedRegistry::FindBook(MarketId id) const {
+  if (id >= routes_.size() || routes_[id].shard == kUnassigned) {
+    return nullptr;
+  }
+  const Route& route = routes_[id];
+  return &shards_[route.shard]->registry->book(route.local_id);
+}
+
+/**
+ * @brief First placement: the shard given by the ID modulo the shard count,
+ *        or the next one round the ring that has a free slot.
+ */
+bool ShardedRegistry::Place(MarketId id) {
+  const unsigned int count = shard_count();
+  for (unsigned int i = 0; i < count; ++i) {
+    const unsigned int s = (id + i) % count;
+    const MarketId local = AllocateLocal(shards_[s].get());
+    if (local != BookRegistry::kInvalidMarketId) {
+      routes_[id].shard = static_cast<uint16_t>(s);
+      routes_[id].local_id = local;
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Reuses a released local ID or takes the next unused one.
+ */
+ShardedRegistry::MarketId ShardedRegistry::AllocateLocal(Shard* shard) {
+  if (!shard->free_ids.empty()) {
+    const MarketId id = shard->free_ids.back();
+    shard->free_ids.pop_back();
+    return id;
+  }
+  if (shard->next_id < options_.markets_per_shard) {
+    return shard->next_id++;
+  }
+  return BookRegistry::kInvalidMarketId;
+}
+
+/**
+ * @brief Reassigns a market, handing its book over in band if the shards
+ *        are running (or copying it directly if they are stopped).
+ *
+ * The old local ID is released at once: anything later routed to it is
+ * behind the export marker, which resets that book.
+ */
+bool ShardedRegistry::Move(MarketId id, unsigned int to) {
+  Route& route = routes_[id];
+  Shard* const from = shards_[route.shard].get();
+  Shard* const dest = shards_[to].get();
+  const MarketId local = AllocateLocal(dest);
+  if (local == BookRegistry::kInvalidMarketId) {
+    return false;
+  }
+
+  if (running_.load(std::memory_order_relaxed)) {
+    in_flight_.push_back(std::make_unique<Handoff>());
+    Handoff* const handoff = in_flight_.back().get();
+    PushMigration(from, Migration{handoff, route.local_id, true});
+    PushMigration(dest, Migration{handoff, local, false});
+  } else {
+    OrderBook& book = from->registry->book(route.local_id);
+    dest->registry->book(local) = book;
+    book = OrderBook();
+  }
+
+  from->free_ids.push_back(route.local_id);
+  route.shard = static_cast<uint16_t>(to);
+  route.local_id = local;
+  return true;
+}
+
+/**
+ * @brief Queues a migration and its in-band marker for @p shard.
+ */
+void ShardedRegistry::PushMigration(Shard* shard, const Migration& migration) {
+  while (!shard->migrations.TryPush(migration)) {
+    CpuRelax();
+  }
+  MessageSlot* dest;
+  while ((dest = shard->ring.BeginWrite()) == nullptr) {
+    CpuRelax();
+  }
+  dest->type = MessageType::kUnknown;
+  dest->market_id = migration.local_id;
+  shard->ring.CommitWrite();
+}
+
+/**
+ * @brief Executes the migration a marker stands for, on the shard thread.
+ *
+ * Export copies the book out and resets the slot. Import waits until the
+ * source shard has exported (it only waits on an export queued before it,
+ * so shards cannot deadlock) and copies the book in.
+ */
+void ShardedRegistry::RunMigration(Shard* shard) {
+  const Migration migration = *shard->migrations.Front();
+  shard->migrations.Pop();
+  OrderBook& book = shard->registry->book(migration.local_id);
+  Handoff* const handoff = migration.handoff;
+  if (migration.is_export) {
+    handoff->book = book;
+    book = OrderBook();
+    handoff->exported.store(true, std::memory_order_release);
+  } else {
+    while (!handoff->exported.load(std::memory_order_acquire)) {
+      CpuRelax();
+    }
+    book = handoff->book;
+    handoff->imported.store(true, std::memory_order_release);
+  }
+}
+
+/**
+ * @brief Shard loop: drain in batches and dispatch like BookWorker, running
+ *        migration markers in ring order.
+ */
+void ShardedRegistry::Run(Shard* shard) {
+  BookRegistry* const registry = shard->registry.get();
+  for (;;) {
+    uint64_t markers = 0U;
+    const size_t drained =
+        shard->ring.Drain(options_.batch_size, [&](const MessageSlot& slot) {
+          if (slot.type == MessageType::kUnknown) {
+            RunMigration(shard);
+            ++markers;
+          } else {
+            BookWorker::Dispatch(registry, slot);
+          }
+        });
+
+    if (drained != 0U) {
+      shard->processed.store(
+          shard->processed.load(std::memory_order_relaxed) + drained - markers,
+          std::memory_order_relaxed);
+      continue;
+    }
+    if (!running_.load(std::memory_order_acquire)) {
+      if (shard->ring.Empty()) return;
+      continue;
+    }
+    CpuRelax();
+  }
+}
@@ -0,0 +1,179 @@
+#ifndef PROJECT_SHARDED_REGISTRY_H_
+#define PROJECT_SHARDED_REGISTRY_H_
+
+#include <atomic>  // for std::atomic
+#include <cstddef> // for size_t
+#include <cstdint> // for uint16_t, uint32_t, uint64_t
+#include <memory>  // for std::unique_ptr
+#include <thread>  // for std::thread
+#include <vector>  // for std::vector
+#include "book_registry.h"
+#include "message_types.h"
+#include "orderbook.h"
+#include "spsc_ring.h"
+
+/**
+ * @class ShardedRegistry
+ *
+ * @brief Partitions markets across N worker shards, each with its own
+ *        BookRegistry slab, SPSC ring and (optionally pinned) thread.
+ *
+ * A single router thread calls Push with slots whose market_id is a global
+ * market ID in [0, max_markets). The first message for a market assigns it
+ * to a shard (ID modulo the shard count, or the next shard with room) and a
+ * local ID in that shard's registry; the slot is then copied into the
+ * shard's ring with the local ID. Each shard applies its ring exactly like
+ * BookWorker, so a market's messages are applied in push order by one
+ * thread, and shards never share a book or a cache line of book data.
+ *
+ * NUMA placement uses first touch: each shard's slab is constructed (and
+ * therefore faulted in) on a thread pinned to the shard's core, so with the
+ * default Linux policy its pages live on that core's node.
+ *
+ * Rebalance moves the hottest markets off the busiest shards, using the
+ * per-market message counts the router keeps as it pushes. A move is
+ * carried in band: an export marker goes into the source ring and an
+ * import marker into the destination ring. The source hands over the book
+ * once it has applied everything pushed before the move, and the
+ * destination waits for that book before applying anything pushed after.
+ * Push, Rebalance and the other router calls must all be made from the
+ * same thread.
+ */
+class ShardedRegistry
+{
+public:
+  using MarketId = BookRegistry::MarketId;
+
+  struct Options
+  {
+    unsigned int shard_count = 2;
+    /// Core for each shard's thread (shard s uses cores[s]); missing or
+    /// negative entries leave that shard unpinned.
+    std::vector<int> cores;
+    /// Book slots per shard.
+    size_t markets_per_shard = 1024;
+    /// Ring slots per shard (rounded up to a power of two).
+    size_t ring_capacity = 1024;
+    /// Maximum slots applied per drain.
+    size_t batch_size = 64;
+  };
+
+  ShardedRegistry(size_t max_markets, const Options &options);
+  ~ShardedRegistry();
+
+  ShardedRegistry(const ShardedRegistry &) = delete;
+  ShardedRegistry &operator=(const ShardedRegistry &) = delete;
+
+  /// Launches the shard threads.
+  void Start();
+  /// Drains every ring, then joins the shard threads.
+  void Stop();
+
+  // Router side (single thread).
+
+  /**
+   * @brief Routes one message to its market's shard.
+   *
+   * @return False if slot.market_id is not a valid global ID, the market
+   *         cannot be placed (every shard full), or its ring is full.
+   *         kUnknown slots are ignored and return true.
+   */
+  bool Push(const MessageSlot &slot);
+
+  /**
+   * @brief Moves up to @p max_moves markets from the busiest to the least
+   *        busy shard, based on the messages pushed since the last call,
+   *        then halves the counters so older traffic decays.
+   *
+   * A market moves only if that narrows the gap between the two shards.
+   * Blocks while a destination ring is full.
+   *
+   * @return The number of markets moved.
+   */
+  unsigned int Rebalance(unsigned int max_moves = 1U);
+
+  /// Shard that currently owns @p id, or shard_count() if unassigned.
+  unsigned int ShardOf(MarketId id) const;
+  /// Decayed message count Rebalance uses for @p id.
+  uint64_t market_rate(MarketId id) const { return routes_[id].rate; }
+
+  unsigned int shard_count() const
+  {
+    return static_cast<unsigned int>(shards_.size());
+  }
+  /// Messages applied by @p shard (relaxed; for monitoring).
+  uint64_t processed(unsigned int shard) const
+  {
+    return shards_[shard]->processed.load(std::memory_order_relaxed);
+  }
+
+  /// Book for @p id, or nullptr if unassigned. Only while stopped.
+  const OrderBook *FindBook(MarketId id) const;
+
+private:
+  /// A book in transit between two shards.
+  struct Handoff
+  {
+    OrderBook book;
+    std::atomic<bool> exported{false};
+    std::atomic<bool> imported{false};
+  };
+
+  /// Payload of an in-band migration marker: a kUnknown slot in the ring
+  /// pops one of these from the shard's migration queue.
+  struct Migration
+  {
+    Handoff *handoff;
+    MarketId local_id;
+    bool is_export;
+  };
+
+  struct Shard
+  {
+    Shard(size_t ring_capacity, int core_id)
+        : ring(ring_capacity), migrations(ring_capacity), core(core_id)
+    {
+    }
+
+    std::unique_ptr<BookRegistry> registry;
+    SpscRing<MessageSlot> ring;
+    SpscRing<Migration> migrations;
+    std::thread thread;
+    const int core;
+    /// Local IDs released by markets that moved away.
+    std::vector<MarketId> free_ids;
+    MarketId next_id = 0U;
+    alignas(64) std::atomic<uint64_t> processed{0};
+  };
+
+  /// Router-side state per global market.
+  struct Route
+  {
+    uint16_t shard;
+    MarketId local_id;
+    uint64_t rate;
+  };
+
+  static constexpr uint16_t kUnassigned = UINT16_MAX;
+
+  /// Assigns @p id to a shard with room. Returns false if all are full.
+  bool Place(MarketId id);
+  /// Takes a local ID in @p shard, or kInvalidMarketId if it is full.
+  MarketId AllocateLocal(Shard *shard);
+  /// Moves @p id to shard @p to. Returns false if @p to is full.
+  bool Move(MarketId id, unsigned int to);
+  /// Pushes a migration marker, spinning while the ring is full.
+  void PushMigration(Shard *shard, const Migration &migration);
+  /// Executes the next migration marker on the shard's thread.
+  static void RunMigration(Shard *shard);
+  void Run(Shard *shard);
+
+  const Options options_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+  std::vector<Route> routes_;
+  /// Handoffs not yet imported; reclaimed by Rebalance.
+  std::vector<std::unique_ptr<Handoff>> in_flight_;
+  std::atomic<bool> running_{false};
+};
+
+#endif // PROJECT_SHARDED_REGISTRY_H_
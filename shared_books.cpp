@@ -0,0 +1,253 @@
+#include "shared_books.h"
+
+#include <atomic>   // for std::atomic_ref
+#include <cstring>  // for std::memcpy, std::memcmp
+#include <new>      // for placement new
+
+#include <fcntl.h>     // for open
+#include <sys/mman.h>  // for mmap, munmap
+#include <sys/stat.h>  // for fstat
+#include <unistd.h>    // for ftruncate, close
+
+namespace {
+
+constexpr char kMagic[8] = {'F', 'O', 'B', 'S', 'H', 'M', 'B', '1'};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "seqlocks must work across processes");
+
+/**
+ * @brief Byte offsets of each section for a segment of @p capacity markets.
+ */
+struct SegmentLayout {
+  size_t entries;
+  size_t seqlocks;
+  size_t books;
+  size_t keys;
+  size_t size;
+};
+
+SegmentLayout LayoutFor(size_t capacity, size_t key_bytes) {
+  SegmentLayout layout;
+  layout.entries = sizeof(SharedBooksHeader);
+  const size_t entries_end =
+      layout.entries + capacity * sizeof(SharedBooksEntry);
+  layout.seqlocks = (entries_end + alignof(BookSeqlock) - 1U) &
+                    ~(alignof(BookSeqlock) - 1U);
+  layout.books = layout.seqlocks + capacity * sizeof(BookSeqlock);
+  static_assert(sizeof(BookSeqlock) % alignof(OrderBook) == 0,
+                "books follow the seqlocks without padding");
+  layout.keys = layout.books + BookRegistry::SlabBytes(capacity);
+  layout.size = layout.keys + key_bytes;
+  return layout;
+}
+
+}  // namespace
+
+// =============================================================================
+// SharedBooksWriter Method Definitions
+// =============================================================================
+
+/**
+ * @brief Destroys the registry and unmaps the segment.
+ */
+SharedBooksWriter::~SharedBooksWriter() {
+  Close();
+}
+
+/**
+ * @brief Creates the segment, constructs the seqlocks and the registry's
+ *        books in it, and maps it shared.
+ *
+ * @param path Segment path; a /dev/shm path keeps it in memory.
+ * @param capacity Markets the segment (and registry) can hold.
+ * @param key_bytes Room for all ticker bytes.
+ * @return False if the file could not be created or mapped.
+ */
+bool SharedBooksWriter::Open(const char* path, size_t capacity,
+                             size_t key_bytes) {
+  if (base_ != nullptr || capacity > UINT32_MAX) return false;
+  const SegmentLayout layout = LayoutFor(capacity, key_bytes);
+  const int fd = ::open(path, O_CREAT | O_TRUNC | O_RDWR, 0644);
+  if (fd < 0) return false;
+  if (::ftruncate(fd, static_cast<off_t>(layout.size)) != 0) {
+    ::close(fd);
+    return false;
+  }
+  void* mapping = ::mmap(nullptr, layout.size, PROT_READ | PROT_WRITE,
+                         MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (mapping == MAP_FAILED) return false;
+
+  base_ = static_cast<uint8_t*>(mapping);
+  size_ = layout.size;
+  header_ = reinterpret_cast<SharedBooksHeader*>(base_);
+  BookSeqlock* const seqlocks =
+      reinterpret_cast<BookSeqlock*>(base_ + layout.seqlocks);
+  for (size_t i = 0; i < capacity; ++i) {
+    new (&seqlocks[i]) BookSeqlock();
+  }
+  registry_ = std::make_unique<BookRegistry>(capacity, base_ + layout.books);
+  registry_->SetSeqlocks(seqlocks);
+
+  // Readers check the header last; the file starts zeroed, so
+  // market_count is already 0.
+  header_->version = kSharedBooksVersion;
+  header_->book_size = static_cast<uint32_t>(sizeof(OrderBook));
+  header_->capacity = static_cast<uint32_t>(capacity);
+  header_->levels = OrderBook::kArraySize;
+  header_->key_capacity = key_bytes;
+  std::atomic_thread_fence(std::memory_order_release);
+  std::memcpy(header_->magic, kMagic, sizeof(kMagic));
+  return true;
+}
+
+/**
+ * @brief Destroys the registry and unmaps the segment. Readers still
+ *        attached keep their mapping but see no further updates.
+ */
+void SharedBooksWriter::Close() {
+  registry_.reset();
+  if (base_ != nullptr) {
+    ::munmap(base_, size_);
+  }
+  base_ = nullptr;
+  size_ = 0U;
+  header_ = nullptr;
+}
+
+/**
+ * @brief Appends the tickers of markets interned since the last call and
+ *        then publishes the new market count.
+ *
+ * Key bytes are only ever appended, so entries readers already use never
+ * change.
+ */
+bool SharedBooksWriter::PublishMarkets() {
+  if (base_ == nullptr) return false;
+  std::atomic_ref<uint64_t> market_count(header_->market_count);
+  const uint64_t published = market_count.load(std::memory_order_relaxed);
+  const size_t size = registry_->size();
+  if (size == published) return true;
+
+  const SegmentLayout layout =
+      LayoutFor(header_->capacity, header_->key_capacity);
+  SharedBooksEntry* const entries =
+      reinterpret_cast<SharedBooksEntry*>(base_ + layout.entries);
+  uint8_t* const keys = base_ + layout.keys;
+  uint64_t key_used = header_->key_used;
+  bool fits = true;
+  registry_->ForEachTicker(
+      [&](BookRegistry::MarketId id, const char* key, size_t key_len) {
+        if (id < published) return;
+        if (key_used + key_len > header_->key_capacity) {
+          fits = false;
+          return;
+        }
+        std::memcpy(keys + key_used, key, key_len);
+        entries[id].ticker_offset = key_used;
+        entries[id].ticker_len = static_cast<uint32_t>(key_len);
+        key_used += key_len;
+      });
+  if (!fits) return false;
+  header_->key_used = key_used;
+  market_count.store(size, std::memory_order_release);
+  return true;
+}
+
+// =============================================================================
+// SharedBooksReader Method Definitions
+// =============================================================================
+
+/**
+ * @brief Unmaps the segment.
+ */
+SharedBooksReader::~SharedBooksReader() {
+  Close();
+}
+
+/**
+ * @brief Maps a segment read-only and checks that this build can read it.
+ *
+ * @param path Segment created by SharedBooksWriter.
+ * @return False if the file is missing, truncated or from another layout.
+ */
+bool SharedBooksReader::Open(const char* path) {
+  Close();
+  const int fd = ::open(path, O_RDONLY);
+  if (fd < 0) return false;
+  struct stat st;
+  if (::fstat(fd, &st) != 0 ||
+      static_cast<size_t>(st.st_size) < sizeof(SharedBooksHeader)) {
+    ::close(fd);
+    return false;
+  }
+  void* mapping = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ,
+                         MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (mapping == MAP_FAILED) return false;
+
+  base_ = static_cast<const uint8_t*>(mapping);
+  size_ = static_cast<size_t>(st.st_size);
+  header_ = reinterpret_cast<const SharedBooksHeader*>(base_);
+  if (std::memcmp(header_->magic, kMagic, sizeof(kMagic)) != 0) {
+    Close();
+    return false;
+  }
+  std::atomic_thread_fence(std::memory_order_acquire);
+  const SegmentLayout layout =
+      LayoutFor(header_->capacity, header_->key_capacity);
+  if (header_->version != kSharedBooksVersion ||
+      header_->book_size != sizeof(OrderBook) ||
+      header_->levels != OrderBook::kArraySize || layout.size != size_) {
+    Close();
+    return false;
+  }
+  entries_ = reinterpret_cast<const SharedBooksEntry*>(base_ + layout.entries);
+  seqlocks_ = reinterpret_cast<const BookSeqlock*>(base_ + layout.seqlocks);
+  books_ = reinterpret_cast<const OrderBook*>(base_ + layout.books);
+  keys_ = reinterpret_cast<const char*>(base_ + layout.keys);
+  return true;
+}
+
+/**
+ * @brief Releases the mapping; views handed out become invalid.
+ */
+void SharedBooksReader::Close() {
+  if (base_ != nullptr) {
+    ::munmap(const_cast<uint8_t*>(base_), size_);
+  }
+  base_ = nullptr;
+  size_ = 0U;
+  header_ = nullptr;
+  entries_ = nullptr;
+  seqlocks_ = nullptr;
+  books_ = nullptr;
+  keys_ = nullptr;
+}
+
+/**
+ * @brief Number of markets whose entries are visible to this reader.
+ */
+size_t SharedBooksReader::market_count() const {
+  if (header_ == nullptr) return 0U;
+  return static_cast<size_t>(
+      std::atomic_ref<uint64_t>(const_cast<uint64_t&>(header_->market_count))
+          .load(std::memory_order_acquire));
+}
+
+/**
+ * @brief Scans the published entries for a ticker.
+ */
+SharedBooksReader::MarketId SharedBooksReader::Find(const char* ticker,
+                                                    size_t ticker_len) const {
+  const size_t count = market_count();
+  for (size_t id = 0; id < count; ++id) {
+    const SharedBooksEntry& entry = entries_[id];
+    if (entry.ticker_len == ticker_len &&
+        std::memcmp(keys_ + entry.ticker_offset, ticker, ticker_len) == 0) {
+      return static_cast<MarketId>(id);
+    }
+  }
+  return BookRegistry::kInvalidMarketId;
+}
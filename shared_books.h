@@ -0,0 +1,244 @@
+#ifndef PROJECT_SHARED_BOOKS_H_
+#define PROJECT_SHARED_BOOKS_H_
+
+#include <cstddef> // for size_t
+#include <cstdint> // for uint32_t, uint64_t
+#include <memory>  // for std::unique_ptr
+#include <span>    // for std::span
+#include "book_registry.h"
+#include "orderbook.h"
+#include "top_of_book.h"
+
+// ---------------------------------------------------------------------------
+// Shared segment format
+// ---------------------------------------------------------------------------
+/**
+ * @brief Layout of a shared book segment (host byte order, one mapping):
+ *
+ *   SharedBooksHeader                       64 bytes
+ *   SharedBooksEntry[capacity]              16 bytes each, by MarketId
+ *   BookSeqlock[capacity]                   64 bytes each
+ *   OrderBook[capacity]                     the feed's live books
+ *   key bytes                               tickers
+ *
+ * The books are the feed process's BookRegistry slab itself, updated in
+ * place, so readers need the same OrderBook layout (version, book_size and
+ * levels are checked on attach). market_count is published with release
+ * semantics after the entries below it are written.
+ */
+struct SharedBooksHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t book_size;     // sizeof(OrderBook).
+  uint32_t capacity;
+  uint32_t levels;        // OrderBook::kArraySize.
+  uint64_t market_count;  // Accessed atomically.
+  uint64_t key_capacity;
+  uint64_t key_used;
+  uint8_t reserved[16];
+};
+
+struct SharedBooksEntry {
+  uint64_t ticker_offset;  // Offset into the key bytes.
+  uint32_t ticker_len;
+  uint32_t reserved;
+};
+
+static_assert(sizeof(SharedBooksHeader) == 64, "shared books format");
+static_assert(sizeof(SharedBooksEntry) == 16, "shared books format");
+
+constexpr uint32_t kSharedBooksVersion = 1U;
+
+/**
+ * @class OrderBookView
+ *
+ * @brief Read-only handle on a book that another thread or process
+ *        updates in place under a BookSeqlock.
+ *
+ * Every query runs the corresponding OrderBook query directly on the
+ * shared book and retries while the writer is mid-update, so a read costs
+ * a couple of cache-line loads and no syscall or copy of the book. Results
+ * are always from a single consistent book state.
+ */
+class OrderBookView
+{
+public:
+  using Level = OrderBook::Level;
+
+  OrderBookView() = default;
+  OrderBookView(const OrderBook *book, const BookSeqlock *seqlock)
+      : book_(book), seqlock_(seqlock)
+  {
+  }
+
+  bool valid() const { return book_ != nullptr; }
+
+  /**
+   * @brief Runs fn(const OrderBook&) until it completes against a stable
+   *        book, and returns its result. @p fn must not keep references
+   *        into the book.
+   */
+  template <typename Fn>
+  auto Read(Fn &&fn) const
+  {
+    for (;;) {
+      decltype(fn(*book_)) result{};
+      if (seqlock_->TryRead([&] { result = fn(*book_); })) {
+        return result;
+      }
+#if defined(__x86_64__) || defined(__i386__)
+      __builtin_ia32_pause();
+#endif
+    }
+  }
+
+  Level BestBid() const
+  {
+    return Read([](const OrderBook &book) { return book.BestBid(); });
+  }
+  Level BestAsk() const
+  {
+    return Read([](const OrderBook &book) { return book.BestAsk(); });
+  }
+  Level BestYesAsk() const
+  {
+    return Read([](const OrderBook &book) { return book.BestYesAsk(); });
+  }
+  TopOfBook Touch() const
+  {
+    return Read([](const OrderBook &book) { return book.Touch(); });
+  }
+
+  /// Depth into the caller's buffer; @return the number of levels written.
+  size_t GetTopNBids(std::span<Level> out) const
+  {
+    return Read([out](const OrderBook &book) { return book.GetTopNBids(out); });
+  }
+  size_t GetTopNAsks(std::span<Level> out) const
+  {
+    return Read([out](const OrderBook &book) { return book.GetTopNAsks(out); });
+  }
+
+  template <size_t N>
+  std::array<Level, N> GetTopNBids() const
+  {
+    return Read(
+        [](const OrderBook &book) { return book.GetTopNBids<N>(); });
+  }
+  template <size_t N>
+  std::array<Level, N> GetTopNAsks() const
+  {
+    return Read(
+        [](const OrderBook &book) { return book.GetTopNAsks<N>(); });
+  }
+
+  bool IsStale() const
+  {
+    return Read([](const OrderBook &book) { return book.IsStale(); });
+  }
+  uint64_t last_applied_seq() const
+  {
+    return Read(
+        [](const OrderBook &book) { return book.last_applied_seq(); });
+  }
+
+  /// Seqlock version: even and +2 per applied message; poll it to detect
+  /// changes without querying.
+  uint64_t version() const { return seqlock_->version(); }
+
+private:
+  const OrderBook *book_ = nullptr;
+  const BookSeqlock *seqlock_ = nullptr;
+};
+
+/**
+ * @class SharedBooksWriter
+ *
+ * @brief Feed side: a BookRegistry whose books (and their seqlocks) live in
+ *        a shared mapping that any number of reader processes attach to.
+ *
+ * Apply messages through registry() as usual; every Apply* call is
+ * seqlocked. New markets become visible to readers when PublishMarkets
+ * runs (call it after snapshots that may have interned new tickers).
+ */
+class SharedBooksWriter
+{
+public:
+  SharedBooksWriter() = default;
+  ~SharedBooksWriter();
+
+  SharedBooksWriter(const SharedBooksWriter &) = delete;
+  SharedBooksWriter &operator=(const SharedBooksWriter &) = delete;
+
+  /**
+   * @brief Creates (truncates) and maps a segment, normally under
+   *        /dev/shm, for up to @p capacity markets and @p key_bytes of
+   *        ticker bytes, and builds the registry inside it.
+   *
+   * @return False on I/O error.
+   */
+  bool Open(const char *path, size_t capacity, size_t key_bytes);
+  void Close();
+
+  BookRegistry &registry() { return *registry_; }
+
+  /**
+   * @brief Publishes tickers interned since the last call. Cold path;
+   *        returns immediately when nothing is new.
+   *
+   * @return False if the key area is full (those markets stay hidden).
+   */
+  bool PublishMarkets();
+
+private:
+  uint8_t *base_ = nullptr;
+  size_t size_ = 0U;
+  SharedBooksHeader *header_ = nullptr;
+  std::unique_ptr<BookRegistry> registry_;
+};
+
+/**
+ * @class SharedBooksReader
+ *
+ * @brief Consumer side: maps a segment read-only and hands out views.
+ */
+class SharedBooksReader
+{
+public:
+  using MarketId = BookRegistry::MarketId;
+
+  SharedBooksReader() = default;
+  ~SharedBooksReader();
+
+  SharedBooksReader(const SharedBooksReader &) = delete;
+  SharedBooksReader &operator=(const SharedBooksReader &) = delete;
+
+  /// Maps and validates @p path. Returns false if missing, truncated or
+  /// written by an incompatible build.
+  bool Open(const char *path);
+  void Close();
+
+  /// Markets published so far (grows while attached).
+  size_t market_count() const;
+
+  /// Linear ticker lookup; resolve once and keep the ID. Returns
+  /// BookRegistry::kInvalidMarketId if the ticker is not published.
+  MarketId Find(const char *ticker, size_t ticker_len) const;
+
+  /// View of market @p id (< market_count()).
+  OrderBookView view(MarketId id) const
+  {
+    return OrderBookView(&books_[id], &seqlocks_[id]);
+  }
+
+private:
+  const uint8_t *base_ = nullptr;
+  size_t size_ = 0U;
+  const SharedBooksHeader *header_ = nullptr;
+  const SharedBooksEntry *entries_ = nullptr;
+  const BookSeqlock *seqlocks_ = nullptr;
+  const OrderBook *books_ = nullptr;
+  const char *keys_ = nullptr;
+};
+
+#endif // PROJECT_SHARED_BOOKS_H_
@@ -0,0 +1,174 @@
+#ifndef PROJECT_SPSC_RING_H_
+#define PROJECT_SPSC_RING_H_
+
+#include <atomic>  // for std::atomic
+#include <cstddef> // for size_t
+#include <cstdint> // for uint64_t
+#include <new>     // for std::align_val_t
+
+/**
+ * @class SpscRing
+ *
+ * @brief Bounded lock-free single-producer / single-consumer ring.
+ *
+ * Slots are written in place: the producer obtains a slot with BeginWrite,
+ * fills it, then CommitWrite publishes it; the consumer reads with
+ * Front/Pop (or Drain for a batch). Each side keeps a cached copy of the
+ * other side's index so the shared indices are only re-read when the ring
+ * looks full (producer) or empty (consumer). The two indices live on
+ * separate cache lines.
+ *
+ * Capacity is rounded up to a power of two and allocated once, 64-byte
+ * aligned. T must be trivially copyable.
+ */
+template <typename T>
+class SpscRing
+{
+public:
+  explicit SpscRing(size_t capacity)
+      : mask_(RoundUpToPowerOfTwo(capacity) - 1U),
+        slots_(static_cast<T *>(::operator new(
+            sizeof(T) * (mask_ + 1U), std::align_val_t(kCacheLine))))
+  {
+  }
+
+  ~SpscRing()
+  {
+    ::operator delete(slots_, std::align_val_t(kCacheLine));
+  }
+
+  SpscRing(const SpscRing &) = delete;
+  SpscRing &operator=(const SpscRing &) = delete;
+
+  size_t capacity() const { return mask_ + 1U; }
+
+  // -------------------------------------------------------------------------
+  // Producer side
+  // -------------------------------------------------------------------------
+
+  /// Returns the next free slot, or nullptr if the ring is full.
+  T *BeginWrite()
+  {
+    const uint64_t tail = producer_.tail;
+    if (tail - producer_.cached_head > mask_) {
+      producer_.cached_head = head_.load(std::memory_order_acquire);
+      if (tail - producer_.cached_head > mask_) {
+        return nullptr;
+      }
+    }
+    return &slots_[tail & mask_];
+  }
+
+  /// Publishes the slot returned by the last BeginWrite.
+  void CommitWrite()
+  {
+    tail_.store(++producer_.tail, std::memory_order_release);
+  }
+
+  /// Copies @p value into the ring. Returns false if full.
+  bool TryPush(const T &value)
+  {
+    T *slot = BeginWrite();
+    if (slot == nullptr) {
+      return false;
+    }
+    *slot = value;
+    CommitWrite();
+    return true;
+  }
+
+  /// Producer-side index of the last published slot (for wakeup protocols).
+  const std::atomic<uint64_t> &tail_index() const { return tail_; }
+
+  // -------------------------------------------------------------------------
+  // Consumer side
+  // -------------------------------------------------------------------------
+
+  /// Returns the oldest unconsumed slot, or nullptr if the ring is empty.
+  const T *Front()
+  {
+    const uint64_t head = consumer_.head;
+    if (head == consumer_.cached_tail) {
+      consumer_.cached_tail = tail_.load(std::memory_order_acquire);
+      if (head == consumer_.cached_tail) {
+        return nullptr;
+      }
+    }
+    return &slots_[head & mask_];
+  }
+
+  /// Releases the slot returned by Front.
+  void Pop()
+  {
+    head_.store(++consumer_.head, std::memory_order_release);
+  }
+
+  /**
+   * @brief Calls @p fn(const T&) for up to @p max_items available slots,
+   *        then releases them all with a single index store.
+   *
+   * @return The number of slots consumed.
+   */
+  template <typename Fn>
+  size_t Drain(size_t max_items, Fn &&fn)
+  {
+    uint64_t head = consumer_.head;
+    if (consumer_.cached_tail - head < max_items) {
+      consumer_.cached_tail = tail_.load(std::memory_order_acquire);
+    }
+    uint64_t available = consumer_.cached_tail - head;
+    const size_t count = available < max_items ? available : max_items;
+    if (count == 0U) {
+      return 0U;
+    }
+    for (size_t i = 0; i < count; ++i) {
+      fn(slots_[(head + i) & mask_]);
+    }
+    consumer_.head = head + count;
+    head_.store(consumer_.head, std::memory_order_release);
+    return count;
+  }
+
+  /// Consumer-side emptiness check (refreshes the cached tail).
+  bool Empty()
+  {
+    consumer_.cached_tail = tail_.load(std::memory_order_acquire);
+    return consumer_.head == consumer_.cached_tail;
+  }
+
+private:
+  static constexpr size_t kCacheLine = 64U;
+
+  static size_t RoundUpToPowerOfTwo(size_t value)
+  {
+    size_t result = 1U;
+    while (result < value) {
+      result <<= 1U;
+    }
+    return result;
+  }
+
+  /// Producer-private state.
+  struct alignas(kCacheLine) ProducerState
+  {
+    uint64_t tail{0};
+    uint64_t cached_head{0};
+  };
+
+  /// Consumer-private state.
+  struct alignas(kCacheLine) ConsumerState
+  {
+    uint64_t head{0};
+    uint64_t cached_tail{0};
+  };
+
+  const size_t mask_;
+  T *const slots_;
+
+  alignas(kCacheLine) std::atomic<uint64_t> head_{0};
+  alignas(kCacheLine) std::atomic<uint64_t> tail_{0};
+  ProducerState producer_;
+  ConsumerState consumer_;
+};
+
+#endif // PROJECT_SPSC_RING_H_
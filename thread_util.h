@@ -0,0 +1,34 @@
+#ifndef PROJECT_THREAD_UTIL_H_
+#define PROJECT_THREAD_UTIL_H_
+
+#if defined(__linux__)
+#include <pthread.h>  // for pthread_setaffinity_np
+#include <sched.h>    // for cpu_set_t
+#endif
+
+/**
+ * @brief Pins the calling thread to @p core. No-op for negative cores or on
+ *        platforms without affinity support.
+ */
+inline void PinCurrentThread(int core)
+{
+  if (core < 0) return;
+#if defined(__linux__)
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  CPU_SET(core, &cpus);
+  pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+#endif
+}
+
+/**
+ * @brief Spin-wait hint for polling loops.
+ */
+inline void CpuRelax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#endif
+}
+
+#endif // PROJECT_THREAD_UTIL_H_
@@ -0,0 +1,187 @@
+#ifndef PROJECT_TOP_OF_BOOK_H_
+#define PROJECT_TOP_OF_BOOK_H_
+
+#include <atomic>  // for std::atomic, std::atomic_thread_fence
+#include <cstdint> // for uint32_t, uint64_t
+
+/**
+ * @brief Plain copy of a book's touch, as seen by readers.
+ *
+ * A price/qty of (0, 0) means that side is empty, matching
+ * OrderBook::BestBid/BestAsk.
+ */
+struct TopOfBook
+{
+  unsigned int bid_price{0};
+  unsigned int bid_qty{0};
+  unsigned int ask_price{0};
+  unsigned int ask_qty{0};
+  /// Even publication counter; increases by 2 per published change.
+  uint64_t version{0};
+};
+
+/// True if both touches have the same prices and quantities (the version
+/// is ignored).
+inline bool SameTouch(const TopOfBook &a, const TopOfBook &b)
+{
+  return a.bid_price == b.bid_price && a.bid_qty == b.bid_qty &&
+         a.ask_price == b.ask_price && a.ask_qty == b.ask_qty;
+}
+
+/**
+ * @class PublishedTopOfBook
+ *
+ * @brief Single-writer / multi-reader seqlock around one book's touch.
+ *
+ * The feed thread owning an OrderBook is the only writer (via
+ * OrderBook::SetPublishedTopOfBook); any number of threads may call
+ * Read/TryRead concurrently. The writer never blocks or waits on readers,
+ * and readers never write the line, so they only take a coherence miss when
+ * the touch actually changes. The whole object occupies one cache line.
+ *
+ * The payload fields are relaxed atomics so the seqlock is free of data
+ * races under the C++ memory model; on x86 they compile to plain moves.
+ */
+class alignas(64) PublishedTopOfBook
+{
+public:
+  /**
+   * @brief Publishes a new touch. Writer thread only.
+   *
+   * Unchanged values are skipped entirely so readers' copies of the line
+   * stay valid.
+   */
+  void Publish(unsigned int bid_price, unsigned int bid_qty,
+               unsigned int ask_price, unsigned int ask_qty)
+  {
+    if (bid_price_.load(std::memory_order_relaxed) == bid_price &&
+        bid_qty_.load(std::memory_order_relaxed) == bid_qty &&
+        ask_price_.load(std::memory_order_relaxed) == ask_price &&
+        ask_qty_.load(std::memory_order_relaxed) == ask_qty) {
+      return;
+    }
+
+    const uint64_t version = version_.load(std::memory_order_relaxed);
+    version_.store(version + 1U, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    bid_price_.store(bid_price, std::memory_order_relaxed);
+    bid_qty_.store(bid_qty, std::memory_order_relaxed);
+    ask_price_.store(ask_price, std::memory_order_relaxed);
+    ask_qty_.store(ask_qty, std::memory_order_relaxed);
+
+    version_.store(version + 2U, std::memory_order_release);
+  }
+
+  /**
+   * @brief Single read attempt.
+   *
+   * @return False if a write was in progress or raced the read; @p out is
+   *         then unspecified and the caller should retry.
+   */
+  bool TryRead(TopOfBook *out) const
+  {
+    const uint64_t before = version_.load(std::memory_order_acquire);
+    if ((before & 1U) != 0U) {
+      return false;
+    }
+
+    out->bid_price = bid_price_.load(std::memory_order_relaxed);
+    out->bid_qty = bid_qty_.load(std::memory_order_relaxed);
+    out->ask_price = ask_price_.load(std::memory_order_relaxed);
+    out->ask_qty = ask_qty_.load(std::memory_order_relaxed);
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const uint64_t after = version_.load(std::memory_order_relaxed);
+    out->version = before;
+    return before == after;
+  }
+
+  /**
+   * @brief Spins until a consistent copy is read.
+   */
+  TopOfBook Read() const
+  {
+    TopOfBook result;
+    while (!TryRead(&result)) {
+#if defined(__x86_64__) || defined(__i386__)
+      __builtin_ia32_pause();
+#endif
+    }
+    return result;
+  }
+
+  /// Current version; changes whenever the published touch changes.
+  uint64_t version() const { return version_.load(std::memory_order_acquire); }
+
+private:
+  std::atomic<uint64_t> version_{0};
+  std::atomic<unsigned int> bid_price_{0};
+  std::atomic<unsigned int> bid_qty_{0};
+  std::atomic<unsigned int> ask_price_{0};
+  std::atomic<unsigned int> ask_qty_{0};
+};
+
+static_assert(sizeof(PublishedTopOfBook) == 64,
+              "PublishedTopOfBook must occupy exactly one cache line");
+
+/**
+ * @class BookSeqlock
+ *
+ * @brief Single-writer version counter for readers of a whole book.
+ *
+ * Unlike PublishedTopOfBook, the protected data is not copied into the
+ * lock: the writer brackets every in-place update of the book with
+ * BeginWrite/EndWrite, and a reader runs its query against the live book
+ * and keeps the result only if the version was even and unchanged. The
+ * counter sits alone on its cache line so neighbouring books' versions do
+ * not share it; it works across processes when placed in shared memory.
+ */
+class alignas(64) BookSeqlock
+{
+public:
+  /// Writer: marks the book as being modified (version becomes odd).
+  void BeginWrite()
+  {
+    version_.store(version_.load(std::memory_order_relaxed) + 1U,
+                   std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+
+  /// Writer: publishes the modification (version becomes even again).
+  void EndWrite()
+  {
+    version_.store(version_.load(std::memory_order_relaxed) + 1U,
+                   std::memory_order_release);
+  }
+
+  /**
+   * @brief Runs @p fn once and reports whether it saw a consistent book.
+   *
+   * @p fn may observe a torn book and must tolerate it (the book's const
+   * queries do: they only walk bounded arrays); its result is meaningless
+   * when this returns false.
+   */
+  template <typename Fn>
+  bool TryRead(Fn &&fn) const
+  {
+    const uint64_t before = version_.load(std::memory_order_acquire);
+    if ((before & 1U) != 0U) {
+      return false;
+    }
+    fn();
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return version_.load(std::memory_order_relaxed) == before;
+  }
+
+  /// Current version: even when stable, +2 per completed update.
+  uint64_t version() const { return version_.load(std::memory_order_acquire); }
+
+private:
+  std::atomic<uint64_t> version_{0};
+};
+
+static_assert(sizeof(BookSeqlock) == 64,
+              "BookSeqlock must occupy exactly one cache line");
+
+#endif // PROJECT_TOP_OF_BOOK_H_
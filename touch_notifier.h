@@ -0,0 +1,160 @@
+#ifndef PROJECT_TOUCH_NOTIFIER_H_
+#define PROJECT_TOUCH_NOTIFIER_H_
+
+#include <cstddef> // for size_t
+#include <cstdint> // for uint8_t
+#include <utility> // for std::move
+#include <vector>  // for std::vector
+#include "book_registry.h"
+#include "book_worker.h"
+#include "compact_snapshot.h"
+#include "message_types.h"
+#include "top_of_book.h"
+
+/**
+ * @class TouchNotifier
+ *
+ * @brief Applies messages to a BookRegistry and calls
+ *        on_change(BookRegistry::MarketId, const TopOfBook&) only when a
+ *        book's touch (best bid/ask price or quantity) actually changed.
+ *
+ * The callback is a template parameter, so it is called directly and can be
+ * inlined. There is no std::function and no virtual call.
+ *
+ * In Mode::kImmediate every Dispatch compares the book's touch before and
+ * after the message. In Mode::kCoalesce, Dispatch only records the touch
+ * each market had when it was first hit in the batch. Flush then fires at
+ * most one notification per market, carrying the final touch, and only if it
+ * differs from the recorded one: a level that is pulled and restored within
+ * a batch produces no callback. Call Flush after each drain, e.g.
+ *
+ *   ring.Drain(batch, [&](const MessageSlot& s) { notifier.Dispatch(s); });
+ *   notifier.Flush();
+ *
+ * Sizing is fixed at construction (one entry per registry slot); Dispatch
+ * and Flush never allocate. Must run on the thread that owns the registry.
+ */
+template <typename OnChange>
+class TouchNotifier
+{
+public:
+  enum class Mode {
+    kImmediate = 0,
+    kCoalesce,
+  };
+
+  TouchNotifier(BookRegistry *registry, OnChange on_change,
+                Mode mode = Mode::kImmediate)
+      : registry_(registry),
+        on_change_(std::move(on_change)),
+        mode_(mode),
+        before_(mode == Mode::kCoalesce ? registry->capacity() : 0U),
+        pending_(mode == Mode::kCoalesce ? registry->capacity() : 0U, 0U)
+  {
+    dirty_.reserve(before_.size());
+  }
+
+  /**
+   * @brief Applies one slot exactly like BookWorker::Dispatch, then
+   *        notifies or records the change.
+   *
+   * @return False if the slot's market could not be resolved.
+   */
+  bool Dispatch(const MessageSlot &slot)
+  {
+    // Resolve the ticker once and dispatch by ID, so an unresolved slot
+    // costs a single hash lookup.
+    const BookRegistry::MarketId id = Resolve(slot);
+    if (id == BookRegistry::kInvalidMarketId) {
+      return slot.type == MessageType::kUnknown;  // Nothing to apply.
+    }
+    const TopOfBook before = mode_ == Mode::kImmediate || pending_[id] == 0U
+                                 ? registry_->book(id).Touch()
+                                 : TopOfBook{};
+
+    MessageSlot resolved = slot;
+    resolved.market_id = id;
+    if (!BookWorker::Dispatch(registry_, resolved)) {
+      return false;
+    }
+
+    if (mode_ == Mode::kImmediate) {
+      const TopOfBook after = registry_->book(id).Touch();
+      if (!SameTouch(before, after)) {
+        on_change_(id, after);
+      }
+    } else if (pending_[id] == 0U) {
+      pending_[id] = 1U;
+      before_[id] = before;
+      dirty_.push_back(id);
+    }
+    return true;
+  }
+
+  /**
+   * @brief Fires the coalesced notifications for every market touched since
+   *        the last Flush. No-op in Mode::kImmediate.
+   */
+  void Flush()
+  {
+    for (const BookRegistry::MarketId id : dirty_) {
+      pending_[id] = 0U;
+      const TopOfBook after = registry_->book(id).Touch();
+      if (!SameTouch(before_[id], after)) {
+        on_change_(id, after);
+      }
+    }
+    dirty_.clear();
+  }
+
+  /// Markets waiting for Flush.
+  size_t pending_count() const { return dirty_.size(); }
+
+private:
+  /// The slot's market ID, or a ticker lookup for unresolved slots
+  /// (kInvalidMarketId if unknown). Unresolved snapshots that parse intern
+  /// their market (and market_id alias) here, as BookWorker::Dispatch would.
+  BookRegistry::MarketId Resolve(const MessageSlot &slot)
+  {
+    if (slot.market_id != MessageSlot::kUnresolvedMarketId) {
+      return slot.market_id;
+    }
+    switch (slot.type) {
+      case MessageType::kDelta:
+        return registry_->FindByTicker(slot.delta.market_ticker_ptr,
+                                       slot.delta.market_ticker_len);
+      case MessageType::kTrade:
+        return registry_->FindByTicker(slot.trade.market_ticker_ptr,
+                                       slot.trade.market_ticker_len);
+      case MessageType::kSnapshot: {
+        const CompactSnapshotRef &snap = slot.snapshot;
+        CompactSnapshotView view;
+        if (!view.Parse(snap.data, snap.size)) {
+          return BookRegistry::kInvalidMarketId;
+        }
+        const BookRegistry::MarketId id =
+            registry_->Intern(snap.market_ticker_ptr, snap.market_ticker_len);
+        if (id != BookRegistry::kInvalidMarketId && snap.market_id_len > 0U) {
+          // Duplicates (the alias of a later snapshot) are ignored.
+          registry_->AddMarketIdAlias(id, snap.market_id_ptr,
+                                      snap.market_id_len);
+        }
+        return id;
+      }
+      default:
+        return BookRegistry::kInvalidMarketId;
+    }
+  }
+
+  BookRegistry *const registry_;
+  OnChange on_change_;
+  const Mode mode_;
+
+  /// Coalescing state: touch at first hit this batch, whether the market is
+  /// already in dirty_, and the markets to visit on Flush.
+  std::vector<TopOfBook> before_;
+  std::vector<uint8_t> pending_;
+  std::vector<BookRegistry::MarketId> dirty_;
+};
+
+#endif // PROJECT_TOUCH_NOTIFIER_H_
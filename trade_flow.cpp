@@ -0,0 +1,222 @@
+#include "trade_flow.h"
+
+#include <cstring>  // for std::memset
+
+namespace {
+
+/**
+ * @brief Sentinel low before the current bucket's first trade.
+ */
+constexpr unsigned int kNoLow = UINT32_MAX;
+
+}  // namespace
+
+// =============================================================================
+// TradeFlow Method Definitions
+// =============================================================================
+
+/**
+ * @brief Creates an empty aggregator.
+ *
+ * @param options Bucket width and window lengths; lengths are clamped to
+ *        [1, kMaxBuckets] and the list ends at the first 0.
+ */
+TradeFlow::TradeFlow(const Options& options)
+    : bucket_width_(options.bucket_width != 0U ? options.bucket_width : 1U),
+      window_count_(0U) {
+  std::memset(windows_, 0, sizeof(windows_));
+  std::memset(buckets_, 0, sizeof(buckets_));
+  std::memset(&opens_, 0, sizeof(opens_));
+  for (unsigned int i = 0; i < kMaxWindows && options.windows[i] != 0U; ++i) {
+    const uint32_t length = options.windows[i];
+    windows_[i].length = length > kMaxBuckets ? kMaxBuckets : length;
+    ++window_count_;
+  }
+  current_ = 0U;
+  started_ = false;
+  bucket_high_ = 0U;
+  bucket_low_ = kNoLow;
+  last_price_ = 0U;
+}
+
+/**
+ * @brief Bucket number of a timestamp (negative timestamps map to 0).
+ */
+uint32_t TradeFlow::BucketOf(int64_t ts) const {
+  return ts <= 0 ? 0U
+                 : static_cast<uint32_t>(static_cast<uint64_t>(ts) /
+                                         bucket_width_);
+}
+
+/**
+ * @brief Adds one trade to the current bucket and every window.
+ *
+ * @param trade A trade; count <= 0 only moves the clock, as ApplyTrade
+ *        ignores it.
+ */
+void TradeFlow::OnTrade(const TradeMessage& trade) {
+  const uint32_t bucket = BucketOf(trade.ts);
+  if (trade.count <= 0) {
+    Advance(trade.ts);
+    return;
+  }
+  if (!started_) {
+    started_ = true;
+    current_ = bucket;
+  } else if (bucket > current_) {
+    RollTo(bucket);
+  }
+
+  const uint64_t qty = static_cast<uint64_t>(trade.count);
+  const unsigned int price = trade.yes_price;
+  const uint64_t buy = trade.taker_side == Side::kYes ? qty : 0U;
+  const uint64_t sell = trade.taker_side == Side::kNo ? qty : 0U;
+  const uint64_t notional = qty * price;
+
+  Sums& sums = buckets_[current_ % kMaxBuckets];
+  if (sums.trades == 0U) {
+    opens_.push_back(Entry{current_, price});
+  }
+  const bool new_high = price > bucket_high_;
+  const bool new_low = price < bucket_low_;
+  bucket_high_ = new_high ? price : bucket_high_;
+  bucket_low_ = new_low ? price : bucket_low_;
+
+  static_assert(kMaxWindows == 4U, "targets lists every window");
+  Sums* const targets[kMaxWindows + 1] = {
+      &sums, &windows_[0].sums, &windows_[1].sums, &windows_[2].sums,
+      &windows_[3].sums};
+  for (unsigned int i = 0; i <= window_count_; ++i) {
+    Sums& s = *targets[i];
+    ++s.trades;
+    s.volume += qty;
+    s.buy_volume += buy;
+    s.sell_volume += sell;
+    s.notional += notional;
+  }
+
+  for (unsigned int i = 0; i < window_count_; ++i) {
+    WindowState& window = windows_[i];
+    if (new_high) {
+      while (!window.highs.empty() && window.highs.back().price <= price) {
+        window.highs.pop_back();
+      }
+      window.highs.push_back(Entry{current_, price});
+    }
+    if (new_low) {
+      while (!window.lows.empty() && window.lows.back().price >= price) {
+        window.lows.pop_back();
+      }
+      window.lows.push_back(Entry{current_, price});
+    }
+  }
+  last_price_ = price;
+}
+
+/**
+ * @brief Ages the windows to @p ts without a trade.
+ */
+void TradeFlow::Advance(int64_t ts) {
+  const uint32_t bucket = BucketOf(ts);
+  if (started_ && bucket > current_) {
+    RollTo(bucket);
+  }
+}
+
+/**
+ * @brief Moves to a later bucket: subtracts the buckets that leave each
+ *        window, clears the ring slots being reused, and expires queues.
+ *
+ * Each bucket leaves each window once, so the cost is amortized O(1) per
+ * bucket (and O(1) for a jump past the whole ring).
+ */
+void TradeFlow::RollTo(uint32_t bucket) {
+  const uint32_t steps = bucket - current_;
+  if (steps >= kMaxBuckets) {
+    std::memset(buckets_, 0, sizeof(buckets_));
+    for (unsigned int i = 0; i < window_count_; ++i) {
+      WindowState& window = windows_[i];
+      std::memset(&window.sums, 0, sizeof(window.sums));
+      window.highs.head = window.highs.tail;
+      window.lows.head = window.lows.tail;
+      window.open_pos = opens_.tail;
+    }
+    opens_.head = opens_.tail;
+  } else {
+    for (unsigned int i = 0; i < window_count_; ++i) {
+      WindowState& window = windows_[i];
+      // Buckets [current - length + 1, bucket - length] leave the window;
+      // those after current never entered it.
+      const int64_t first =
+          static_cast<int64_t>(current_) - window.length + 1;
+      const int64_t leaving = static_cast<int64_t>(bucket) - window.length;
+      const int64_t last =
+          leaving < current_ ? leaving : static_cast<int64_t>(current_);
+      for (int64_t b = first < 0 ? 0 : first; b <= last; ++b) {
+        const Sums& gone = buckets_[static_cast<uint64_t>(b) % kMaxBuckets];
+        window.sums.trades -= gone.trades;
+        window.sums.volume -= gone.volume;
+        window.sums.buy_volume -= gone.buy_volume;
+        window.sums.sell_volume -= gone.sell_volume;
+        window.sums.notional -= gone.notional;
+      }
+    }
+    for (uint32_t b = current_ + 1U; b <= bucket; ++b) {
+      std::memset(&buckets_[b % kMaxBuckets], 0, sizeof(Sums));
+    }
+  }
+
+  current_ = bucket;
+  bucket_high_ = 0U;
+  bucket_low_ = kNoLow;
+  for (unsigned int i = 0; i < window_count_; ++i) {
+    Expire(&windows_[i]);
+  }
+  const int64_t oldest = static_cast<int64_t>(current_) - kMaxBuckets + 1;
+  while (!opens_.empty() &&
+         static_cast<int64_t>(opens_.front().bucket) < oldest) {
+    opens_.pop_front();
+  }
+}
+
+/**
+ * @brief Drops high/low candidates and opens older than the window.
+ */
+void TradeFlow::Expire(WindowState* window) {
+  const int64_t start = static_cast<int64_t>(current_) - window->length + 1;
+  while (!window->highs.empty() &&
+         static_cast<int64_t>(window->highs.front().bucket) < start) {
+    window->highs.pop_front();
+  }
+  while (!window->lows.empty() &&
+         static_cast<int64_t>(window->lows.front().bucket) < start) {
+    window->lows.pop_front();
+  }
+  while (window->open_pos != opens_.tail &&
+         static_cast<int64_t>(
+             opens_.entries[window->open_pos % kMaxBuckets].bucket) < start) {
+    ++window->open_pos;
+  }
+}
+
+/**
+ * @brief Current aggregates of one window.
+ *
+ * @param index Configured window, < window_count().
+ */
+TradeBar TradeFlow::Window(unsigned int index) const {
+  const WindowState& window = windows_[index];
+  TradeBar bar;
+  bar.trades = window.sums.trades;
+  bar.volume = window.sums.volume;
+  bar.buy_volume = window.sums.buy_volume;
+  bar.sell_volume = window.sums.sell_volume;
+  bar.notional = window.sums.notional;
+  if (bar.trades != 0U) {
+    bar.open = opens_.entries[window.open_pos % kMaxBuckets].price;
+    bar.high = window.highs.front().price;
+    bar.low = window.lows.front().price;
+    bar.close = last_price_;
+  }
+  return bar;
+}
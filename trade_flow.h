@@ -0,0 +1,161 @@
+#ifndef PROJECT_TRADE_FLOW_H_
+#define PROJECT_TRADE_FLOW_H_
+
+#include <cstddef> // for size_t
+#include <cstdint> // for int64_t, uint32_t, uint64_t
+#include "message_types.h"
+
+/**
+ * @brief Trade statistics over one rolling window. Prices are YES prices;
+ *        open/high/low/close are 0 when the window holds no trades.
+ */
+struct TradeBar
+{
+  uint32_t trades{0};
+  /// Contracts traded, and the part taken by YES / NO takers.
+  uint64_t volume{0};
+  uint64_t buy_volume{0};
+  uint64_t sell_volume{0};
+  /// Sum of yes_price * count.
+  uint64_t notional{0};
+  unsigned int open{0};
+  unsigned int high{0};
+  unsigned int low{0};
+  unsigned int close{0};
+
+  /// Volume-weighted average YES price (0 without trades).
+  double vwap() const
+  {
+    return volume != 0U ? static_cast<double>(notional) /
+                              static_cast<double>(volume)
+                        : 0.0;
+  }
+  /// Signed taker flow: YES-taker volume minus NO-taker volume.
+  int64_t imbalance() const
+  {
+    return static_cast<int64_t>(buy_volume) - static_cast<int64_t>(sell_volume);
+  }
+};
+
+/**
+ * @class TradeFlow
+ *
+ * @brief Rolling OHLCV and taker-flow aggregates for one market, fed by
+ *        every trade.
+ *
+ * Trades are grouped into time buckets of Options::bucket_width ts units,
+ * kept in a fixed ring of kMaxBuckets. Each configured window covers the
+ * newest N buckets, including the current one. Its sums are maintained by
+ * adding each trade and subtracting buckets as they leave the window. High
+ * and low come from a monotonic queue per window, and the open from a FIFO
+ * of each bucket's first trade. OnTrade and Advance are therefore O(1)
+ * amortized, Window() is O(1), and nothing allocates after construction.
+ *
+ * Time only moves forward: a trade older than the current bucket is
+ * counted in the current bucket. Call Advance to age the windows when no
+ * trades arrive.
+ */
+class TradeFlow
+{
+public:
+  static constexpr unsigned int kMaxBuckets = 64;
+  static constexpr unsigned int kMaxWindows = 4;
+
+  struct Options
+  {
+    /// Bucket length in TradeMessage::ts units (> 0).
+    uint32_t bucket_width = 1;
+    /// Window lengths in buckets, each in [1, kMaxBuckets]; 0 ends the
+    /// list.
+    uint32_t windows[kMaxWindows] = {1, 5, 15, 60};
+  };
+
+  TradeFlow() : TradeFlow(Options()) {}
+  explicit TradeFlow(const Options &options);
+
+  /// Folds one trade into the current bucket (rolling forward first).
+  void OnTrade(const TradeMessage &trade);
+
+  /// Rolls the windows forward to the bucket containing @p ts.
+  void Advance(int64_t ts);
+
+  /// Aggregates of configured window @p index (< window_count()).
+  TradeBar Window(unsigned int index) const;
+
+  unsigned int window_count() const { return window_count_; }
+  /// Length of window @p index in buckets.
+  uint32_t window_length(unsigned int index) const
+  {
+    return windows_[index].length;
+  }
+
+private:
+  /// Additive part of one bucket.
+  struct Sums
+  {
+    uint32_t trades;
+    uint64_t volume;
+    uint64_t buy_volume;
+    uint64_t sell_volume;
+    uint64_t notional;
+  };
+
+  struct Entry
+  {
+    uint32_t bucket;
+    unsigned int price;
+  };
+
+  /// Bounded deque of Entry over a kMaxBuckets ring (head/tail counters).
+  struct Queue
+  {
+    Entry entries[kMaxBuckets];
+    uint32_t head;
+    uint32_t tail;
+
+    bool empty() const { return head == tail; }
+    Entry &front() { return entries[head % kMaxBuckets]; }
+    const Entry &front() const { return entries[head % kMaxBuckets]; }
+    Entry &back() { return entries[(tail - 1U) % kMaxBuckets]; }
+    void push_back(Entry e) { entries[tail++ % kMaxBuckets] = e; }
+    void pop_front() { ++head; }
+    void pop_back() { --tail; }
+  };
+
+  struct WindowState
+  {
+    uint32_t length;
+    Sums sums;
+    /// Per-bucket high (decreasing) and low (increasing) candidates.
+    Queue highs;
+    Queue lows;
+    /// First FIFO position (into opens_) that lies inside the window.
+    uint32_t open_pos;
+  };
+
+  /// Moves the current bucket to @p bucket, expiring what falls out.
+  void RollTo(uint32_t bucket);
+  /// Drops entries of @p window that are older than its first bucket.
+  void Expire(WindowState *window);
+  uint32_t BucketOf(int64_t ts) const;
+
+  uint32_t bucket_width_;
+  unsigned int window_count_;
+  WindowState windows_[kMaxWindows];
+
+  /// Sums per bucket, indexed by bucket % kMaxBuckets.
+  Sums buckets_[kMaxBuckets];
+  /// Current bucket number, and whether any trade has been seen.
+  uint32_t current_;
+  bool started_;
+  /// High/low of the current bucket, to push queue entries only when they
+  /// change (keeps one entry per bucket).
+  unsigned int bucket_high_;
+  unsigned int bucket_low_;
+  /// Last traded price (the close of every window that has trades).
+  unsigned int last_price_;
+  /// First trade of each non-empty bucket, oldest first.
+  Queue opens_;
+};
+
+#endif // PROJECT_TRADE_FLOW_H_
@@ -0,0 +1,240 @@
+#include "websocket.h"
+
+#include <cstring>  // for std::memcpy
+
+namespace {
+
+constexpr char kWsGuid[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+constexpr size_t kMaxControlPayload = 125;
+
+constexpr char kBase64[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/**
+ * @brief Standard padded base64 of @p len bytes; writes 4 * ceil(len / 3).
+ */
+void Base64(const uint8_t* in, size_t len, char* out) {
+  size_t o = 0;
+  for (size_t i = 0; i < len; i += 3U) {
+    const uint32_t b0 = in[i];
+    const uint32_t b1 = i + 1U < len ? in[i + 1U] : 0U;
+    const uint32_t b2 = i + 2U < len ? in[i + 2U] : 0U;
+    const uint32_t triple = (b0 << 16U) | (b1 << 8U) | b2;
+    out[o++] = kBase64[(triple >> 18U) & 0x3FU];
+    out[o++] = kBase64[(triple >> 12U) & 0x3FU];
+    out[o++] = i + 1U < len ? kBase64[(triple >> 6U) & 0x3FU] : '=';
+    out[o++] = i + 2U < len ? kBase64[triple & 0x3FU] : '=';
+  }
+}
+
+inline uint32_t Rotl(uint32_t x, unsigned int n) {
+  return (x << n) | (x >> (32U - n));
+}
+
+/**
+ * @brief SHA-1 (FIPS 180-1). Only used for the handshake accept key, which
+ *        is a protocol check, not a security property.
+ */
+void Sha1(const uint8_t* data, size_t len, uint8_t digest[20]) {
+  uint32_t h[5] = {0x67452301U, 0xEFCDAB89U, 0x98BADCFEU, 0x10325476U,
+                   0xC3D2E1F0U};
+  // Key + GUID is 60 bytes: at most two blocks after padding.
+  uint8_t message[128] = {};
+  const size_t blocks = (len + 8U) / 64U + 1U;
+  if (blocks > 2U) return;
+  std::memcpy(message, data, len);
+  message[len] = 0x80U;
+  const uint64_t bits = static_cast<uint64_t>(len) * 8U;
+  for (unsigned int i = 0; i < 8U; ++i) {
+    message[blocks * 64U - 1U - i] = static_cast<uint8_t>(bits >> (8U * i));
+  }
+
+  for (size_t block = 0; block < blocks; ++block) {
+    const uint8_t* chunk = message + block * 64U;
+    uint32_t w[80];
+    for (unsigned int i = 0; i < 16U; ++i) {
+      w[i] = (static_cast<uint32_t>(chunk[4U * i]) << 24U) |
+             (static_cast<uint32_t>(chunk[4U * i + 1U]) << 16U) |
+             (static_cast<uint32_t>(chunk[4U * i + 2U]) << 8U) |
+             static_cast<uint32_t>(chunk[4U * i + 3U]);
+    }
+    for (unsigned int i = 16U; i < 80U; ++i) {
+      w[i] = Rotl(w[i - 3U] ^ w[i - 8U] ^ w[i - 14U] ^ w[i - 16U], 1U);
+    }
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+    for (unsigned int i = 0; i < 80U; ++i) {
+      uint32_t f, k;
+      if (i < 20U) {
+        f = (b & c) | (~b & d);
+        k = 0x5A827999U;
+      } else if (i < 40U) {
+        f = b ^ c ^ d;
+        k = 0x6ED9EBA1U;
+      } else if (i < 60U) {
+        f = (b & c) | (b & d) | (c & d);
+        k = 0x8F1BBCDCU;
+      } else {
+        f = b ^ c ^ d;
+        k = 0xCA62C1D6U;
+      }
+      const uint32_t temp = Rotl(a, 5U) + f + e + k + w[i];
+      e = d;
+      d = c;
+      c = Rotl(b, 30U);
+      b = a;
+      a = temp;
+    }
+    h[0] += a;
+    h[1] += b;
+    h[2] += c;
+    h[3] += d;
+    h[4] += e;
+  }
+  for (unsigned int i = 0; i < 5U; ++i) {
+    digest[4U * i] = static_cast<uint8_t>(h[i] >> 24U);
+    digest[4U * i + 1U] = static_cast<uint8_t>(h[i] >> 16U);
+    digest[4U * i + 2U] = static_cast<uint8_t>(h[i] >> 8U);
+    digest[4U * i + 3U] = static_cast<uint8_t>(h[i]);
+  }
+}
+
+/**
+ * @brief XORs @p len bytes with the rotating 4-byte mask, 8 bytes at a
+ *        time.
+ */
+void ApplyMask(char* data, size_t len, const uint8_t mask[4]) {
+  uint64_t mask8;
+  uint8_t repeated[8];
+  for (unsigned int i = 0; i < 8U; ++i) repeated[i] = mask[i & 3U];
+  std::memcpy(&mask8, repeated, sizeof(mask8));
+  size_t i = 0;
+  for (; i + 8U <= len; i += 8U) {
+    uint64_t word;
+    std::memcpy(&word, data + i, sizeof(word));
+    word ^= mask8;
+    std::memcpy(data + i, &word, sizeof(word));
+  }
+  for (; i < len; ++i) {
+    data[i] = static_cast<char>(data[i] ^ mask[i & 3U]);
+  }
+}
+
+}  // namespace
+
+// =============================================================================
+// Public API
+// =============================================================================
+
+/**
+ * @brief Parses one frame header and locates its payload.
+ *
+ * @param data Start of the frame in the receive buffer.
+ * @param len Bytes available from @p data.
+ * @param max_payload Largest payload accepted.
+ * @param frame Output; written only for kFrame.
+ */
+WsParseResult ParseWsFrame(char* data, size_t len, size_t max_payload,
+                           WsFrame* frame) {
+  if (len < 2U) return WsParseResult::kIncomplete;
+  const uint8_t b0 = static_cast<uint8_t>(data[0]);
+  const uint8_t b1 = static_cast<uint8_t>(data[1]);
+  const uint8_t opcode = b0 & 0x0FU;
+  const bool fin = (b0 & 0x80U) != 0U;
+  const bool masked = (b1 & 0x80U) != 0U;
+  if ((b0 & 0x70U) != 0U) return WsParseResult::kError;
+  const bool control = (opcode & 0x08U) != 0U;
+  if (opcode > 0x2U && opcode != 0x8U && opcode != 0x9U && opcode != 0xAU) {
+    return WsParseResult::kError;
+  }
+
+  size_t header = 2U;
+  uint64_t payload_len = b1 & 0x7FU;
+  if (payload_len == 126U) {
+    if (len < 4U) return WsParseResult::kIncomplete;
+    payload_len = (static_cast<uint64_t>(static_cast<uint8_t>(data[2])) << 8U) |
+                  static_cast<uint8_t>(data[3]);
+    header = 4U;
+  } else if (payload_len == 127U) {
+    if (len < 10U) return WsParseResult::kIncomplete;
+    payload_len = 0U;
+    for (unsigned int i = 0; i < 8U; ++i) {
+      payload_len = (payload_len << 8U) | static_cast<uint8_t>(data[2U + i]);
+    }
+    header = 10U;
+  }
+  if (control && (!fin || payload_len > kMaxControlPayload)) {
+    return WsParseResult::kError;
+  }
+  if (payload_len > max_payload) return WsParseResult::kError;
+  const size_t mask_offset = header;
+  if (masked) header += 4U;
+  if (len < header || len - header < payload_len) {
+    return WsParseResult::kIncomplete;
+  }
+
+  char* payload = data + header;
+  if (masked) {
+    uint8_t mask[4];
+    std::memcpy(mask, data + mask_offset, sizeof(mask));
+    ApplyMask(payload, static_cast<size_t>(payload_len), mask);
+  }
+  frame->opcode = static_cast<WsOpcode>(opcode);
+  frame->fin = fin;
+  frame->payload = payload;
+  frame->payload_len = static_cast<size_t>(payload_len);
+  frame->frame_len = header + static_cast<size_t>(payload_len);
+  return WsParseResult::kFrame;
+}
+
+/**
+ * @brief Encodes a final client frame; clients must mask every frame.
+ */
+size_t EncodeWsFrame(WsOpcode opcode, const char* payload, size_t payload_len,
+                     uint32_t mask_key, char* out, size_t out_cap) {
+  size_t header = 2U;
+  if (payload_len >= 126U) header = payload_len <= 0xFFFFU ? 4U : 10U;
+  header += 4U;
+  if (out_cap < header || out_cap - header < payload_len) return 0U;
+
+  out[0] = static_cast<char>(0x80U | static_cast<uint8_t>(opcode));
+  if (payload_len < 126U) {
+    out[1] = static_cast<char>(0x80U | payload_len);
+  } else if (payload_len <= 0xFFFFU) {
+    out[1] = static_cast<char>(0x80U | 126U);
+    out[2] = static_cast<char>(payload_len >> 8U);
+    out[3] = static_cast<char>(payload_len);
+  } else {
+    out[1] = static_cast<char>(0x80U | 127U);
+    for (unsigned int i = 0; i < 8U; ++i) {
+      out[2U + i] =
+          static_cast<char>(static_cast<uint64_t>(payload_len) >> (56U - 8U * i));
+    }
+  }
+  uint8_t mask[4];
+  std::memcpy(mask, &mask_key, sizeof(mask));
+  std::memcpy(out + header - 4U, mask, sizeof(mask));
+  std::memcpy(out + header, payload, payload_len);
+  ApplyMask(out + header, payload_len, mask);
+  return header + payload_len;
+}
+
+/**
+ * @brief Encodes a handshake nonce as a Sec-WebSocket-Key.
+ */
+void WsEncodeKey(const uint8_t nonce[16], char key[kWsKeyLen]) {
+  Base64(nonce, 16U, key);
+}
+
+/**
+ * @brief Computes the Sec-WebSocket-Accept value for @p key.
+ */
+void WsAcceptKey(const char* key, size_t key_len, char accept[kWsAcceptLen]) {
+  uint8_t input[64];
+  const size_t guid_len = sizeof(kWsGuid) - 1U;
+  if (key_len > sizeof(input) - guid_len) key_len = sizeof(input) - guid_len;
+  std::memcpy(input, key, key_len);
+  std::memcpy(input + key_len, kWsGuid, guid_len);
+  uint8_t digest[20];
+  Sha1(input, key_len + guid_len, digest);
+  Base64(digest, sizeof(digest), accept);
+}
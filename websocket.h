@@ -0,0 +1,80 @@
+#ifndef PROJECT_WEBSOCKET_H_
+#define PROJECT_WEBSOCKET_H_
+
+#include <cstddef> // for size_t
+#include <cstdint> // for uint8_t, uint32_t
+
+// ---------------------------------------------------------------------------
+// RFC 6455 framing
+// ---------------------------------------------------------------------------
+//
+// Just enough of the protocol for a feed client: frames are parsed in place
+// in the receive buffer (masked payloads are unmasked in place), client
+// frames are encoded masked, and the opening handshake's accept key can be
+// computed and checked. Extensions (permessage-deflate) are not supported.
+
+enum class WsOpcode : uint8_t {
+  kContinuation = 0x0,
+  kText = 0x1,
+  kBinary = 0x2,
+  kClose = 0x8,
+  kPing = 0x9,
+  kPong = 0xA,
+};
+
+/**
+ * @brief One parsed frame; payload points into the parsed buffer.
+ */
+struct WsFrame
+{
+  WsOpcode opcode;
+  bool fin;
+  char *payload;
+  size_t payload_len;
+  /// Header plus payload: where the next frame starts.
+  size_t frame_len;
+};
+
+enum class WsParseResult {
+  kFrame = 0,
+  /// Need more bytes; nothing was modified.
+  kIncomplete,
+  /// Reserved bits or opcode, an oversized or fragmented control frame,
+  /// or a payload larger than max_payload.
+  kError,
+};
+
+/**
+ * @brief Parses the frame at @p data. A masked payload is unmasked in
+ *        place, so a frame must be parsed only once.
+ */
+WsParseResult ParseWsFrame(char *data, size_t len, size_t max_payload,
+                           WsFrame *frame);
+
+/// Largest header EncodeWsFrame writes.
+static constexpr size_t kMaxWsHeaderBytes = 14;
+
+/**
+ * @brief Writes one final, masked client frame (header + masked payload).
+ *
+ * @return Bytes written, or 0 if @p out_cap is too small.
+ */
+size_t EncodeWsFrame(WsOpcode opcode, const char *payload, size_t payload_len,
+                     uint32_t mask_key, char *out, size_t out_cap);
+
+/// Length of a Sec-WebSocket-Key or Sec-WebSocket-Accept value.
+static constexpr size_t kWsKeyLen = 24;
+static constexpr size_t kWsAcceptLen = 28;
+
+/**
+ * @brief Base64 of 16 nonce bytes: a Sec-WebSocket-Key value.
+ */
+void WsEncodeKey(const uint8_t nonce[16], char key[kWsKeyLen]);
+
+/**
+ * @brief base64(SHA-1(key + GUID)): the Sec-WebSocket-Accept value the
+ *        server must return for @p key.
+ */
+void WsAcceptKey(const char *key, size_t key_len, char accept[kWsAcceptLen]);
+
+#endif // PROJECT_WEBSOCKET_H_